@@ -1,7 +1,14 @@
 #pragma once
 
+#include <cinttypes>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <vector>
+
 #include "motis/core/common/flat_matrix.h"
 
+#include "utl/parallel_for.h"
 #include "utl/verify.h"
 
 namespace motis {
@@ -12,9 +19,9 @@ void floyd_warshall(flat_matrix<T>& mat) {
                   "floyd_warshall: input is not a square matrix.");
   constexpr uint64_t const kMaxDistance = std::numeric_limits<T>::max();
 
-  for (auto k = 0UL; k < mat.column_count_; ++k) {
-    for (auto i = 0UL; i < mat.column_count_; ++i) {
-      for (auto j = 0UL; j < mat.column_count_; ++j) {
+  for (auto k = std::size_t{0U}; k < mat.column_count_; ++k) {
+    for (auto i = std::size_t{0U}; i < mat.column_count_; ++i) {
+      for (auto j = std::size_t{0U}; j < mat.column_count_; ++j) {
         auto const distance = static_cast<T>(
             std::min(kMaxDistance, static_cast<uint64_t>(mat(i, k)) +
                                        static_cast<uint64_t>(mat(k, j))));
@@ -26,14 +33,14 @@ void floyd_warshall(flat_matrix<T>& mat) {
   }
 }
 
-void floyd_warshall(flat_matrix<motis::time>& mat) {
+inline void floyd_warshall(flat_matrix<motis::time>& mat) {
   utl::new_verify(mat.entries_.size() == mat.column_count_ * mat.column_count_,
                   "floyd_warshall: input is not a square matrix.");
   constexpr uint64_t const kMaxDistance = std::numeric_limits<int32_t>::max();
 
-  for (auto k = 0UL; k < mat.column_count_; ++k) {
-    for (auto i = 0UL; i < mat.column_count_; ++i) {
-      for (auto j = 0UL; j < mat.column_count_; ++j) {
+  for (auto k = std::size_t{0U}; k < mat.column_count_; ++k) {
+    for (auto i = std::size_t{0U}; i < mat.column_count_; ++i) {
+      for (auto j = std::size_t{0U}; j < mat.column_count_; ++j) {
         auto const distance = static_cast<motis::time>(
             std::min(kMaxDistance, static_cast<uint64_t>(mat(i, k).ts()) +
                                        static_cast<uint64_t>(mat(k, j).ts())));
@@ -45,4 +52,100 @@ void floyd_warshall(flat_matrix<motis::time>& mat) {
   }
 }
 
+// Unreachable entries for floyd_warshall_blocked: the sum of two of them
+// still fits into uint32_t, so the relaxation needs no saturation.
+constexpr auto const kFloydWarshallInfinity =
+    std::numeric_limits<uint32_t>::max() / 2U;
+
+constexpr auto const kFloydWarshallBlockSize = std::size_t{64U};
+
+// Column count a matrix for floyd_warshall_blocked has to be padded to.
+// Padding rows/columns are initialized with kFloydWarshallInfinity.
+inline std::size_t floyd_warshall_padded_size(std::size_t const n) {
+  auto const round_up = [&](std::size_t const m) {
+    return (n + m - 1U) / m * m;
+  };
+  return n <= kFloydWarshallBlockSize ? round_up(8U)
+                                      : round_up(kFloydWarshallBlockSize);
+}
+
+namespace detail {
+
+// Relaxes block (bi, bj) over all intermediate nodes of block bk.
+inline void floyd_warshall_block(uint32_t* const d, std::size_t const stride,
+                                 std::size_t const block, std::size_t const bi,
+                                 std::size_t const bj, std::size_t const bk) {
+  for (auto k = bk * block; k < (bk + 1U) * block; ++k) {
+    auto const* const row_k = d + k * stride + bj * block;
+    for (auto i = bi * block; i < (bi + 1U) * block; ++i) {
+      auto const d_ik = d[i * stride + k];
+      if (d_ik == kFloydWarshallInfinity) {
+        continue;
+      }
+
+      // branch free: compiled to packed min instructions
+      auto* const row_i = d + i * stride + bj * block;
+      for (auto j = std::size_t{0U}; j < block; ++j) {
+        row_i[j] = std::min(row_i[j], d_ik + row_k[j]);
+      }
+    }
+  }
+}
+
+}  // namespace detail
+
+// Cache tiled Floyd-Warshall: for every diagonal block k, first the block
+// (k, k) itself, then row and column k, then all remaining blocks are
+// relaxed. Blocks within the last two phases are independent and are
+// distributed over threads if `parallel` is set.
+inline void floyd_warshall_blocked(flat_matrix<uint32_t>& mat,
+                                   bool const parallel = false) {
+  utl::new_verify(mat.entries_.size() == mat.column_count_ * mat.column_count_,
+                  "floyd_warshall_blocked: input is not a square matrix.");
+
+  auto const stride = mat.column_count_;
+  if (stride == 0U) {
+    return;
+  }
+
+  auto const block = std::min(kFloydWarshallBlockSize, stride);
+  utl::new_verify(stride % block == 0U,
+                  "floyd_warshall_blocked: matrix is not padded.");
+
+  auto const block_count = stride / block;
+  auto* const d = mat.entries_.data();
+  auto const run = [&](std::vector<std::size_t> const& blocks, auto&& fn) {
+    if (parallel && blocks.size() > 1U) {
+      utl::parallel_for(blocks, fn,
+                        utl::parallel_error_strategy::CONTINUE_EXEC);
+    } else {
+      std::for_each(begin(blocks), end(blocks), fn);
+    }
+  };
+
+  std::vector<std::size_t> others;
+  others.reserve(block_count);
+  for (auto bk = std::size_t{0U}; bk < block_count; ++bk) {
+    others.clear();
+    for (auto b = std::size_t{0U}; b < block_count; ++b) {
+      if (b != bk) {
+        others.emplace_back(b);
+      }
+    }
+
+    detail::floyd_warshall_block(d, stride, block, bk, bk, bk);
+
+    run(others, [&](std::size_t const b) {
+      detail::floyd_warshall_block(d, stride, block, bk, b, bk);
+      detail::floyd_warshall_block(d, stride, block, b, bk, bk);
+    });
+
+    run(others, [&](std::size_t const bi) {
+      for (auto const bj : others) {
+        detail::floyd_warshall_block(d, stride, block, bi, bj, bk);
+      }
+    });
+  }
+}
+
 }  // namespace motis
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace motis {
+
+// Thread safe key value cache holding at most max_size entries.
+// When full, the least recently used entry is evicted first. Values are
+// returned by copy: use cheap to copy values (e.g. shared_ptr) to keep
+// evicted values alive while they are still in use.
+template <typename K, typename V>
+struct lru_cache {
+  using key = K;
+  using value = V;
+
+  explicit lru_cache(std::size_t const max_size) : max_size_{max_size} {}
+
+  std::optional<V> get(K const& k) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto const it = entries_.find(k);
+    if (it == end(entries_)) {
+      return std::nullopt;
+    }
+    lru_.splice(begin(lru_), lru_, it->second.lru_pos_);
+    return it->second.value_;
+  }
+
+  // Returns the cached value: if the key is already present (e.g. inserted
+  // concurrently), the existing value wins and v is discarded.
+  V put(K const& k, V v) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (auto const it = entries_.find(k); it != end(entries_)) {
+      lru_.splice(begin(lru_), lru_, it->second.lru_pos_);
+      return it->second.value_;
+    }
+    if (max_size_ == 0U) {
+      return v;
+    }
+    while (entries_.size() >= max_size_) {
+      entries_.erase(lru_.back());
+      lru_.pop_back();
+    }
+    lru_.emplace_front(k);
+    entries_.emplace(k, entry{v, begin(lru_)});
+    return v;
+  }
+
+  std::size_t size() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return entries_.size();
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    entries_.clear();
+    lru_.clear();
+  }
+
+private:
+  struct entry {
+    V value_;
+    typename std::list<K>::iterator lru_pos_;
+  };
+
+  std::size_t max_size_;
+  std::mutex mutex_;
+  std::list<K> lru_;  // front = most recently used
+  std::map<K, entry> entries_;
+};
+
+}  // namespace motis
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace motis {
+
+// Immutable, atomically replaceable value.
+// Readers grab a reference counted snapshot once and keep working on it
+// while a writer prepares the next version and publishes it with a single
+// pointer swap. Old versions are freed when the last reader releases them.
+template <typename T>
+struct snapshot {
+  std::shared_ptr<T const> get() const { return std::atomic_load(&current_); }
+
+  void publish(std::shared_ptr<T const> next) {
+    std::atomic_store(&current_, std::move(next));
+  }
+
+private:
+  std::shared_ptr<T const> current_{std::make_shared<T const>()};
+};
+
+}  // namespace motis
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace motis {
+
+// Traffic days of a connection, re-based to the days the loaded schedule
+// actually uses: bit i is schedule day first_day_ + i. Days outside of
+// [first_day_, first_day_ + day_count_) never have traffic.
+// Up to 64 days (the usual case for a loaded interval of a few days) the
+// pattern is the inline word bits_. Otherwise words_ points to
+// (day_count_ + 63) / 64 words in schedule::compact_bitfield_words_.
+struct compact_bitfield {
+  bool test(std::size_t const day) const {
+    auto const rel = day - first_day_;  // wraps around for day < first_day_
+    if (rel >= day_count_) {
+      return false;
+    }
+    auto const word = words_ == nullptr ? bits_ : words_[rel / 64U];
+    return ((word >> (rel % 64U)) & 1U) != 0U;
+  }
+
+  // true if any day of [from, to] has traffic
+  bool any(std::size_t from, std::size_t to) const {
+    if (from < first_day_) {
+      from = first_day_;
+    }
+    if (to >= static_cast<std::size_t>(first_day_) + day_count_) {
+      to = static_cast<std::size_t>(first_day_) + day_count_ - 1U;
+    }
+    if (day_count_ == 0U || from > to) {
+      return false;
+    }
+
+    if (words_ == nullptr) {
+      auto const count = to - from + 1U;
+      auto const mask =
+          count == 64U ? ~uint64_t{0U} : (uint64_t{1U} << count) - 1U;
+      return ((bits_ >> (from - first_day_)) & mask) != 0U;
+    }
+
+    for (auto day = from; day <= to; ++day) {
+      if (test(day)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  uint64_t bits_{0U};
+  uint64_t const* words_{nullptr};
+  uint16_t first_day_{0U}, day_count_{0U};
+};
+
+}  // namespace motis
@@ -6,6 +6,7 @@
 
 #include "motis/core/common/hash_helper.h"
 #include "motis/core/schedule/attribute.h"
+#include "motis/core/schedule/compact_bitfield.h"
 #include "motis/core/schedule/event_type.h"
 #include "motis/core/schedule/provider.h"
 #include "motis/core/schedule/time.h"
@@ -153,7 +154,7 @@ struct light_connection {
   connection const* full_con_;
   union {
     size_t bitfield_idx_;
-    loader::bitfield const* traffic_days_;
+    compact_bitfield const* traffic_days_;
   };
   int16_t d_time_;
   int16_t a_time_;
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <functional>
+#include <memory>
 #include <queue>
 #include <vector>
 
@@ -20,7 +22,38 @@ struct simple_edge {
   uint16_t cost_;
 };
 
-using constant_graph = std::vector<std::vector<simple_edge>>;
+// Adjacency lists. Rows are reference counted and copied on write: a copy
+// of the graph (the next version of the lower bound graphs) shares all rows
+// with the original until they are modified through mutable_row().
+// Copies are only made by one thread at a time (the real time update).
+struct constant_graph {
+  using row = std::vector<simple_edge>;
+
+  constant_graph() = default;
+  explicit constant_graph(std::size_t const size) { resize(size); }
+
+  std::size_t size() const { return rows_.size(); }
+
+  row const& operator[](std::size_t const i) const { return *rows_[i]; }
+
+  row& mutable_row(std::size_t const i) {
+    auto& r = rows_[i];
+    if (r.use_count() != 1) {
+      r = std::make_shared<row>(*r);
+    }
+    return *r;
+  }
+
+  void resize(std::size_t const size) { rows_.resize(size, empty_row()); }
+
+private:
+  static std::shared_ptr<row> const& empty_row() {
+    static auto const empty = std::make_shared<row>();
+    return empty;
+  }
+
+  std::vector<std::shared_ptr<row>> rows_;
+};
 
 //=============================================================================
 // STATION GRAPH
@@ -29,47 +62,65 @@ struct map_station_graph_node {
   uint32_t operator()(node const* n) const { return n->get_station()->id_; }
 };
 
-inline constant_graph build_station_graph(
-    std::vector<station_node_ptr> const& station_nodes, search_dir const dir) {
-  constant_graph g(station_nodes.size());
+inline void add_station_graph_edges(constant_graph& g, station_node const& sn,
+                                    search_dir const dir) {
+  // Stores the minimum distance to each neighboring station.
+  std::unordered_map<uint32_t /* neighbor station node id */, uint32_t> min;
 
-  auto add_edges = [&g, dir](station_node const& sn) {
-    // Stores the minimum distance to each neighboring station.
-    std::unordered_map<uint32_t /* neighbor station node id */, uint32_t> min;
-
-    auto update_min = [&min](uint32_t const from, edge_cost const& ec) {
-      if (!ec.is_valid()) {
-        return;
-      }
+  auto update_min = [&min](uint32_t const from, edge_cost const& ec) {
+    if (!ec.is_valid()) {
+      return;
+    }
 
-      auto const it = min.find(from);
-      if (it == end(min) || ec.time_ < it->second) {
-        min[from] = ec.time_.ts();
-      }
-    };
+    auto const it = min.find(from);
+    if (it == end(min) || ec.time_ < it->second) {
+      min[from] = ec.time_.ts();
+    }
+  };
 
-    for (auto const& inner_station_edge : sn.edges_) {
-      for (auto const& e : inner_station_edge.to_->edges_) {
-        if (e.to_->get_station() != &sn) {
-          update_min(e.to_->get_station()->id_, e.get_minimum_cost());
-        }
+  for (auto const& inner_station_edge : sn.edges_) {
+    for (auto const& e : inner_station_edge.to_->edges_) {
+      if (e.to_->get_station() != &sn) {
+        update_min(e.to_->get_station()->id_, e.get_minimum_cost());
       }
     }
+  }
 
-    for (const auto& e : min) {
-      auto const s = (dir == search_dir::FWD) ? e.first : sn.id_;
-      auto const t = (dir == search_dir::FWD) ? sn.id_ : e.first;
-      g[s].emplace_back(t, e.second);
-    }
-  };
+  for (const auto& e : min) {
+    auto const s = (dir == search_dir::FWD) ? e.first : sn.id_;
+    auto const t = (dir == search_dir::FWD) ? sn.id_ : e.first;
+    g.mutable_row(s).emplace_back(t, e.second);
+  }
+}
 
+inline constant_graph build_station_graph(
+    std::vector<station_node_ptr> const& station_nodes, search_dir const dir) {
+  constant_graph g(station_nodes.size());
   for (auto const& station_node : station_nodes) {
-    add_edges(*station_node);
+    add_station_graph_edges(g, *station_node, dir);
   }
-
   return g;
 }
 
+// Recomputes the edges contributed by the given station node (i.e. its
+// outgoing connections) in both station graphs. The backward graph stores
+// them at the station itself, which yields the neighbors whose adjacency
+// lists in the forward graph have to be cleaned up.
+inline void update_station_graph_edges(constant_graph& fwd, constant_graph& bwd,
+                                       station_node const& sn) {
+  for (auto const& e : bwd[sn.id_]) {
+    auto& neighbor_edges = fwd.mutable_row(e.to_);
+    neighbor_edges.erase(
+        std::remove_if(begin(neighbor_edges), end(neighbor_edges),
+                       [&](simple_edge const& ne) { return ne.to_ == sn.id_; }),
+        end(neighbor_edges));
+  }
+  bwd.mutable_row(sn.id_).clear();
+
+  add_station_graph_edges(fwd, sn, search_dir::FWD);
+  add_station_graph_edges(bwd, sn, search_dir::BWD);
+}
+
 //=============================================================================
 // INTERCHANGE GRAPH
 //-----------------------------------------------------------------------------
@@ -90,59 +141,113 @@ inline bool is_connected(node const* from, node const* to) {
                       }) != end(from->edges_);
 }
 
+inline void add_interchange_graph_edge(constant_graph& g, uint32_t const from,
+                                      uint32_t const to, bool const is_transfer,
+                                      search_dir const dir) {
+  auto const s = (dir == search_dir::FWD) ? to : from;
+  auto const t = (dir == search_dir::FWD) ? from : to;
+  if (std::find_if(begin(g[s]), end(g[s]), [&t](simple_edge const& e) {
+        return e.to_ == t;
+      }) == end(g[s])) {
+    g.mutable_row(s).emplace_back(t, is_transfer);
+  }
+}
+
+inline void add_interchange_graph_route_edges(constant_graph& g,
+                                              station_node const* sn,
+                                              uint32_t const route_offset,
+                                              search_dir const dir) {
+  for (auto const& e : sn->edges_) {
+    if (!e.to_->is_route_node()) {
+      continue;
+    }
+
+    auto const route_lb_node_id = e.to_->route_ + route_offset;
+
+    if (is_connected(sn, e.to_)) {
+      add_interchange_graph_edge(g, sn->id_, route_lb_node_id, false, dir);
+    }
+
+    if (is_connected(e.to_, sn)) {
+      add_interchange_graph_edge(g, route_lb_node_id, sn->id_, true, dir);
+    }
+  }
+}
+
 inline constant_graph build_interchange_graph(
     std::vector<station_node_ptr> const& station_nodes, unsigned route_count,
     search_dir const dir) {
   auto const route_offset = static_cast<uint32_t>(station_nodes.size());
   constant_graph g(route_offset + route_count);
 
-  auto is_new = [&g, dir](uint32_t from, uint32_t to) {
-    auto const s = (dir == search_dir::FWD) ? to : from;
-    auto const t = (dir == search_dir::FWD) ? from : to;
-    return std::find_if(begin(g[s]), end(g[s]), [&t](simple_edge const& e) {
-             return e.to_ == t;
-           }) == end(g[s]);
-  };
-
-  auto add_edge = [&g, is_new, dir](uint32_t from, uint32_t to,
-                                    bool is_transfer) {
-    if (is_new(from, to)) {
-      auto const s = (dir == search_dir::FWD) ? to : from;
-      auto const t = (dir == search_dir::FWD) ? from : to;
-      g[s].emplace_back(t, is_transfer);
-    }
-  };
-
-  auto add_station_edges = [&g, route_offset,
-                            add_edge](station_node const* sn) {
+  for (auto const& sn : station_nodes) {
     for (auto const& e : sn->edges_) {
       if (e.to_->is_foot_node()) {
         for (auto const& fe : e.to_->edges_) {
           if (fe.to_->is_station_node()) {
-            g[fe.to_->id_].emplace_back(sn->id_, false);
+            g.mutable_row(fe.to_->id_).emplace_back(sn->id_, false);
           }
         }
-      } else if (e.to_->is_route_node()) {
-        auto const route_lb_node_id = e.to_->route_ + route_offset;
-
-        if (is_connected(sn, e.to_)) {
-          add_edge(sn->id_, route_lb_node_id, false);
-        }
-
-        if (is_connected(e.to_, sn)) {
-          add_edge(route_lb_node_id, sn->id_, true);
-        }
       }
     }
-  };
-
-  for (auto const& sn : station_nodes) {
-    add_station_edges(sn.get());
+    add_interchange_graph_route_edges(g, sn.get(), route_offset, dir);
   }
 
   return g;
 }
 
+//=============================================================================
+// LOWER BOUND GRAPHS
+//-----------------------------------------------------------------------------
+struct lower_bound_graphs {
+  constant_graph travel_time_fwd_, travel_time_bwd_;
+  constant_graph transfers_fwd_, transfers_bwd_;
+
+  // Incremented every time the graphs are rebuilt (i.e. after real time
+  // updates). Allows caching data derived from a specific version.
+  uint64_t version_{0U};
+};
+
+inline std::shared_ptr<lower_bound_graphs const> build_lower_bound_graphs(
+    std::vector<station_node_ptr> const& station_nodes, unsigned route_count,
+    uint64_t const version) {
+  auto g = std::make_shared<lower_bound_graphs>();
+  g->travel_time_fwd_ = build_station_graph(station_nodes, search_dir::FWD);
+  g->travel_time_bwd_ = build_station_graph(station_nodes, search_dir::BWD);
+  g->transfers_fwd_ =
+      build_interchange_graph(station_nodes, route_count, search_dir::FWD);
+  g->transfers_bwd_ =
+      build_interchange_graph(station_nodes, route_count, search_dir::BWD);
+  g->version_ = version;
+  return g;
+}
+
+// Updates a copy of the previous graphs for the given station nodes only
+// (the copy shares all rows that are not modified, see constant_graph).
+// Station graph edges of these stations are recomputed exactly. The
+// interchange graphs only receive new edges (e.g. for routes created by
+// real time updates): edges that became obsolete remain, which keeps the
+// lower bounds admissible.
+inline std::shared_ptr<lower_bound_graphs const> update_lower_bound_graphs(
+    lower_bound_graphs const& prev,
+    std::vector<station_node_ptr> const& station_nodes, unsigned route_count,
+    std::vector<uint32_t> const& touched_stations, uint64_t const version) {
+  auto g = std::make_shared<lower_bound_graphs>(prev);
+  auto const route_offset = static_cast<uint32_t>(station_nodes.size());
+  g->transfers_fwd_.resize(route_offset + route_count);
+  g->transfers_bwd_.resize(route_offset + route_count);
+  for (auto const station_id : touched_stations) {
+    auto const sn = station_nodes.at(station_id).get();
+    update_station_graph_edges(g->travel_time_fwd_, g->travel_time_bwd_, *sn);
+    add_interchange_graph_route_edges(g->transfers_fwd_, sn, route_offset,
+                                      search_dir::FWD);
+    add_interchange_graph_route_edges(g->transfers_bwd_, sn, route_offset,
+                                      search_dir::BWD);
+  }
+  g->version_ = version;
+  return g;
+}
+
 //=============================================================================
 // DIJKSTRA
 //-----------------------------------------------------------------------------
@@ -180,10 +285,33 @@ public:
     pq_.push(label(goal, 0));
   }
 
+  // Uses distances computed by an earlier run for the same goal and graph
+  // (run() is a no-op).
+  constant_graph_dijkstra(
+      constant_graph const& g,
+      std::shared_ptr<std::vector<dist_t> const> precomputed,
+      hash_map<int, std::vector<simple_edge>> const& additional_edges,
+      MapNodeFn map_node = MapNodeFn())
+      : graph_(g),
+        precomputed_(std::move(precomputed)),
+        additional_edges_(additional_edges),
+        map_node_(std::forward<MapNodeFn>(map_node)) {}
+
   inline dist_t operator[](node const* n) const {
     auto const idx = map_node_(n);
-    assert(idx < dists_.size());
-    return dists_[idx];
+    auto const& dists = precomputed_ != nullptr ? *precomputed_ : dists_;
+    // Routes added by real time updates after the graph snapshot was built
+    // are unknown: zero is always a valid lower bound.
+    return idx < dists.size() ? dists[idx] : 0U;
+  }
+
+  // Hands out the distances after run() without copying them.
+  std::shared_ptr<std::vector<dist_t> const> share() {
+    if (precomputed_ == nullptr) {
+      precomputed_ =
+          std::make_shared<std::vector<dist_t> const>(std::move(dists_));
+    }
+    return precomputed_;
   }
 
   void run() {
@@ -214,9 +342,10 @@ public:
 
   inline bool is_reachable(dist_t val) { return val != UNREACHABLE; }
 
-  std::vector<std::vector<simple_edge>> const& graph_;
+  constant_graph const& graph_;
   dial<label, MaxValue, get_bucket> pq_;
   std::vector<dist_t> dists_;
+  std::shared_ptr<std::vector<dist_t> const> precomputed_;
   hash_map<int, std::vector<simple_edge>> const& additional_edges_;
   MapNodeFn map_node_;
 };
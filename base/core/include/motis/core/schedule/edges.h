@@ -7,6 +7,7 @@
 #include "motis/core/common/logging.h"
 
 #include "motis/core/schedule/connection.h"
+#include "motis/core/schedule/search_dir.h"
 #include "motis/core/schedule/time.h"
 
 #include <algorithm>
@@ -47,8 +48,6 @@ struct edge_cost {
 
 const edge_cost NO_EDGE = edge_cost();
 
-enum class search_dir { FWD, BWD };
-
 class edge {
 public:
   enum type {
@@ -292,10 +291,8 @@ public:
       has_traffic = false;
       if (m_.route_edge_.traffic_days_ != nullptr) {
         auto const last_day = (start_time + MAX_TRAVEL_TIME_MINUTES).day();
-        for (int day_idx = start_time.day(); day_idx <= last_day; ++day_idx) {
-          has_traffic |= m_.route_edge_.traffic_days_->test(
-              day_idx);  // warum nicht abbrdechen wenn has_traffic = true
-        }
+        has_traffic =
+            m_.route_edge_.traffic_days_->any(start_time.day(), last_day);
         if (!has_traffic) {
           return {nullptr, 0};
         }
@@ -554,7 +551,7 @@ public:
       array<light_connection> conns_;
       union {
         size_t bitfield_idx_;
-        loader::bitfield const* traffic_days_;
+        compact_bitfield const* traffic_days_;
       };
 
       void init_empty() {
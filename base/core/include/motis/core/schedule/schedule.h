@@ -5,9 +5,11 @@
 #include "motis/core/common/fws_multimap.h"
 #include "motis/core/common/hash_map.h"
 #include "motis/core/common/hash_set.h"
+#include "motis/core/common/snapshot.h"
 
 #include "motis/core/schedule/attribute.h"
 #include "motis/core/schedule/category.h"
+#include "motis/core/schedule/compact_bitfield.h"
 #include "motis/core/schedule/constant_graph.h"
 #include "motis/core/schedule/delay_info.h"
 #include "motis/core/schedule/event.h"
@@ -54,10 +56,9 @@ struct schedule {
   std::map<std::string, station*> ds100_to_station_;
   std::map<std::string, int> classes_;
   // std::vector<std::string> tracks_;
-  constant_graph travel_time_lower_bounds_fwd_;
-  constant_graph travel_time_lower_bounds_bwd_;
-  constant_graph transfers_lower_bounds_fwd_;
-  constant_graph transfers_lower_bounds_bwd_;
+  // Replaced as a whole after real time updates, queries keep the version
+  // they started with.
+  snapshot<lower_bound_graphs> lower_bounds_;
   unsigned node_count_;
   unsigned route_count_;
   std::vector<station_node_ptr> station_nodes_;
@@ -72,7 +73,11 @@ struct schedule {
   std::vector<std::unique_ptr<provider>> providers_;
   std::vector<std::unique_ptr<std::string>> directions_;
   std::vector<std::unique_ptr<timezone>> timezones_;
-  std::vector<loader::bitfield> bitfields_;
+  std::vector<loader::bitfield> bitfields_;  // graph building only
+
+  // deduplicated traffic days of all light connections and route edges
+  std::vector<compact_bitfield> compact_bitfields_;
+  std::vector<uint64_t> compact_bitfield_words_;  // for windows > 64 days
 
   std::vector<std::pair<primary_trip_id, trip*>> trips_;
   std::vector<std::unique_ptr<trip>> trip_mem_;
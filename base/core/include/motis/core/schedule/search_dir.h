@@ -0,0 +1,7 @@
+#pragma once
+
+namespace motis {
+
+enum class search_dir { FWD, BWD };
+
+}  // namespace motis
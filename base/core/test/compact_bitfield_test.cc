@@ -0,0 +1,48 @@
+#include "gtest/gtest.h"
+
+#include "motis/core/schedule/compact_bitfield.h"
+
+using namespace motis;
+
+TEST(core_compact_bitfield, inline_word) {
+  compact_bitfield bf;
+  bf.first_day_ = 5;
+  bf.day_count_ = 64;
+  bf.bits_ = uint64_t{1U} | (uint64_t{1U} << 3U) | (uint64_t{1U} << 63U);
+
+  EXPECT_FALSE(bf.test(0));
+  EXPECT_FALSE(bf.test(4));
+  EXPECT_TRUE(bf.test(5));
+  EXPECT_FALSE(bf.test(6));
+  EXPECT_TRUE(bf.test(8));
+  EXPECT_TRUE(bf.test(68));
+  EXPECT_FALSE(bf.test(69));
+
+  EXPECT_TRUE(bf.any(0, 5));
+  EXPECT_FALSE(bf.any(0, 4));
+  EXPECT_FALSE(bf.any(6, 7));
+  EXPECT_TRUE(bf.any(6, 8));
+  EXPECT_TRUE(bf.any(9, 500));
+  EXPECT_FALSE(bf.any(69, 500));
+  EXPECT_TRUE(bf.any(0, 500));
+}
+
+TEST(core_compact_bitfield, words) {
+  uint64_t const words[] = {0U, uint64_t{1U} << 4U};
+  compact_bitfield bf;
+  bf.first_day_ = 10;
+  bf.day_count_ = 70;
+  bf.words_ = words;
+
+  EXPECT_TRUE(bf.test(10 + 64 + 4));
+  EXPECT_FALSE(bf.test(10 + 64 + 3));
+  EXPECT_FALSE(bf.test(10));
+  EXPECT_TRUE(bf.any(0, 100));
+  EXPECT_FALSE(bf.any(0, 77));
+}
+
+TEST(core_compact_bitfield, empty) {
+  compact_bitfield const bf;
+  EXPECT_FALSE(bf.test(0));
+  EXPECT_FALSE(bf.any(0, 511));
+}
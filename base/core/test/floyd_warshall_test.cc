@@ -0,0 +1,57 @@
+#include "gtest/gtest.h"
+
+#include <random>
+
+#include "motis/core/common/floyd_warshall.h"
+
+using namespace motis;
+
+namespace {
+
+flat_matrix<uint32_t> random_graph(std::size_t const n,
+                                   std::size_t const stride,
+                                   unsigned const seed) {
+  std::mt19937 gen{seed};
+  std::uniform_int_distribution<uint32_t> duration{1U, 30U};
+  std::bernoulli_distribution has_edge{0.05};
+
+  auto mat = make_flat_matrix<uint32_t>(stride, kFloydWarshallInfinity);
+  for (auto i = std::size_t{0U}; i < n; ++i) {
+    for (auto j = std::size_t{0U}; j < n; ++j) {
+      if (i != j && has_edge(gen)) {
+        mat(i, j) = duration(gen);
+      }
+    }
+  }
+  return mat;
+}
+
+void check_blocked(std::size_t const n, bool const parallel) {
+  auto const stride = floyd_warshall_padded_size(n);
+  ASSERT_GE(stride, n);
+
+  auto expected = random_graph(n, stride, static_cast<unsigned>(n));
+  auto actual = expected;
+
+  floyd_warshall(expected);
+  floyd_warshall_blocked(actual, parallel);
+
+  EXPECT_EQ(expected.entries_, actual.entries_);
+}
+
+}  // namespace
+
+TEST(core_floyd_warshall, padded_size) {
+  EXPECT_EQ(0U, floyd_warshall_padded_size(0U));
+  EXPECT_EQ(8U, floyd_warshall_padded_size(3U));
+  EXPECT_EQ(64U, floyd_warshall_padded_size(64U));
+  EXPECT_EQ(128U, floyd_warshall_padded_size(65U));
+}
+
+TEST(core_floyd_warshall, blocked_single_block) { check_blocked(13U, false); }
+
+TEST(core_floyd_warshall, blocked_multiple_blocks) {
+  check_blocked(200U, false);
+}
+
+TEST(core_floyd_warshall, blocked_parallel) { check_blocked(300U, true); }
@@ -0,0 +1,71 @@
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <string>
+
+#include "motis/core/common/lru_cache.h"
+
+using namespace motis;
+
+TEST(core_lru_cache, get_put) {
+  lru_cache<int, std::string> cache{2};
+  EXPECT_FALSE(cache.get(1).has_value());
+
+  EXPECT_EQ("a", cache.put(1, "a"));
+  ASSERT_TRUE(cache.get(1).has_value());
+  EXPECT_EQ("a", *cache.get(1));
+  EXPECT_EQ(1U, cache.size());
+}
+
+TEST(core_lru_cache, existing_value_wins) {
+  lru_cache<int, std::string> cache{2};
+  cache.put(1, "a");
+  EXPECT_EQ("a", cache.put(1, "b"));
+  EXPECT_EQ("a", *cache.get(1));
+  EXPECT_EQ(1U, cache.size());
+}
+
+TEST(core_lru_cache, evict_least_recently_used) {
+  lru_cache<int, std::string> cache{2};
+  cache.put(1, "a");
+  cache.put(2, "b");
+  ASSERT_TRUE(cache.get(1).has_value());  // 2 is now least recently used
+
+  cache.put(3, "c");
+  EXPECT_EQ(2U, cache.size());
+  EXPECT_TRUE(cache.get(1).has_value());
+  EXPECT_FALSE(cache.get(2).has_value());
+  EXPECT_TRUE(cache.get(3).has_value());
+
+  cache.put(1, "x");  // refreshes 1, 3 is evicted next
+  cache.put(4, "d");
+  EXPECT_EQ("a", *cache.get(1));
+  EXPECT_FALSE(cache.get(3).has_value());
+  EXPECT_TRUE(cache.get(4).has_value());
+}
+
+TEST(core_lru_cache, zero_size) {
+  lru_cache<int, std::string> cache{0};
+  EXPECT_EQ("a", cache.put(1, "a"));
+  EXPECT_FALSE(cache.get(1).has_value());
+  EXPECT_EQ(0U, cache.size());
+}
+
+TEST(core_lru_cache, clear) {
+  lru_cache<int, std::string> cache{2};
+  cache.put(1, "a");
+  cache.put(2, "b");
+  cache.clear();
+  EXPECT_EQ(0U, cache.size());
+  EXPECT_FALSE(cache.get(1).has_value());
+  cache.put(3, "c");
+  EXPECT_EQ(1U, cache.size());
+}
+
+TEST(core_lru_cache, evicted_value_stays_alive) {
+  lru_cache<int, std::shared_ptr<int const>> cache{1};
+  auto const v = cache.put(1, std::make_shared<int const>(42));
+  cache.put(2, std::make_shared<int const>(7));
+  EXPECT_FALSE(cache.get(1).has_value());
+  EXPECT_EQ(42, *v);
+}
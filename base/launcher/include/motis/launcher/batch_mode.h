@@ -9,9 +9,19 @@
 namespace motis {
 namespace launcher {
 
+struct batch_settings {
+  enum class output_format { JSON, BINARY };
+
+  std::string input_file_path_;
+  std::string output_file_path_;
+  output_format output_format_{output_format::JSON};
+
+  // CSV (id, target, ms) of the per query latencies, empty = off
+  std::string latency_file_path_;
+};
+
 void inject_queries(boost::asio::io_service&, motis::module::receiver&,
-                    std::string const& input_file_path,
-                    std::string const& output_file_path, int num_threads);
+                    batch_settings const&, int num_threads);
 
 }  // namespace launcher
 }  // namespace motis
@@ -14,13 +14,16 @@ public:
   enum class motis_mode_t { BATCH, SERVER, TEST };
 
   launcher_settings(motis_mode_t m, std::string batch_input_file,
-                    std::string batch_output_file, int num_threads);
+                    std::string batch_output_file,
+                    std::string batch_output_format,
+                    std::string batch_latency_file, int num_threads);
 
   boost::program_options::options_description desc() override;
   void print(std::ostream& out) const override;
 
   motis_mode_t mode_;
   std::string batch_input_file_, batch_output_file_;
+  std::string batch_output_format_, batch_latency_file_;
   int num_threads_;
 };
 
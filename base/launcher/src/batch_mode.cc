@@ -1,15 +1,25 @@
 #include "motis/launcher/batch_mode.h"
 
-#include "motis/module/message.h"
-
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <fstream>
 #include <functional>
+#include <iomanip>
+#include <iostream>
 #include <istream>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
-#include "utl/erase.h"
+#include "motis/core/common/logging.h"
+#include "motis/module/message.h"
 
 using namespace motis::module;
 namespace p = std::placeholders;
@@ -17,19 +27,103 @@ namespace p = std::placeholders;
 namespace motis {
 namespace launcher {
 
+constexpr auto const kOutputBufferSize = 4U * 1024U * 1024U;
+
+// Multi producer / multi consumer queue, push() blocks while capacity
+// elements are queued. pop() returns false as soon as the queue is closed
+// and empty.
+template <typename T>
+struct batch_queue {
+  explicit batch_queue(std::size_t const capacity) : capacity_(capacity) {}
+
+  void push(T el) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    not_full_.wait(lock, [&]() { return q_.size() < capacity_ || closed_; });
+    q_.emplace_back(std::move(el));
+    not_empty_.notify_one();
+  }
+
+  // Never blocks: returns false if no element is ready.
+  bool try_pop(T& el) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (q_.empty()) {
+      return false;
+    }
+    el = std::move(q_.front());
+    q_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+
+  bool pop(T& el) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    not_empty_.wait(lock, [&]() { return !q_.empty() || closed_; });
+    if (q_.empty()) {
+      return false;
+    }
+    el = std::move(q_.front());
+    q_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    closed_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+private:
+  std::size_t capacity_;
+  bool closed_{false};
+  std::mutex mutex_;
+  std::condition_variable not_empty_, not_full_;
+  std::deque<T> q_;
+};
+
+// Queries are parsed by a reader thread and responses are serialized and
+// written (in large chunks) by a writer thread. The io_service only
+// injects queries that are already parsed and hands the responses over to
+// the unbounded results queue: it never waits for one of the helper
+// threads. At most 2 * num_threads queries are in flight.
 struct query_injector : std::enable_shared_from_this<query_injector> {
 public:
+  using clock = std::chrono::steady_clock;
+
+  struct query {
+    msg_ptr msg_;
+    std::error_code ec_;
+  };
+
+  struct result {
+    int id_{0};
+    std::string target_;
+    double ms_{0.0};
+    msg_ptr res_;
+    std::error_code ec_;
+  };
+
   query_injector(boost::asio::io_service& ios,
                  motis::module::receiver& receiver,
-                 std::string const& input_file_path,
-                 std::string const& output_file_path, int num_threads)
+                 batch_settings const& settings, int num_threads)
       : ios_(ios),
         receiver_(receiver),
-        in_(input_file_path),
-        out_(output_file_path),
-        num_threads_(num_threads) {
-    in_.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        settings_(settings),
+        in_(settings.input_file_path_),
+        out_(settings.output_file_path_, std::ios_base::binary),
+        max_in_flight_(2 * num_threads),
+        queries_(64U * static_cast<std::size_t>(num_threads)),
+        results_(std::numeric_limits<std::size_t>::max()) {
+    if (!in_.is_open()) {
+      throw std::runtime_error("cannot open batch input file");
+    }
+    in_.exceptions(std::ifstream::badbit);
     out_.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    if (!settings.latency_file_path_.empty()) {
+      latency_out_.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+      latency_out_.open(settings.latency_file_path_);
+    }
   }
 
   query_injector(query_injector const&) = delete;
@@ -38,88 +132,194 @@ public:
   query_injector(query_injector&&) = delete;
   query_injector& operator=(query_injector&&) = delete;
 
-  ~query_injector() { ios_.stop(); }
+  ~query_injector() {
+    queries_.close();
+    results_.close();
+    for (auto* t : {&reader_, &writer_}) {
+      if (t->joinable()) {
+        t->join();
+      }
+    }
+    ios_.stop();
+  }
 
   void start() {
-    auto self = shared_from_this();
-    ios_.post([this, self]() {
-      for (int i = 0; i < 2 * num_threads_; ++i) {
-        if (!inject_msg(self)) {
-          break;
-        }
-      }
-    });
+    writer_ = std::thread{[this]() { write_results(); }};
+    reader_ = std::thread{[this, self = shared_from_this()]() mutable {
+      read_queries(self);
+      // The last reference must not be released on the reader thread
+      // (the destructor joins it).
+      ios_.post([self = std::move(self)]() { self->inject_ready(self); });
+    }};
   }
 
 private:
-  msg_ptr next_query() {
-    if (in_.eof() || in_.peek() == EOF) {
-      return nullptr;
+  void read_queries(std::shared_ptr<query_injector> const& self) {
+    try {
+      std::string json;
+      while (std::getline(in_, json)) {
+        if (json.empty()) {
+          continue;
+        }
+        try {
+          queries_.push(query{make_msg(json), {}});
+        } catch (std::system_error const& e) {
+          queries_.push(query{nullptr, e.code()});
+        }
+        ios_.post([self]() { self->inject_ready(self); });
+      }
+    } catch (std::exception const& e) {
+      LOG(logging::error) << "batch: read error: " << e.what();
     }
+    queries_.close();
+  }
 
-    std::string json;
-    std::getline(in_, json);
-    return make_msg(json);
+  // Dispatches parsed queries while less than max_in_flight_ are running.
+  void inject_ready(std::shared_ptr<query_injector> const& self) {
+    std::vector<query> ready;
+    {
+      std::lock_guard<std::mutex> lock{in_flight_mutex_};
+      query next;
+      while (in_flight_ < max_in_flight_ && queries_.try_pop(next)) {
+        ++in_flight_;
+        ready.emplace_back(std::move(next));
+      }
+    }
+    for (auto const& q : ready) {
+      inject_msg(self, q);
+    }
   }
 
-  bool inject_msg(std::shared_ptr<query_injector> const&) {
-    msg_ptr next;
+  void inject_msg(std::shared_ptr<query_injector> const& self,
+                  query const& next) {
+    auto const start = clock::now();
+    if (!next.msg_) {
+      on_response(self, -1, "", start, msg_ptr(), next.ec_);
+      return;
+    }
+
     try {
-      next = next_query();
-      if (next) {
-        receiver_.on_msg(next, ios_.wrap(std::bind(&query_injector::on_response,
-                                                   this, shared_from_this(),
-                                                   next->id(), p::_1, p::_2)));
-      } else {
-        return false;
-      }
+      receiver_.on_msg(
+          next.msg_,
+          ios_.wrap(std::bind(&query_injector::on_response, this, self,
+                              next.msg_->id(),
+                              next.msg_->get()->destination()->target()->str(),
+                              start, p::_1, p::_2)));
     } catch (std::system_error const& e) {
-      on_response(shared_from_this(), next ? next->id() : -1, msg_ptr(),
-                  e.code());
+      on_response(self, next.msg_->id(), "", start, msg_ptr(), e.code());
     }
-    return true;
   }
 
   void on_response(std::shared_ptr<query_injector> const& self, int id,
+                   std::string const& target, clock::time_point start,
                    msg_ptr const& res, std::error_code ec) {
-    write_response(id, res, ec);
-    inject_msg(self);
+    auto const ms =
+        std::chrono::duration<double, std::milli>(clock::now() - start);
+    results_.push(result{id, target, ms.count(), res, ec});
+    {
+      std::lock_guard<std::mutex> lock{in_flight_mutex_};
+      --in_flight_;
+    }
+    inject_ready(self);
   }
 
-  void write_response(int id, msg_ptr const& res, std::error_code ec) {
-    msg_ptr response;
+  void write_results() {
+    std::string buf;
+    buf.reserve(kOutputBufferSize);
+
+    std::vector<double> latencies;
+    if (latency_out_.is_open()) {
+      latency_out_ << "id,target,ms\n";
+    }
+
+    result r;
+    while (results_.pop(r)) {
+      serialize(r, buf);
+      if (buf.size() >= kOutputBufferSize) {
+        out_.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        buf.clear();
+      }
 
-    if (ec) {
-      response = make_error_msg(ec);
-    } else if (res) {
-      response = res;
+      latencies.emplace_back(r.ms_);
+      if (latency_out_.is_open()) {
+        latency_out_ << r.id_ << "," << r.target_ << "," << std::fixed
+                     << std::setprecision(3) << r.ms_ << "\n";
+      }
+    }
+
+    out_.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    out_.flush();
+    print_summary(latencies);
+  }
+
+  void serialize(result const& r, std::string& buf) const {
+    msg_ptr response;
+    if (r.ec_) {
+      response = make_error_msg(r.ec_);
+    } else if (r.res_) {
+      response = r.res_;
     } else {
       response = make_success_msg();
     }
-    response->get()->mutate_id(id);
+    response->get()->mutate_id(r.id_);
+
+    switch (settings_.output_format_) {
+      case batch_settings::output_format::BINARY: {
+        // little endian 32bit size prefix + flatbuffer
+        auto const size = static_cast<uint32_t>(response->size());
+        for (auto i = 0U; i < 4U; ++i) {
+          buf.push_back(static_cast<char>((size >> (8U * i)) & 0xFFU));
+        }
+        buf.append(reinterpret_cast<char const*>(response->data()),
+                   response->size());
+        break;
+      }
+      case batch_settings::output_format::JSON:
+        buf.append(response->to_json(true));
+        buf.push_back('\n');
+        break;
+    }
+  }
 
-    auto json = response->to_json(true);
-    // utl::erase(json, '\n');
+  static void print_summary(std::vector<double>& latencies) {
+    if (latencies.empty()) {
+      return;
+    }
 
-    out_ << json << "\n";
-    out_.flush();
+    std::sort(begin(latencies), end(latencies));
+    auto const percentile = [&](double const q) {
+      auto const idx = static_cast<std::size_t>(q * latencies.size());
+      return latencies[std::min(idx, latencies.size() - 1)];
+    };
+    std::cout << "\nbatch: " << latencies.size() << " queries, latency [ms]"
+              << std::fixed << std::setprecision(1)
+              << ": p50=" << percentile(0.5) << " p90=" << percentile(0.9)
+              << " p99=" << percentile(0.99) << " max=" << latencies.back()
+              << "\n";
   }
 
   boost::asio::io_service& ios_;
   motis::module::receiver& receiver_;
 
+  batch_settings settings_;
+
   std::ifstream in_;
   std::ofstream out_;
+  std::ofstream latency_out_;
+
+  int max_in_flight_;
+  int in_flight_{0};
+  std::mutex in_flight_mutex_;
 
-  int num_threads_;
+  batch_queue<query> queries_;
+  batch_queue<result> results_;
+  std::thread reader_, writer_;
 };
 
 void inject_queries(boost::asio::io_service& ios,
                     motis::module::receiver& receiver,
-                    std::string const& input_file_path,
-                    std::string const& output_file_path, int num_threads) {
-  std::make_shared<query_injector>(ios, receiver, input_file_path,
-                                   output_file_path, num_threads)
+                    batch_settings const& settings, int num_threads) {
+  std::make_shared<query_injector>(ios, receiver, settings, num_threads)
       ->start();
 }
 
@@ -1,10 +1,21 @@
 #include "motis/launcher/http_server.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <functional>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <system_error>
 
 #include "boost/algorithm/string/predicate.hpp"
 
+#include "zlib.h"
+#include "zstd.hpp"
+
 #include "utl/to_vec.h"
 
 #include "net/http/server/query_router.hpp"
@@ -35,6 +46,82 @@ HTTPMethod translate_method_string(std::string const& s) {
   return HTTPMethod_GET;
 }
 
+constexpr auto const kMinCompressSize = 1024U;
+
+enum class content_encoding { IDENTITY, GZIP, ZSTD };
+
+// Negotiated from the Accept / Accept-Encoding headers of the request.
+struct response_format {
+  bool flatbuffers_{false};
+  content_encoding encoding_{content_encoding::IDENTITY};
+};
+
+// Quality value (0-1) of a content coding in an Accept-Encoding header.
+// An explicit entry takes precedence over "*". Codings that are not listed
+// are not acceptable (q=0).
+double accept_encoding_q(std::string_view header, char const* coding) {
+  auto const trim = [](std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+      s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+      s.remove_suffix(1);
+    }
+    return s;
+  };
+
+  auto wildcard_q = 0.0;
+  while (!header.empty()) {
+    auto const entry_end = std::min(header.find(','), header.size());
+    auto entry = header.substr(0, entry_end);
+    header.remove_prefix(std::min(entry_end + 1, header.size()));
+
+    auto const params = std::min(entry.find(';'), entry.size());
+    auto const name = trim(entry.substr(0, params));
+    auto q = 1.0;
+    entry.remove_prefix(params);
+    while (!entry.empty()) {
+      entry.remove_prefix(1);  // ';'
+      auto const param_end = std::min(entry.find(';'), entry.size());
+      auto const param = trim(entry.substr(0, param_end));
+      entry.remove_prefix(param_end);
+      if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') &&
+          param[1] == '=') {
+        q = std::strtod(std::string{param.substr(2)}.c_str(), nullptr);
+      }
+    }
+
+    if (boost::iequals(name, coding)) {
+      return q;
+    } else if (name == "*") {
+      wildcard_q = q;
+    }
+  }
+  return wildcard_q;
+}
+
+std::string gzip(std::string const& in) {
+  z_stream zs{};
+  if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                   15 + 16 /* gzip header */, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw std::runtime_error("deflateInit2 failed");
+  }
+
+  std::string out(deflateBound(&zs, in.size()), '\0');
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs.avail_in = static_cast<uInt>(in.size());
+  zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+  zs.avail_out = static_cast<uInt>(out.size());
+  auto const ret = deflate(&zs, Z_FINISH);
+  out.resize(zs.total_out);
+  deflateEnd(&zs);
+
+  if (ret != Z_STREAM_END) {
+    throw std::runtime_error("deflate failed");
+  }
+  return out;
+}
+
 struct http_server::impl {
   impl(boost::asio::io_service& ios, receiver& recvr)
       : ios_(ios), receiver_(recvr), server_(ios) {
@@ -75,14 +162,21 @@ struct http_server::impl {
   void handle_get(srv::route_request const& req, srv::callback& cb) {
     return receiver_.on_msg(
         make_no_msg(get_path(req.uri)),
-        ios_.wrap(std::bind(&impl::on_response, this, cb, p::_1, p::_2)));
+        ios_.wrap(std::bind(&impl::on_response, this, cb, get_format(req),
+                            p::_1, p::_2)));
   }
 
   void handle_post(srv::route_request const& req, srv::callback& cb) {
     if (has_header(req, "Content-Type", "application/json")) {
       return receiver_.on_msg(
           make_msg(req.content),
-          ios_.wrap(std::bind(&impl::on_response, this, cb, p::_1, p::_2)));
+          ios_.wrap(std::bind(&impl::on_response, this, cb, get_format(req),
+                              p::_1, p::_2)));
+    } else if (has_header(req, "Content-Type", "application/x-flatbuffers")) {
+      return receiver_.on_msg(
+          make_msg(req.content.data(), req.content.size()),
+          ios_.wrap(std::bind(&impl::on_response, this, cb, get_format(req),
+                              p::_1, p::_2)));
     } else {
       message_creator fbb;
       fbb.create_and_finish(
@@ -101,7 +195,8 @@ struct http_server::impl {
           get_path(req.uri));
       return receiver_.on_msg(
           make_msg(fbb),
-          ios_.wrap(std::bind(&impl::on_response, this, cb, p::_1, p::_2)));
+          ios_.wrap(std::bind(&impl::on_response, this, cb, get_format(req),
+                              p::_1, p::_2)));
     }
   }
 
@@ -119,15 +214,75 @@ struct http_server::impl {
     return uri;
   }
 
-  bool has_header(srv::route_request const& req, char const* k, char const* v) {
+  std::string_view get_header(srv::route_request const& req, char const* k) {
     auto it =
         std::find_if(begin(req.headers), end(req.headers),
                      [&k](auto&& h) { return boost::iequals(h.name, k); });
-    return it != end(req.headers) && it->value.find(v) != std::string::npos;
+    return it == end(req.headers) ? std::string_view{}
+                                  : std::string_view{it->value};
+  }
+
+  bool has_header(srv::route_request const& req, char const* k, char const* v) {
+    return get_header(req, k).find(v) != std::string_view::npos;
+  }
+
+  response_format get_format(srv::route_request const& req) {
+    response_format f;
+    f.flatbuffers_ = has_header(req, "Accept", "application/x-flatbuffers");
+
+    // Highest q-value wins (zstd on ties), q=0 refuses a coding.
+    auto const accept_encoding = get_header(req, "Accept-Encoding");
+    auto const zstd_q = accept_encoding_q(accept_encoding, "zstd");
+    auto const gzip_q = accept_encoding_q(accept_encoding, "gzip");
+    if (zstd_q > 0.0 && zstd_q >= gzip_q) {
+      f.encoding_ = content_encoding::ZSTD;
+    } else if (gzip_q > 0.0) {
+      f.encoding_ = content_encoding::GZIP;
+    }
+    return f;
+  }
+
+  static void write_content(reply& rep, response_format const& format,
+                            msg_ptr const& msg) {
+    auto const start = std::chrono::steady_clock::now();
+
+    if (format.flatbuffers_) {
+      rep.content.assign(reinterpret_cast<char const*>(msg->data()),
+                         msg->size());
+      rep.headers.emplace_back("Content-Type", "application/x-flatbuffers");
+    } else {
+      rep.content = msg->to_json();
+      rep.headers.emplace_back("Content-Type", "application/json");
+    }
+
+    if (rep.content.size() >= kMinCompressSize) {
+      switch (format.encoding_) {
+        case content_encoding::ZSTD: {
+          std::string compressed;
+          zstd::compress(rep.content.data(), rep.content.size(), &compressed);
+          rep.content = std::move(compressed);
+          rep.headers.emplace_back("Content-Encoding", "zstd");
+          break;
+        }
+        case content_encoding::GZIP:
+          rep.content = gzip(rep.content);
+          rep.headers.emplace_back("Content-Encoding", "gzip");
+          break;
+        case content_encoding::IDENTITY: break;
+      }
+    }
+    rep.headers.emplace_back("Vary", "Accept, Accept-Encoding");
+
+    auto const dur = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start);
+    std::stringstream timing;
+    timing << "serialize;dur=" << std::fixed << std::setprecision(3)
+           << dur.count();
+    rep.headers.emplace_back("Server-Timing", timing.str());
   }
 
-  void on_response(srv::callback const& cb, msg_ptr const& msg,
-                   std::error_code ec) {
+  void on_response(srv::callback const& cb, response_format const& format,
+                   msg_ptr const& msg, std::error_code ec) {
     auto rep = reply::stock_reply(reply::internal_server_error);
     try {
       if (!ec && msg) {
@@ -142,9 +297,8 @@ struct http_server::impl {
             rep.headers.emplace_back(h->name()->str(), h->value()->str());
           }
         } else {
-          rep.content = msg->to_json();
+          write_content(rep, format, msg);
           rep.status = reply::ok;
-          rep.headers.emplace_back("Content-Type", "application/json");
         }
       } else if (!ec) {
         rep = reply::stock_reply(reply::ok);
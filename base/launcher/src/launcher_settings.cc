@@ -13,6 +13,8 @@
 #define MODE_TEST "test"
 #define BATCH_INPUT_FILE "batch_input_file"
 #define BATCH_OUTPUT_FILE "batch_output_file"
+#define BATCH_OUTPUT_FORMAT "batch_output_format"
+#define BATCH_LATENCY_FILE "batch_latency_file"
 #define NUM_THREADS "num_threads"
 
 namespace motis {
@@ -49,10 +51,14 @@ std::ostream& operator<<(std::ostream& out,
 launcher_settings::launcher_settings(motis_mode_t m,
                                      std::string batch_input_file,
                                      std::string batch_output_file,
+                                     std::string batch_output_format,
+                                     std::string batch_latency_file,
                                      int num_threads)
     : mode_(m),
       batch_input_file_(std::move(batch_input_file)),
       batch_output_file_(std::move(batch_output_file)),
+      batch_output_format_(std::move(batch_output_format)),
+      batch_latency_file_(std::move(batch_latency_file)),
       num_threads_(num_threads) {}
 
 po::options_description launcher_settings::desc() {
@@ -71,6 +77,15 @@ po::options_description launcher_settings::desc() {
       (BATCH_OUTPUT_FILE,
        po::value<std::string>(&batch_output_file_)
            ->default_value(batch_output_file_))
+      (BATCH_OUTPUT_FORMAT,
+       po::value<std::string>(&batch_output_format_)
+           ->default_value(batch_output_format_),
+       "json = one compact JSON response per line\n"
+       "binary = size prefixed (uint32 little endian) flatbuffers")
+      (BATCH_LATENCY_FILE,
+       po::value<std::string>(&batch_latency_file_)
+           ->default_value(batch_latency_file_),
+       "per query latency CSV (id, target, ms), empty = off")
       (NUM_THREADS,
        po::value<int>(&num_threads_)->default_value(num_threads_));
   // clang-format on
@@ -81,6 +96,8 @@ void launcher_settings::print(std::ostream& out) const {
   out << "  " << MODE << ": " << mode_ << "\n"
       << "  " << BATCH_INPUT_FILE << ": " << batch_input_file_ << "\n"
       << "  " << BATCH_OUTPUT_FILE << ": " << batch_output_file_ << "\n"
+      << "  " << BATCH_OUTPUT_FORMAT << ": " << batch_output_format_ << "\n"
+      << "  " << BATCH_LATENCY_FILE << ": " << batch_latency_file_ << "\n"
       << "  " << NUM_THREADS << ": " << num_threads_;
 }
 
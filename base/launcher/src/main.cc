@@ -50,7 +50,7 @@ int main(int argc, char** argv) {
                                false);
   module_settings module_opt(instance.module_names());
   launcher_settings launcher_opt(launcher_settings::motis_mode_t::SERVER,
-                                 "queries.txt", "responses.txt",
+                                 "queries.txt", "responses.txt", "json", "",
                                  std::thread::hardware_concurrency());
 
   std::vector<conf::configuration*> confs = {&listener_opt, &dataset_opt,
@@ -125,8 +125,14 @@ int main(int argc, char** argv) {
         ios, boost::posix_time::seconds(1));
     timer->async_wait([&ios](boost::system::error_code) { ios.stop(); });
   } else if (launcher_opt.mode_ == launcher_settings::motis_mode_t::BATCH) {
-    inject_queries(ios, instance, launcher_opt.batch_input_file_,
-                   launcher_opt.batch_output_file_, launcher_opt.num_threads_);
+    batch_settings batch_opt;
+    batch_opt.input_file_path_ = launcher_opt.batch_input_file_;
+    batch_opt.output_file_path_ = launcher_opt.batch_output_file_;
+    batch_opt.output_format_ = launcher_opt.batch_output_format_ == "binary"
+                                   ? batch_settings::output_format::BINARY
+                                   : batch_settings::output_format::JSON;
+    batch_opt.latency_file_path_ = launcher_opt.batch_latency_file_;
+    inject_queries(ios, instance, batch_opt, launcher_opt.num_threads_);
   }
 
   LOG(info) << "system boot finished";
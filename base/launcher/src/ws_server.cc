@@ -169,7 +169,7 @@ struct ws_server::ws_server_impl {
       auto const data = reinterpret_cast<char const*>(msg->data());
       compress(data, msg->size(), &b);
     } else {
-      b = msg->to_json();
+      b = msg->to_json(true);
     }
     return b;
   }
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/filesystem.hpp"
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "motis/loader/hrd/hrd_parser.h"
+
+namespace fs = boost::filesystem;
+using namespace motis::loader::hrd;
+
+// Times the HRD parser with one and with all threads and checks that both
+// produce the same schedule.
+// Usage: motis-hrd-benchmark [hrd root or directory of hrd roots]
+//                            [iterations]
+// Defaults to the test fixtures (base/loader/test_resources/hrd_schedules).
+
+double parse(fs::path const& root, unsigned const num_threads,
+             int const iterations, std::vector<uint8_t>& buf) {
+  auto const start = std::chrono::steady_clock::now();
+  for (auto i = 0; i < iterations; ++i) {
+    flatbuffers64::FlatBufferBuilder fbb;
+    hrd_parser{num_threads}.parse(root, fbb);
+    buf.assign(fbb.GetBufferPointer(), fbb.GetBufferPointer() + fbb.GetSize());
+  }
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         iterations;
+}
+
+int main(int argc, char** argv) {
+  fs::path const input =
+      argc > 1 ? argv[1] : "base/loader/test_resources/hrd_schedules";
+  auto const iterations = argc > 2 ? std::stoi(argv[2]) : 10;
+  auto const num_threads = std::max(1U, std::thread::hardware_concurrency());
+
+  std::vector<fs::path> roots;
+  if (hrd_parser{}.applicable(input)) {
+    roots.emplace_back(input);
+  } else {
+    for (auto const& entry : fs::directory_iterator(input)) {
+      if (hrd_parser{}.applicable(entry.path())) {
+        roots.emplace_back(entry.path());
+      }
+    }
+  }
+  std::sort(begin(roots), end(roots));
+
+  auto total_seq = 0.0, total_par = 0.0;
+  auto mismatches = 0U;
+  std::stringstream report;  // printed after the (verbose) parser log
+  for (auto const& root : roots) {
+    std::vector<uint8_t> seq_buf, par_buf;
+    auto const seq_ms = parse(root, 1U, iterations, seq_buf);
+    auto const par_ms = parse(root, num_threads, iterations, par_buf);
+    auto const identical = seq_buf == par_buf;
+
+    report << root.filename().string() << ": sequential=" << seq_ms
+              << "ms, " << num_threads << " threads=" << par_ms << "ms"
+              << (identical ? "" : " OUTPUT DIFFERS") << "\n";
+    total_seq += seq_ms;
+    total_par += par_ms;
+    mismatches += identical ? 0U : 1U;
+  }
+
+  std::cout << "\n"
+            << report.str() << "total: sequential=" << total_seq << "ms, "
+            << num_threads << " threads=" << total_par << "ms\n";
+  return mismatches == 0U ? 0 : 1;
+}
@@ -1,5 +1,12 @@
 #pragma once
 
+#include <ctime>
+#include <exception>
+#include <limits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 #include "motis/core/common/hash_helper.h"
 #include "motis/core/common/hash_map.h"
 #include "motis/core/common/hash_set.h"
@@ -168,6 +175,30 @@ inline std::size_t push_mem(std::vector<std::unique_ptr<T>>& elements,
   return idx;
 }
 
+// Result of the first (parallel) phase of add_services for one section:
+// utc times and traffic days, not yet interned.
+struct section_times {
+  int16_t dep_{0}, arr_{0};
+  bitfield traffic_days_;
+};
+
+// Result of the first phase for one service with traffic in the interval.
+struct prepared_service {
+  Service const* service_{nullptr};
+  std::vector<std::pair<std::vector<time>, std::unordered_set<unsigned>>>
+      utc_times_;
+  std::vector<std::vector<section_times>> sections_;  // [time_idx][section]
+  bool broken_{false};
+};
+
+// Result of the first phase for all services of one route.
+struct prepared_route {
+  std::vector<prepared_service> services_;
+  std::time_t first_event_{std::numeric_limits<std::time_t>::max()};
+  std::time_t last_event_{std::numeric_limits<std::time_t>::min()};
+  std::exception_ptr error_;
+};
+
 struct graph_builder {
   graph_builder(schedule& sched, Interval const* schedule_interval, time_t from,
                 time_t to, bool apply_rules, bool adjust_footpaths);
@@ -184,13 +215,18 @@ struct graph_builder {
   void add_services(
       flatbuffers64::Vector<flatbuffers64::Offset<Service>> const* services);
 
-  void add_route_services(std::vector<Service const*> const& services);
+  prepared_route prepare_route_services(
+      std::vector<Service const*> const& services) const;
+
+  void add_route_services(std::vector<Service const*> const& route_services,
+                          prepared_route const& prepared);
 
   void add_expanded_trips(route const& r);
 
   std::vector<std::pair<std::vector<time>, std::unordered_set<unsigned>>>
   service_times_to_utc(bitfield const& traffic_days, int start_idx, int end_idx,
-                       Service const* s);
+                       Service const* s, std::time_t& first_event,
+                       std::time_t& last_event) const;
 
   merged_trips_idx create_merged_trips(Service const* s,
                                        std::vector<time> const& rel_utc_times);
@@ -204,11 +240,14 @@ struct graph_builder {
                                 std::vector<time> const& rel_utc_times,
                                 int section_idx = 0) const;
 
-  light_connection section_to_connection(
-      unsigned section_idx, Service const* service,
-      std::vector<time> relative_utc,
-      std::unordered_set<unsigned> srv_traffic_days,
-      merged_trips_idx trips_idx);
+  section_times prepare_section(
+      unsigned section_idx, std::vector<time> const& relative_utc,
+      std::unordered_set<unsigned> const& srv_traffic_days) const;
+
+  light_connection section_to_connection(unsigned section_idx,
+                                         Service const* service,
+                                         section_times const& times,
+                                         merged_trips_idx trips_idx);
 
   void count_events(const Service* const& service, int section_idx);
 
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <map>
 #include <string>
+#include <string_view>
 
 #include "motis/loader/gtfs/trip.h"
 #include "motis/loader/loaded_file.h"
@@ -10,7 +12,13 @@ namespace motis {
 namespace loader {
 namespace gtfs {
 
-void read_stop_times(loaded_file const&, trip_map&, stop_map const&);
+// Returns the number of rows read.
+std::size_t read_stop_times(loaded_file const&, trip_map&, stop_map const&);
+
+// Parses chunks of the file (split at trip boundaries) in parallel.
+// `content` can be a memory mapped file.
+std::size_t read_stop_times(std::string_view content, trip_map&,
+                            stop_map const&);
 
 }  // namespace gtfs
 }  // namespace loader
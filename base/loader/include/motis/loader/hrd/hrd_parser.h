@@ -1,3 +1,5 @@
+#include <thread>
+
 #include "boost/filesystem.hpp"
 #include "flatbuffers/flatbuffers.h"
 
@@ -9,6 +11,12 @@ namespace loader {
 namespace hrd {
 
 struct hrd_parser : public format_parser {
+  // Number of threads tokenising the service files (1 = sequential).
+  // The resulting schedule does not depend on it.
+  explicit hrd_parser(
+      unsigned num_threads = std::thread::hardware_concurrency())
+      : num_threads_(num_threads) {}
+
   bool applicable(boost::filesystem::path const& path) override;
   bool applicable(boost::filesystem::path const& path, config const& c);
 
@@ -22,6 +30,8 @@ struct hrd_parser : public format_parser {
              flatbuffers64::FlatBufferBuilder&) override;
   void parse(boost::filesystem::path const& hrd_root,
              flatbuffers64::FlatBufferBuilder&, config const& c);
+
+  unsigned num_threads_;
 };
 
 }  // namespace hrd
@@ -7,7 +7,10 @@
 
 #include "motis/schedule-format/Schedule_generated.h"
 
+#include <cmath>
+#include <numeric>
 #include <optional>
+#include <queue>
 #include <stack>
 
 #include "geo/latlng.h"
@@ -26,6 +29,12 @@ constexpr auto const kAdjustedMaxDuration = 15;  // [minutes]
 
 constexpr auto kNoComponent = std::numeric_limits<uint32_t>::max();
 
+// components of at least this many stations use all threads on their own
+constexpr auto const kLargeComponentSize = 256;
+
+// sparse components (see is_sparse) use one Dijkstra per source station
+constexpr auto const kDijkstraCostFactor = 16.0;
+
 // station_idx -> [footpath, ...]
 using footgraph = std::vector<std::vector<footpath>>;
 
@@ -197,20 +206,28 @@ struct footpath_builder {
         [](auto const& a, auto const& b) { return a.first == b.first; },
         [&](auto lb, auto ub) { ranges.emplace_back(lb, ub); });
 
-    auto const errors = utl::parallel_for(
-        ranges,
+    // small components are processed in parallel, large components one
+    // after another - each of them spread over all threads
+    std::vector<component_range> small_components, large_components;
+    for (auto const& range : ranges) {
+      auto const size = std::distance(range.first, range.second);
+      (size < kLargeComponentSize ? small_components : large_components)
+          .emplace_back(range);
+    }
+
+    log_errors(utl::parallel_for(
+        small_components,
         [&](auto const& range) {
-          process_component(range.first, range.second, fgraph);
+          process_component(range.first, range.second, fgraph, false);
         },
-        utl::parallel_error_strategy::CONTINUE_EXEC);
-    if (!errors.empty()) {
-      for (auto const& [idx, ex] : errors) {
-        try {
-          std::rethrow_exception(ex);
-        } catch (std::exception const& e) {
-          LOG(ml::error) << "footpath error: " << idx << " (" << e.what()
-                         << ")";
-        }
+        utl::parallel_error_strategy::CONTINUE_EXEC));
+
+    for (auto const& range : large_components) {
+      try {
+        process_component(range.first, range.second, fgraph, true);
+      } catch (std::exception const& e) {
+        LOG(ml::error) << "footpath error: component " << range.first->first
+                       << " (" << e.what() << ")";
       }
     }
   }
@@ -292,7 +309,7 @@ struct footpath_builder {
   }
 
   void process_component(component_it const lb, component_it const ub,
-                         footgraph const& fgraph) {
+                         footgraph const& fgraph, bool const parallel) {
     if (lb->first == kNoComponent) {
       return;
     }
@@ -334,36 +351,109 @@ struct footpath_builder {
     }
     utl::new_verify(size > 2, "invalid size");
 
-    constexpr auto const kInvalidTime = std::numeric_limits<motis::time>::max();
-    auto mat = make_flat_matrix<motis::time>(size, kInvalidTime);
-
+    // component local adjacency (compressed rows), precond.: sorted!
+    std::vector<uint32_t> offsets(size + 1U), targets, durations;
     for (auto i = 0; i < size; ++i) {
       auto it = lb;
-      for (auto const& edge : fgraph[(lb + i)->second]) {  // precond.: sorted!
+      for (auto const& edge : fgraph[(lb + i)->second]) {
         while (it != ub && edge.to_station_ != it->second) {
           ++it;
         }
-        auto j = std::distance(lb, it);
-        mat(i, j) = edge.duration_;
+        utl::new_verify(it != ub, "footpath target not in component");
+        targets.emplace_back(std::distance(lb, it));
+        durations.emplace_back(edge.duration_.ts());
       }
+      offsets[i + 1] = targets.size();
     }
 
-    floyd_warshall(mat);
+    auto const stride = floyd_warshall_padded_size(size);
+    auto mat = make_flat_matrix<uint32_t>(stride, kFloydWarshallInfinity);
+    if (is_sparse(size, targets.size())) {
+      auto const run_dijkstra = [&](uint32_t const source) {
+        dijkstra(source, offsets, targets, durations,
+                 &mat.entries_[source * stride]);
+      };
+      std::vector<uint32_t> sources(size);
+      std::iota(begin(sources), end(sources), 0U);
+      if (parallel) {
+        log_errors(utl::parallel_for(
+            sources, run_dijkstra,
+            utl::parallel_error_strategy::CONTINUE_EXEC));
+      } else {
+        std::for_each(begin(sources), end(sources), run_dijkstra);
+      }
+    } else {
+      for (auto i = 0; i < size; ++i) {
+        for (auto e = offsets[i]; e < offsets[i + 1]; ++e) {
+          auto& entry = mat(i, targets[e]);
+          entry = std::min(entry, durations[e]);
+        }
+      }
+      floyd_warshall_blocked(mat, parallel);
+    }
 
     for (auto i = 0; i < size; ++i) {
       for (auto j = 0; j < size; ++j) {
-        if (mat(i, j) == kInvalidTime || i == j) {
+        if (mat(i, j) == kFloydWarshallInfinity || i == j) {
           continue;
         }
 
         auto idx_a = std::next(lb, i)->second;
         auto idx_b = std::next(lb, j)->second;
+        auto const duration = motis::time{static_cast<int64_t>(mat(i, j))};
 
         // each node only in one cluster -> no sync required
         sched_.stations_[idx_a]->outgoing_footpaths_.emplace_back(idx_a, idx_b,
-                                                                  mat(i, j));
+                                                                  duration);
         sched_.stations_[idx_b]->incoming_footpaths_.emplace_back(idx_a, idx_b,
-                                                                  mat(i, j));
+                                                                  duration);
+      }
+    }
+  }
+
+  // Logs the errors returned by utl::parallel_for (CONTINUE_EXEC).
+  template <typename Errors>
+  static void log_errors(Errors const& errors) {
+    for (auto const& [idx, ex] : errors) {
+      try {
+        std::rethrow_exception(ex);
+      } catch (std::exception const& e) {
+        LOG(ml::error) << "footpath error: " << idx << " (" << e.what()
+                       << ")";
+      }
+    }
+  }
+
+  // Floyd-Warshall: ~n^3 / simd width, Dijkstra: ~n * e * log(n)
+  static bool is_sparse(std::size_t const n, std::size_t const edge_count) {
+    auto const log_n =
+        std::log2(static_cast<double>(std::max(n, std::size_t{2U})));
+    return kDijkstraCostFactor * static_cast<double>(edge_count) * log_n <
+           static_cast<double>(n * n);
+  }
+
+  // writes the shortest distances from source to dist[0..n)
+  static void dijkstra(uint32_t const source,
+                       std::vector<uint32_t> const& offsets,
+                       std::vector<uint32_t> const& targets,
+                       std::vector<uint32_t> const& durations,
+                       uint32_t* const dist) {
+    using label = std::pair<uint32_t, uint32_t>;  // (distance, node)
+    std::priority_queue<label, std::vector<label>, std::greater<>> pq;
+    dist[source] = 0U;
+    pq.emplace(0U, source);
+    while (!pq.empty()) {
+      auto const [d, node] = pq.top();
+      pq.pop();
+      if (d > dist[node]) {
+        continue;
+      }
+      for (auto e = offsets[node]; e < offsets[node + 1]; ++e) {
+        auto const new_dist = d + durations[e];
+        if (new_dist < dist[targets[e]]) {
+          dist[targets[e]] = new_dist;
+          pq.emplace(new_dist, targets[e]);
+        }
       }
     }
   }
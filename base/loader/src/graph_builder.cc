@@ -20,6 +20,7 @@
 #include <numeric>
 
 #include "utl/get_or_create.h"
+#include "utl/parallel_for.h"
 #include "utl/to_vec.h"
 
 using namespace motis::logging;
@@ -28,6 +29,8 @@ using namespace flatbuffers64;
 namespace motis {
 namespace loader {
 
+constexpr auto const PREPARE_BATCH_SIZE = 16384U;  // services
+
 std::vector<day_idx_t> day_offsets(std::vector<time> const& rel_utc_times) {
   auto day_offsets = std::vector<day_idx_t>{};
   day_offsets.resize(rel_utc_times.size() / 2);
@@ -163,6 +166,30 @@ void graph_builder::add_services(
               return lhs->route() < rhs->route();
             });
 
+  // Two phases per batch of routes: utc times and traffic days of all
+  // routes are computed in parallel (prepare_route_services, read only),
+  // then ids, trips, bitfields and connections are assigned serially in
+  // route order (add_route_services) - the graph does not depend on the
+  // number of threads.
+  std::vector<std::vector<Service const*>> batch;
+  auto batch_size = 0U;
+  auto const add_batch = [&]() {
+    std::vector<prepared_route> prepared(batch.size());
+    std::vector<std::size_t> indices(batch.size());
+    std::iota(begin(indices), end(indices), 0U);
+    utl::parallel_for(
+        indices,
+        [&](std::size_t const idx) {
+          prepared[idx] = prepare_route_services(batch[idx]);
+        },
+        utl::parallel_error_strategy::CONTINUE_EXEC);
+    for (auto i = 0U; i < batch.size(); ++i) {
+      add_route_services(batch[i], prepared[i]);
+    }
+    batch.clear();
+    batch_size = 0U;
+  };
+
   auto it = begin(sorted);
   std::vector<Service const*> route_services;
   while (it != end(sorted)) {
@@ -175,108 +202,118 @@ void graph_builder::add_services(
     } while (it != end(sorted) && route == (*it)->route());
 
     if (!route_services.empty()) {
-      add_route_services(route_services);
+      batch_size += route_services.size();
+      batch.emplace_back(std::move(route_services));
+      if (batch_size >= PREPARE_BATCH_SIZE) {
+        add_batch();
+      }
     }
 
     route_services.clear();
   }
+  add_batch();
 }
 
-void graph_builder::add_route_services(
-    std::vector<Service const*> const& services) {
-  if (services.empty()) {
-    return;
-  }
+prepared_route graph_builder::prepare_route_services(
+    std::vector<Service const*> const& services) const {
+  prepared_route prepared;
+  try {
+    for (auto const& service : services) {
+      auto bf = service->traffic_days();
+      bitfield const traffic_days =
+          deserialize_bitset<BIT_COUNT>({bf->c_str(), bf->size()});
+
+      // skip services with no traffic within the time span
+      bool traffic = false;
+      int const day_offset =
+          service->times()->Get(service->times()->size() - 2) / MINUTES_A_DAY;
+      auto start_idx = std::max(0, static_cast<int>(from_day_) - day_offset);
+      auto end_idx = std::min(BIT_COUNT, static_cast<unsigned>(to_day_));
+      for (unsigned day_idx = start_idx; day_idx < end_idx; ++day_idx) {
+        if (traffic_days.test(day_idx)) {
+          traffic = true;
+          break;
+        }
+      }
+      if (!traffic) {
+        continue;
+      }
 
-  std::vector<route_t> alt_routes;
-  for (auto const& service : services) {
-    auto bf = service->traffic_days();
-    bitfield const traffic_days =
-        deserialize_bitset<BIT_COUNT>({bf->c_str(), bf->size()});
-
-    // skip services with no traffic within the time span
-    bool traffic = false;
-    int const day_offset =
-        service->times()->Get(service->times()->size() - 2) / MINUTES_A_DAY;
-    auto start_idx = std::max(0, static_cast<int>(from_day_) - day_offset);
-    auto end_idx = std::min(BIT_COUNT, static_cast<unsigned>(to_day_));
-    for (unsigned day_idx = start_idx; day_idx < end_idx; ++day_idx) {
-      if (traffic_days.test(day_idx)) {
-        traffic = true;
-        break;
+      prepared_service s;
+      s.service_ = service;
+
+      // service times converted to utc relative to begin of day of first
+      // event
+      try {
+        s.utc_times_ = service_times_to_utc(traffic_days, start_idx, end_idx,
+                                            service, prepared.first_event_,
+                                            prepared.last_event_);
+      } catch (...) {
+        s.broken_ = true;
+        prepared.services_.emplace_back(std::move(s));
+        continue;  // skip broken service
       }
+
+      // utc times and traffic days for each section and time string
+      auto const section_length = service->sections()->size();
+      s.sections_.resize(s.utc_times_.size());
+      for (unsigned time_idx = 0; time_idx < s.utc_times_.size(); ++time_idx) {
+        s.sections_[time_idx].reserve(section_length);
+        for (unsigned section_idx = 0; section_idx < section_length;
+             ++section_idx) {
+          s.sections_[time_idx].emplace_back(
+              prepare_section(section_idx, s.utc_times_[time_idx].first,
+                              s.utc_times_[time_idx].second));
+        }
+      }
+      prepared.services_.emplace_back(std::move(s));
     }
-    if (!traffic) {
-      continue;
-    }
+  } catch (...) {
+    prepared.error_ = std::current_exception();
+  }
+  return prepared;
+}
 
-    // service times converted to utc relative to begin of day of first event
-    std::vector<std::pair<std::vector<time>, std::unordered_set<unsigned>>>
-        utc_times;
+void graph_builder::add_route_services(
+    std::vector<Service const*> const& route_services,
+    prepared_route const& prepared) {
+  sched_.first_event_schedule_time_ =
+      std::min(sched_.first_event_schedule_time_, prepared.first_event_);
+  sched_.last_event_schedule_time_ =
+      std::max(sched_.last_event_schedule_time_, prepared.last_event_);
 
-    try {
-      utc_times =
-          service_times_to_utc(traffic_days, start_idx, end_idx, service);
-    } catch (...) {
+  std::vector<route_t> alt_routes;
+  for (auto const& s : prepared.services_) {
+    if (s.broken_) {
       std::cerr << "\nBAD SERVICE\n";
-      /*
-            for (int i = 0; i < service->times()->size(); ++i) {
-              std::cerr << service->times()->Get(i) << " ";
-            }
-            std::cerr << "\n";
-
-            for (int i = 0; i < service->route()->stations()->size(); ++i) {
-              auto const& station = service->route()->stations()->Get(i);
-
-              auto const& arr = service->times()->Get(i * 2);
-              auto const& dep = service->times()->Get(i * 2 + 1);
-
-              std::cerr << station->id()->str() << " " <<
-         station->name()->str(); if (i != 0) { std::cerr << " 0" <<
-         std::setfill('0') << std::setw(2) << arr / 60
-                          << std::setfill('0') << std::setw(2) << arr % 60;
-              }
-              if (i != service->route()->stations()->size() - 1) {
-                std::cerr << " 0" << std::setfill('0') << std::setw(2) << dep /
-         60
-                          << std::setfill('0') << std::setw(2) << dep % 60;
-              }
-              std::cerr << "\n";
-            }
-            // throw;*/
       continue;  // skip broken service
     }
 
     // make lcon for each section and time string
-    std::vector<std::vector<light_connection>> lcon_strings(utc_times.size());
-    // auto trip_idx = create_merged_trips(service, utc_times[0].first);
-    for (unsigned time_idx = 0; time_idx < utc_times.size(); ++time_idx) {
-      auto trip_idx = create_merged_trips(service, utc_times[time_idx].first);
-      auto const section_length = static_cast<int>(service->sections()->size());
-      lcon_strings[time_idx].resize(section_length);
-      for (int section_idx = 0; section_idx < section_length; ++section_idx) {
+    std::vector<std::vector<light_connection>> lcon_strings(
+        s.utc_times_.size());
+    for (unsigned time_idx = 0; time_idx < s.utc_times_.size(); ++time_idx) {
+      auto trip_idx =
+          create_merged_trips(s.service_, s.utc_times_[time_idx].first);
+      auto const& sections = s.sections_[time_idx];
+      lcon_strings[time_idx].resize(sections.size());
+      for (unsigned section_idx = 0; section_idx < sections.size();
+           ++section_idx) {
         lcon_strings[time_idx][section_idx] = section_to_connection(
-            section_idx, service, utc_times[time_idx].first,
-            utc_times[time_idx].second, trip_idx);
-        count_events(service, section_idx);
+            section_idx, s.service_, sections[section_idx], trip_idx);
+        count_events(s.service_, section_idx);
       }
     }
 
-    for (unsigned i = 0; i < utc_times.size(); ++i) {
-      auto const& times = utc_times[i].first;
-      auto const& lcons = lcon_strings[i];
-      add_to_routes(alt_routes, times, lcons);
+    for (unsigned i = 0; i < s.utc_times_.size(); ++i) {
+      add_to_routes(alt_routes, s.utc_times_[i].first, lcon_strings[i]);
     }
+  }
 
-    //    for (auto const& lcon_string : lcon_strings) {
-    //      std::cout << "\n";
-    //      for (auto const& lcon : lcon_string) {
-    //        std::cout << std::setfill(' ') << std::setw(4) << lcon.d_time_ <<
-    //        " ";
-    //        std::cout << std::setfill(' ') << std::setw(4) << lcon.a_time_ <<
-    //        " ";
-    //      }
-    //    }
+  // errors of the first phase surface where the sequential build would
+  // have thrown them
+  if (prepared.error_) {
+    std::rethrow_exception(prepared.error_);
   }
 
   for (auto const& route : alt_routes) {
@@ -284,7 +321,8 @@ void graph_builder::add_route_services(
       continue;
     }
 
-    auto r = create_route(services[0]->route(), route, next_route_index_++);
+    auto r =
+        create_route(route_services[0]->route(), route, next_route_index_++);
     index_first_route_node(*r);
     write_trip_info(*r);
     add_expanded_trips(*r);
@@ -387,43 +425,43 @@ station_node* graph_builder::get_station_node(Station const* station) const {
   return it->second;
 }
 
-light_connection graph_builder::section_to_connection(
-    unsigned section_idx, Service const* service,
-    std::vector<time> relative_utc,
-    std::unordered_set<unsigned> srv_traffic_days, merged_trips_idx trips_idx) {
-
+section_times graph_builder::prepare_section(
+    unsigned section_idx, std::vector<time> const& relative_utc,
+    std::unordered_set<unsigned> const& srv_traffic_days) const {
   auto const& rel_utc_dep = relative_utc[section_idx * 2];
   auto const& rel_utc_arr = relative_utc[section_idx * 2 + 1];
 
-  //  std::cout << "\nrel_utc_dep: " << rel_utc_dep;
-  //  std::cout << "\nrel_utc_arr: " << rel_utc_arr;
-
   unsigned const day_offset = rel_utc_dep.day();
   int16_t const utc_mam_dep = (rel_utc_dep - (day_offset * MINUTES_A_DAY)).ts();
   int16_t const utc_mam_arr = utc_mam_dep + (rel_utc_arr - rel_utc_dep).ts();
 
-  //  std::cout << "\nday_offset: " << day_offset;
-  //  std::cout << "\nutc_mam_dep: " << utc_mam_dep;
-  //  std::cout << "\nutc_mam_arr: " << utc_mam_arr;
-
   verify(utc_mam_dep <= utc_mam_arr, "departure must be before arrival");
 
-  bitfield con_traffic_days;
+  section_times times;
+  times.dep_ = utc_mam_dep;
+  times.arr_ = utc_mam_arr;
   for (auto const& day : srv_traffic_days) {
     if (day_offset <= day) {
       // TODO: use (bitfield, offset) representation to save RAM
-      con_traffic_days.set(day + day_offset);
+      times.traffic_days_.set(day + day_offset);
     }
   }
+  return times;
+}
 
-  auto bitfield = get_or_create_bitfield(con_traffic_days);
+light_connection graph_builder::section_to_connection(
+    unsigned section_idx, Service const* service, section_times const& times,
+    merged_trips_idx trips_idx) {
+  auto bitfield = get_or_create_bitfield(times.traffic_days_);
   connection* full_con = get_full_connection(section_idx, service);
-  return {bitfield, utc_mam_dep, utc_mam_arr, full_con, trips_idx};
+  return {bitfield, times.dep_, times.arr_, full_con, trips_idx};
 }
 
 std::vector<std::pair<std::vector<time>, std::unordered_set<unsigned>>>
 graph_builder::service_times_to_utc(bitfield const& traffic_days, int start_idx,
-                                    int end_idx, Service const* s) {
+                                    int end_idx, Service const* s,
+                                    std::time_t& first_event,
+                                    std::time_t& last_event) const {
   std::vector<std::pair<std::vector<time>, std::unordered_set<unsigned>>>
       utc_times;
   std::vector<time> utc_service_times;
@@ -437,7 +475,7 @@ graph_builder::service_times_to_utc(bitfield const& traffic_days, int start_idx,
     int fix_offset = 0;
     for (unsigned i = 1; i < s->times()->size() - 1; ++i) {
       auto const& station = *sched_.stations_.at(
-          stations_[s->route()->stations()->Get(i / 2)]->id_);
+          get_station_node(s->route()->stations()->Get(i / 2))->id_);
 
       auto local_time = s->times()->Get(i);
       auto const day_offset = local_time / MINUTES_A_DAY;
@@ -498,11 +536,11 @@ graph_builder::service_times_to_utc(bitfield const& traffic_days, int start_idx,
       }
 
       // Track first event.
-      sched_.first_event_schedule_time_ = std::min(
-          sched_.first_event_schedule_time_,
+      first_event = std::min(
+          first_event,
           motis_to_unixtime(sched_, abs_utc) - SCHEDULE_OFFSET_MINUTES * 60);
-      sched_.last_event_schedule_time_ = std::max(
-          sched_.last_event_schedule_time_,
+      last_event = std::max(
+          last_event,
           motis_to_unixtime(sched_, abs_utc) - SCHEDULE_OFFSET_MINUTES * 60);
 
       utc_service_times.emplace_back(rel_utc);
@@ -853,15 +891,84 @@ connection_info* graph_builder::get_or_create_connection_info(
 void graph_builder::dedup_bitfields() {
   scoped_timer timer("bitfield deduplication");
 
-  std::vector<size_t> map;
   auto& bfs = sched_.bitfields_;
+  if (bfs.empty()) {
+    return;
+  }
+
+  // days with traffic in any bitfield: [first_day, first_day + day_count)
+  bitfield all;
+  for (auto const& bf : bfs) {
+    all |= bf;
+  }
+  auto first_day = 0U, day_count = 0U;
+  if (all.any()) {
+    auto last_day = BIT_COUNT - 1;
+    while (!all.test(first_day)) {
+      ++first_day;
+    }
+    while (!all.test(last_day)) {
+      --last_day;
+    }
+    day_count = last_day - first_day + 1;
+  }
+  auto const words_per_bf = std::max(1U, (day_count + 63U) / 64U);
+
+  // re-base every bitfield to first_day: words_per_bf words per bitfield
+  std::vector<uint64_t> words(bfs.size() * words_per_bf);
+  {
+    scoped_timer timer("re-base");
+    bitfield const word_mask{~0ULL};
+    for (auto i = 0U; i < bfs.size(); ++i) {
+      auto const shifted = bfs[i] >> first_day;
+      for (auto w = 0U; w < words_per_bf; ++w) {
+        words[i * words_per_bf + w] =
+            ((shifted >> (64U * w)) & word_mask).to_ullong();
+      }
+    }
+  }
+
+  // sort/unique on the words instead of bit by bit bitset comparisons
+  auto const row = [&](std::size_t const r) {
+    return std::next(begin(words), r * words_per_bf);
+  };
+  std::vector<std::size_t> rows(bfs.size());
+  std::iota(begin(rows), end(rows), 0U);
+  std::vector<size_t> map;
   {
     scoped_timer timer("sort/unique");
     map = tracking_dedupe(
-        bfs,  //
-        [](auto const& a, auto const& b) { return a == b; },
-        [&](auto const& a, auto const& b) { return bfs[a] < bfs[b]; });
-    bfs.shrink_to_fit();
+        rows,
+        [&](auto const a, auto const b) {
+          return std::equal(row(a), row(a) + words_per_bf, row(b));
+        },
+        [&](auto const a, auto const b) {
+          return std::lexicographical_compare(
+              row(rows[a]), row(rows[a]) + words_per_bf, row(rows[b]),
+              row(rows[b]) + words_per_bf);
+        });
+  }
+
+  bfs.clear();
+  bfs.shrink_to_fit();
+
+  auto& pool = sched_.compact_bitfields_;
+  pool.resize(rows.size());
+  if (words_per_bf > 1) {
+    sched_.compact_bitfield_words_.resize(rows.size() * words_per_bf);
+  }
+  for (auto i = 0U; i < rows.size(); ++i) {
+    auto& bf = pool[i];
+    bf.first_day_ = static_cast<uint16_t>(first_day);
+    bf.day_count_ = static_cast<uint16_t>(day_count);
+    if (words_per_bf == 1) {
+      bf.bits_ = *row(rows[i]);
+    } else {
+      auto const out =
+          std::next(begin(sched_.compact_bitfield_words_), i * words_per_bf);
+      std::copy(row(rows[i]), row(rows[i]) + words_per_bf, out);
+      bf.words_ = &*out;
+    }
   }
 
   {
@@ -875,7 +982,7 @@ void graph_builder::dedup_bitfields() {
             continue;
           }
           for (auto& c : e.m_.route_edge_.conns_) {
-            c.traffic_days_ = &sched_.bitfields_[map[c.bitfield_idx_]];
+            c.traffic_days_ = &pool[map[c.bitfield_idx_]];
           }
         }
       }
@@ -889,11 +996,14 @@ void graph_builder::dedup_bitfields() {
           }
 
           auto const bf_idx = edge.m_.route_edge_.bitfield_idx_;
-          edge.m_.route_edge_.traffic_days_ = &sched_.bitfields_[map[bf_idx]];
+          edge.m_.route_edge_.traffic_days_ = &pool[map[bf_idx]];
         }
       }
     }
   }
+
+  LOG(info) << pool.size() << " bitfields (" << day_count << " days from day "
+            << first_day << ", " << words_per_bf << " words each)";
 }
 
 schedule_ptr build_graph(Schedule const* serialized, time_t from, time_t to,
@@ -940,25 +1050,18 @@ schedule_ptr build_graph(Schedule const* serialized, time_t from, time_t to,
 
   builder.connect_reverse();
   builder.sort_trips();
-  builder.dedup_bitfields();  // DON'T TOUCH sched_.bitfields_ after this!
+  builder.dedup_bitfields();  // sched_.bitfields_ is empty after this!
 
   sched->route_count_ = builder.next_route_index_;
   sched->node_count_ = builder.next_node_id_;
-  sched->transfers_lower_bounds_fwd_ = build_interchange_graph(
-      sched->station_nodes_, sched->route_count_, search_dir::FWD);
-  sched->transfers_lower_bounds_bwd_ = build_interchange_graph(
-      sched->station_nodes_, sched->route_count_, search_dir::BWD);
-  sched->travel_time_lower_bounds_fwd_ =
-      build_station_graph(sched->station_nodes_, search_dir::FWD);
-  sched->travel_time_lower_bounds_bwd_ =
-      build_station_graph(sched->station_nodes_, search_dir::BWD);
+  sched->lower_bounds_.publish(build_lower_bound_graphs(
+      sched->station_nodes_, sched->route_count_, 0U));
   sched->waiting_time_rules_ = load_waiting_time_rules(sched->categories_);
   sched->schedule_begin_ -= SCHEDULE_OFFSET_MINUTES * 60;
 
   LOG(info) << sched->stations_.size() << " stations";
   LOG(info) << sched->connection_infos_.size() << " connection infos";
   LOG(info) << builder.lcon_count_ << " light connections";
-  LOG(info) << sched->bitfields_.size() << " bitfields";
   LOG(info) << builder.next_route_index_ << " routes";
   LOG(info) << sched->trip_mem_.size() << " trips";
   LOG(info) << serialized->services()->size()
@@ -1,12 +1,18 @@
 #include "motis/loader/gtfs/gtfs_parser.h"
 
+#include <algorithm>
+#include <chrono>
 #include <numeric>
+#include <string_view>
 
 #include "boost/filesystem.hpp"
 
+#include "tar/mmap_reader.h"
+
 #include "utl/get_or_create.h"
 
 #include "motis/core/common/date_time_util.h"
+#include "motis/core/common/logging.h"
 #include "motis/loader/gtfs/agency.h"
 #include "motis/loader/gtfs/calendar.h"
 #include "motis/loader/gtfs/calendar_date.h"
@@ -21,6 +27,7 @@
 #include "motis/schedule-format/Schedule_generated.h"
 
 using namespace flatbuffers64;
+using namespace motis::logging;
 namespace fs = boost::filesystem;
 using std::get;
 
@@ -66,7 +73,26 @@ std::vector<std::string> gtfs_parser::missing_files(
   return files;
 }
 
+namespace {
+
+std::size_t read_stop_times(fs::path const& path, trip_map& trips,
+                            stop_map const& stops) {
+  if (fs::file_size(path) == 0U) {
+    return 0U;
+  }
+
+  // mapped instead of read: large feeds have stop_times files of several GB
+  tar::mmap_reader mapping(path.string().c_str());
+  return gtfs::read_stop_times(
+      std::string_view{mapping.m_.fmap_, mapping.m_.size()}, trips, stops);
+}
+
+}  // namespace
+
 void gtfs_parser::parse(fs::path const& root, FlatBufferBuilder& fbb) {
+  using clock = std::chrono::steady_clock;
+  auto const parse_start = clock::now();
+
   auto const load = [&](char const* file) { return loaded_file(root / file); };
   auto const agencies = read_agencies(load(AGENCY_FILE));
   auto const stops = read_stops(load(STOPS_FILE));
@@ -76,7 +102,12 @@ void gtfs_parser::parse(fs::path const& root, FlatBufferBuilder& fbb) {
   auto const services = traffic_days(calendar, dates);
   auto const transfers = read_transfers(load(TRANSFERS_FILE), stops);
   auto trips = read_trips(load(TRIPS_FILE), routes, services);
-  read_stop_times(load(STOP_TIMES_FILE), trips, stops);
+
+  auto const stop_times_start = clock::now();
+  auto const stop_time_rows =
+      read_stop_times(root / STOP_TIMES_FILE, trips, stops);
+  auto const stop_times_seconds =
+      std::chrono::duration<double>(clock::now() - stop_times_start).count();
 
   std::map<int, Offset<Category>> fbs_categories;
   std::map<agency const*, Offset<Provider>> fbs_providers;
@@ -180,6 +211,14 @@ void gtfs_parser::parse(fs::path const& root, FlatBufferBuilder& fbb) {
       fbb, output_services, fbb.CreateVector(values(fbs_stations)),
       fbb.CreateVector(values(fbs_routes)), &interval, footpaths,
       fbb.CreateVector(std::vector<Offset<RuleService>>())));
+
+  auto const parse_seconds =
+      std::chrono::duration<double>(clock::now() - parse_start).count();
+  LOG(info) << "gtfs: " << stop_time_rows << " stop times in "
+            << stop_times_seconds << "s ("
+            << stop_time_rows / std::max(stop_times_seconds, 1e-9)
+            << " rows/s), parse total " << parse_seconds << "s ("
+            << stop_time_rows / std::max(parse_seconds, 1e-9) << " rows/s)";
 }
 
 }  // namespace gtfs
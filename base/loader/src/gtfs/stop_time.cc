@@ -1,21 +1,31 @@
 #include "motis/loader/gtfs/stop_time.h"
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <tuple>
+#include <vector>
 
 #include "parser/arg_parser.h"
-#include "parser/csv.h"
 
+#include "utl/parallel_for.h"
+
+#include "motis/core/common/hash_map.h"
 #include "motis/loader/util.h"
 
-using std::get;
 using namespace parser;
 
 namespace motis {
 namespace loader {
 namespace gtfs {
 
-using gtfs_stop_time = std::tuple<cstr, cstr, cstr, cstr, int, cstr, int, int>;
 enum {
   trip_id,
   arrival_time,
@@ -24,13 +34,22 @@ enum {
   stop_sequence,
   stop_headsign,
   pickup_type,
-  drop_off_type
+  drop_off_type,
+  column_count
 };
 
-static const column_mapping<gtfs_stop_time> stop_time_columns = {
+constexpr std::array<char const*, column_count> stop_time_columns = {
     {"trip_id", "arrival_time", "departure_time", "stop_id", "stop_sequence",
      "stop_headsign", "pickup_type", "drop_off_type"}};
 
+constexpr auto const MIN_CHUNK_SIZE = std::size_t{1024U} * 1024U;
+constexpr auto const TRIP_LOCK_COUNT = 256U;
+
+using row_t = std::array<std::string_view, column_count>;
+
+template <typename T>
+using id_index = hash_map<std::string_view, T*>;
+
 int hhmm_to_min(cstr s) {
   if (s.len == 0) {
     return -1;
@@ -50,30 +69,266 @@ int hhmm_to_min(cstr s) {
   }
 }
 
-void read_stop_times(loaded_file const& file, trip_map& trips,
-                     stop_map const& stops) {
-  std::string last_trip_id;
-  trip* last_trip = nullptr;
-
-  for (auto const& s :
-       read<gtfs_stop_time>(file.content(), stop_time_columns)) {
-    trip* t = nullptr;
-    auto t_id = get<trip_id>(s).to_str();
-    if (last_trip != nullptr && t_id == last_trip_id) {
-      t = last_trip;
+namespace {
+
+cstr to_cstr(std::string_view s) { return {s.data(), s.size()}; }
+
+int to_int(std::string_view s) {
+  auto c = to_cstr(s);
+  int i = 0;
+  parse_arg(c, i, 0);
+  return i;
+}
+
+// Returns the line starting at `pos` (without line break) and moves `pos`
+// to the beginning of the next line.
+std::string_view next_line(std::string_view const content, std::size_t& pos) {
+  auto const end = content.find('\n', pos);
+  auto line = content.substr(pos, end == std::string_view::npos
+                                      ? std::string_view::npos
+                                      : end - pos);
+  pos = end == std::string_view::npos ? content.size() : end + 1;
+  if (!line.empty() && line.back() == '\r') {
+    line.remove_suffix(1);
+  }
+  return line;
+}
+
+// Calls fn(field_idx, field) for every field of a csv line.
+// Quoted fields are passed without their quotes. Quoted fields containing
+// escaped quotes ("") are unescaped into unescaped[field_idx] and passed as
+// a view of this buffer (valid until the next call). A deque is used because
+// growing it keeps the buffers of the preceding fields in place.
+template <typename Fn>
+void for_each_field(std::string_view line,
+                    std::deque<std::string>& unescaped, Fn&& fn) {
+  auto field_idx = 0U;
+  while (true) {
+    std::string_view field;
+    if (!line.empty() && line.front() == '"') {
+      auto end = std::size_t{1U};
+      while (end < line.size() &&
+             (line[end] != '"' ||
+              (end + 1 < line.size() && line[end + 1] == '"'))) {
+        end += line[end] == '"' ? 2U : 1U;
+      }
+      field = line.substr(1, end - 1);
+      line.remove_prefix(std::min(end + 1, line.size()));
+      if (field.find("\"\"") != std::string_view::npos) {
+        if (unescaped.size() <= field_idx) {
+          unescaped.resize(field_idx + 1);
+        }
+        auto& buf = unescaped[field_idx];
+        buf.clear();
+        for (auto i = std::size_t{0U}; i < field.size(); ++i) {
+          buf += field[i];
+          if (field[i] == '"') {
+            ++i;  // skip the second quote
+          }
+        }
+        field = buf;
+      }
     } else {
-      t = trips.at(t_id).get();
-      last_trip_id = t_id;
-      last_trip = t;
+      field = line.substr(0, line.find(','));
+      line.remove_prefix(field.size());
     }
 
-    t->stop_times_.emplace(
-        get<stop_sequence>(s),  // index
-        stops.at(get<stop_id>(s).to_str()).get(),  // constructor arguments
-        get<stop_headsign>(s).to_str(),  //
-        hhmm_to_min(get<arrival_time>(s)), get<drop_off_type>(s) == 0,
-        hhmm_to_min(get<departure_time>(s)), get<pickup_type>(s) == 0);
+    fn(field_idx++, field);
+
+    if (line.empty()) {
+      return;
+    }
+    line.remove_prefix(1);  // ','
+  }
+}
+
+// Maps the field index of the header to the stop_times column (or -1).
+std::vector<int> read_header(std::string_view header) {
+  if (header.substr(0, 3) == "\xEF\xBB\xBF") {
+    header.remove_prefix(3);  // UTF-8 BOM
+  }
+  std::vector<int> field_to_column;
+  std::deque<std::string> unescaped;
+  for_each_field(header, unescaped, [&](unsigned, std::string_view name) {
+    auto const it = std::find(begin(stop_time_columns), end(stop_time_columns),
+                              name);
+    field_to_column.emplace_back(
+        it == end(stop_time_columns)
+            ? -1
+            : static_cast<int>(std::distance(begin(stop_time_columns), it)));
+  });
+  return field_to_column;
+}
+
+void read_row(std::string_view line, std::vector<int> const& field_to_column,
+              row_t& row, std::deque<std::string>& unescaped) {
+  row.fill(std::string_view{});
+  for_each_field(line, unescaped, [&](unsigned idx, std::string_view field) {
+    if (idx < field_to_column.size() && field_to_column[idx] != -1) {
+      row[field_to_column[idx]] = field;
+    }
+  });
+}
+
+std::string read_trip_id(std::string_view line,
+                         std::vector<int> const& field_to_column) {
+  row_t row;
+  std::deque<std::string> unescaped;
+  read_row(line, field_to_column, row, unescaped);
+  return std::string{row[trip_id]};
+}
+
+// Splits the body into chunks of about equal size. Chunks start at the
+// beginning of a line and do not split the rows of a trip (if the file is
+// ordered by trip, as usual).
+std::vector<std::pair<std::size_t, std::size_t>> split_at_trips(
+    std::string_view const content, std::size_t const body_begin,
+    std::vector<int> const& field_to_column, std::size_t const chunk_count) {
+  std::vector<std::pair<std::size_t, std::size_t>> chunks;
+  auto const size = content.size();
+  auto const chunk_size = (size - body_begin) / chunk_count + 1;
+  auto from = body_begin;
+  while (from < size) {
+    // end of the line containing from + chunk_size
+    auto to = std::min(size, from + chunk_size);
+    auto const line_end = content.find('\n', to - 1);
+    to = line_end == std::string_view::npos ? size : line_end + 1;
+
+    // take all following rows of the last trip
+    if (to < size) {
+      auto const prev_line_end =
+          to >= 2 ? content.rfind('\n', to - 2) : std::string_view::npos;
+      auto last_line = prev_line_end == std::string_view::npos ||
+                               prev_line_end < from
+                           ? from
+                           : prev_line_end + 1;
+      auto const last_trip =
+          read_trip_id(next_line(content, last_line), field_to_column);
+      while (to < size) {
+        auto next = to;
+        if (read_trip_id(next_line(content, next), field_to_column) !=
+            last_trip) {
+          break;
+        }
+        to = next;
+      }
+    }
+
+    chunks.emplace_back(from, to);
+    from = to;
+  }
+  return chunks;
+}
+
+template <typename T>
+id_index<T> make_index(std::map<std::string, std::unique_ptr<T>> const& m) {
+  id_index<T> index;
+  index.set_empty_key(std::string_view{});
+  index.resize(m.size());
+  for (auto const& [id, el] : m) {
+    if (!id.empty()) {
+      index[id] = el.get();
+    }
+  }
+  return index;
+}
+
+template <typename T>
+T* lookup(id_index<T> const& index, std::string_view const id,
+          char const* what) {
+  auto const it = id.empty() ? end(index) : index.find(id);
+  if (it == end(index)) {
+    throw std::out_of_range{std::string{what} + " not found: " +
+                            std::string{id}};
+  }
+  return it->second;
+}
+
+}  // namespace
+
+std::size_t read_stop_times(loaded_file const& file, trip_map& trips,
+                            stop_map const& stops) {
+  auto const content = file.content();
+  return read_stop_times(std::string_view{content.str, content.len}, trips,
+                         stops);
+}
+
+std::size_t read_stop_times(std::string_view const content, trip_map& trips,
+                            stop_map const& stops) {
+  auto body_begin = std::size_t{0U};
+  auto const field_to_column = read_header(next_line(content, body_begin));
+
+  // ids are interned once: rows are looked up by string_view (no
+  // std::string per field and row)
+  auto const trip_index = make_index(trips);
+  auto const stop_index = make_index(stops);
+
+  auto const chunk_count = std::max(
+      std::size_t{1U},
+      std::min(static_cast<std::size_t>(std::thread::hardware_concurrency()) *
+                   4U,
+               (content.size() - body_begin) / MIN_CHUNK_SIZE));
+  auto const chunks =
+      split_at_trips(content, body_begin, field_to_column, chunk_count);
+
+  // rows of a trip are usually in one chunk; the locks only guard files
+  // that are not ordered by trip
+  std::array<std::mutex, TRIP_LOCK_COUNT> trip_locks;
+  std::vector<std::size_t> row_counts(chunks.size());
+  std::vector<std::exception_ptr> errors(chunks.size());
+  std::vector<std::size_t> chunk_indices(chunks.size());
+  std::iota(begin(chunk_indices), end(chunk_indices), 0U);
+
+  utl::parallel_for(
+      chunk_indices,
+      [&](std::size_t const chunk_idx) {
+        try {
+          auto pos = chunks[chunk_idx].first;
+          auto const to = chunks[chunk_idx].second;
+
+          row_t row;
+          std::deque<std::string> unescaped;
+          std::string last_trip_id;  // fields may point into unescaped
+          trip* t = nullptr;
+          auto rows = std::size_t{0U};
+          while (pos < to) {
+            auto const line = next_line(content, pos);
+            if (line.empty()) {
+              continue;
+            }
+            read_row(line, field_to_column, row, unescaped);
+
+            if (t == nullptr || row[trip_id] != last_trip_id) {
+              t = lookup(trip_index, row[trip_id], "trip");
+              last_trip_id = row[trip_id];
+            }
+
+            std::lock_guard<std::mutex> lock{
+                trip_locks[(reinterpret_cast<std::uintptr_t>(t) >> 4U) %
+                           TRIP_LOCK_COUNT]};
+            t->stop_times_.emplace(
+                to_int(row[stop_sequence]),  // index
+                lookup(stop_index, row[stop_id], "stop"),
+                std::string{row[stop_headsign]},
+                hhmm_to_min(to_cstr(row[arrival_time])),
+                to_int(row[drop_off_type]) == 0,
+                hhmm_to_min(to_cstr(row[departure_time])),
+                to_int(row[pickup_type]) == 0);
+            ++rows;
+          }
+          row_counts[chunk_idx] = rows;
+        } catch (...) {
+          errors[chunk_idx] = std::current_exception();
+        }
+      },
+      utl::parallel_error_strategy::CONTINUE_EXEC);
+
+  for (auto const& e : errors) {
+    if (e) {
+      std::rethrow_exception(e);
+    }
   }
+  return std::accumulate(begin(row_counts), end(row_counts), std::size_t{0U});
 }
 
 }  // namespace gtfs
@@ -1,5 +1,11 @@
 #include "motis/loader/hrd/hrd_parser.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 #include "motis/core/common/logging.h"
 
 #include "motis/schedule-format/Schedule_generated.h"
@@ -113,23 +119,129 @@ loaded_file load(fs::path const& root, filename_key k,
   return loaded_file(root / *it);
 }
 
+struct parsed_file {
+  bool done_{false};
+  std::vector<hrd_service> services_;
+  std::exception_ptr error_;
+};
+
+// Loading, tokenising and expanding (for_each_service) the files runs on
+// worker threads. The builders deduplicate routes, lines, attributes, etc.
+// by their offset in the one FlatBufferBuilder, so the services are built
+// on the calling thread in file order - the schedule is byte-identical to
+// the sequential one. Workers stay at most 2 * num_threads files ahead of
+// the builder to bound the memory held by parsed services.
 void parse_and_build_services(
     fs::path const& hrd_root, std::map<int, bitfield> const& bitfields,
     std::vector<std::unique_ptr<loaded_file>>& schedule_data,
     std::function<void(hrd_service const&)> const& service_builder_fun,
-    config const& c) {
+    config const& c, unsigned const num_threads) {
   auto const schedule_data_root = hrd_root / SCHEDULE_DATA;
 
   std::vector<fs::path> files;
   collect_files(schedule_data_root, files);
 
-  int count = 0;
-  for (auto const& file : files) {
-    schedule_data.emplace_back(std::make_unique<loaded_file>(file));
-    LOG(info) << "parsing " << ++count << "/" << files.size() << " "
-              << schedule_data.back()->name();
-    for_each_service(*schedule_data.back(), bitfields, service_builder_fun, c);
+  if (num_threads <= 1 || files.size() <= 1) {
+    int count = 0;
+    for (auto const& file : files) {
+      schedule_data.emplace_back(std::make_unique<loaded_file>(file));
+      LOG(info) << "parsing " << ++count << "/" << files.size() << " "
+                << schedule_data.back()->name();
+      for_each_service(*schedule_data.back(), bitfields, service_builder_fun,
+                       c);
+    }
+    return;
+  }
+
+  auto const offset = schedule_data.size();
+  schedule_data.resize(offset + files.size());
+
+  std::vector<parsed_file> parsed(files.size());
+  std::mutex mutex;
+  std::condition_variable cv;
+  auto next = std::size_t{0U}, built = std::size_t{0U};
+  auto const window = 2U * num_threads;
+
+  auto const parse_files = [&]() {
+    while (true) {
+      std::size_t idx;
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+        cv.wait(lock, [&]() {
+          return next == files.size() || next < built + window;
+        });
+        if (next == files.size()) {
+          return;
+        }
+        idx = next++;
+      }
+
+      auto& p = parsed[idx];
+      try {
+        auto file = std::make_unique<loaded_file>(files[idx]);
+        for_each_service(
+            *file, bitfields,
+            [&p](hrd_service const& s) { p.services_.push_back(s); }, c);
+        schedule_data[offset + idx] = std::move(file);
+      } catch (...) {
+        p.error_ = std::current_exception();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        p.done_ = true;
+      }
+      cv.notify_all();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  auto const num_workers =
+      std::min(static_cast<std::size_t>(num_threads), files.size());
+  for (auto i = 0U; i < num_workers; ++i) {
+    workers.emplace_back(parse_files);
+  }
+
+  auto const stop = [&]() {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      next = files.size();
+    }
+    cv.notify_all();
+    for (auto& w : workers) {
+      w.join();
+    }
+  };
+
+  try {
+    for (auto i = 0U; i < files.size(); ++i) {
+      auto& p = parsed[i];
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+        cv.wait(lock, [&]() { return p.done_; });
+      }
+      if (p.error_) {
+        std::rethrow_exception(p.error_);
+      }
+
+      LOG(info) << "parsing " << i + 1 << "/" << files.size() << " "
+                << schedule_data[offset + i]->name();
+      for (auto const& s : p.services_) {
+        service_builder_fun(s);
+      }
+      p.services_ = std::vector<hrd_service>{};
+
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        ++built;
+      }
+      cv.notify_all();
+    }
+  } catch (...) {
+    stop();
+    throw;
   }
+  stop();
 }
 
 void hrd_parser::parse(fs::path const& hrd_root, FlatBufferBuilder& fbb) {
@@ -212,7 +324,7 @@ void hrd_parser::parse(fs::path const& hrd_root, FlatBufferBuilder& fbb,
                                                  db, fbb, false);
                              }
                            },
-                           c);
+                           c, num_threads_);
 
   // compute and build rule services
   rsb.resolve_rule_services();
@@ -14,6 +14,8 @@
 
 #include "parser/file.h"
 
+#include "tar/mmap_reader.h"
+
 #include "motis/core/common/logging.h"
 #include "motis/loader/build_graph.h"
 #include "motis/loader/gtfs/gtfs_parser.h"
@@ -43,33 +45,44 @@ schedule_ptr load_schedule(loader_options const& opt) {
   std::tie(from, to) = opt.interval();
   auto binary_schedule_file = fs::path(opt.dataset_) / SCHEDULE_FILE;
 
-  if (fs::is_regular_file(binary_schedule_file)) {
-    auto buf = file(binary_schedule_file.string().c_str(), "r").content();
-    return build_graph(GetSchedule(buf.buf_), from, to, opt.unique_check_,
-                       opt.apply_rules_, opt.adjust_footpaths_);
-  } else {
-    for (auto const& parser : parsers()) {
-      if (parser->applicable(opt.dataset_)) {
-        FlatBufferBuilder builder;
-        parser->parse(opt.dataset_, builder);
-        if (opt.write_serialized_) {
-          parser::file(binary_schedule_file.string().c_str(), "w+")
-              .write(builder.GetBufferPointer(), builder.GetSize());
-        }
-        return build_graph(GetSchedule(builder.GetBufferPointer()), from, to,
-                           opt.unique_check_, opt.apply_rules_,
-                           opt.adjust_footpaths_);
+  auto const has_binary_schedule = fs::is_regular_file(binary_schedule_file);
+  if (has_binary_schedule && fs::file_size(binary_schedule_file) == 0U) {
+    LOG(warn) << "ignoring empty " << binary_schedule_file;
+  } else if (has_binary_schedule) {
+    // Read-only mapping instead of a heap copy: the pages are backed by the
+    // page cache (shared between processes loading the same dataset).
+    // Only the parser output is mapped: the graph is still built on every
+    // start. TODO: serialize the built schedule (nodes, edges, connections,
+    // trips, lower bound graphs) as a relocatable image and map that.
+    tar::mmap_reader mapping(binary_schedule_file.string().c_str());
+    LOG(info) << "mapped " << binary_schedule_file << " ("
+              << mapping.m_.size() << " bytes)";
+    return build_graph(GetSchedule(mapping.m_.fmap_), from, to,
+                       opt.unique_check_, opt.apply_rules_,
+                       opt.adjust_footpaths_);
+  }
+
+  for (auto const& parser : parsers()) {
+    if (parser->applicable(opt.dataset_)) {
+      FlatBufferBuilder builder;
+      parser->parse(opt.dataset_, builder);
+      if (opt.write_serialized_) {
+        parser::file(binary_schedule_file.string().c_str(), "w+")
+            .write(builder.GetBufferPointer(), builder.GetSize());
       }
+      return build_graph(GetSchedule(builder.GetBufferPointer()), from, to,
+                         opt.unique_check_, opt.apply_rules_,
+                         opt.adjust_footpaths_);
     }
+  }
 
-    for (auto const& parser : parsers()) {
-      std::cout << "missing files:\n";
-      for (auto const& file : parser->missing_files(opt.dataset_)) {
-        std::cout << "  " << file << "\n";
-      }
+  for (auto const& parser : parsers()) {
+    std::cout << "missing files:\n";
+    for (auto const& file : parser->missing_files(opt.dataset_)) {
+      std::cout << "  " << file << "\n";
     }
-    throw std::runtime_error("no parser was applicable");
   }
+  throw std::runtime_error("no parser was applicable");
 }
 
 }  // namespace loader
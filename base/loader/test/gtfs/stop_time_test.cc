@@ -67,6 +67,65 @@ TEST(loader_gtfs_route, read_stop_times_example_data) {
   EXPECT_TRUE(stop.dep_.in_out_allowed_);
 }
 
+TEST(loader_gtfs_route, read_stop_times_unordered_quoted) {
+  stop_map stops;
+  stops.emplace("S1", std::make_unique<stop>("S1", "Stop 1", 0.0, 0.0));
+  stops.emplace("S2", std::make_unique<stop>("S2", "Stop 2", 0.0, 0.0));
+
+  trip_map trips;
+  trips.emplace("T1", std::make_unique<trip>(nullptr, nullptr, ""));
+  trips.emplace("T2", std::make_unique<trip>(nullptr, nullptr, ""));
+
+  auto const content =
+      "\xEF\xBB\xBFstop_id,trip_id,stop_sequence,stop_headsign,"
+      "arrival_time,departure_time,drop_off_type\r\n"
+      "S2,T1,2,\"A, B\",10:05:00,10:06:00,1\r\n"
+      "S1,T2,1,,,11:00:00,0\r\n"
+      "S1,T1,1,,,10:00:00,0\r\n"
+      "S2,T2,2,,11:30:00,,0";
+  EXPECT_EQ(4U, read_stop_times(std::string_view{content}, trips, stops));
+
+  auto& t1 = trips.at("T1")->stop_times_;
+  EXPECT_EQ("S1", t1[1].stop_->id_);
+  EXPECT_EQ(600, t1[1].dep_.time_);
+  EXPECT_EQ(-1, t1[1].arr_.time_);
+  EXPECT_EQ("S2", t1[2].stop_->id_);
+  EXPECT_EQ("A, B", t1[2].headsign_);
+  EXPECT_EQ(605, t1[2].arr_.time_);
+  EXPECT_FALSE(t1[2].arr_.in_out_allowed_);
+  EXPECT_TRUE(t1[2].dep_.in_out_allowed_);
+
+  auto& t2 = trips.at("T2")->stop_times_;
+  EXPECT_EQ(660, t2[1].dep_.time_);
+  EXPECT_EQ(690, t2[2].arr_.time_);
+
+  trips.emplace("T3", std::make_unique<trip>(nullptr, nullptr, ""));
+  EXPECT_THROW(read_stop_times(std::string_view{"trip_id,stop_id\nT3,S3\n"},
+                               trips, stops),
+               std::out_of_range);
+}
+
+TEST(loader_gtfs_route, read_stop_times_escaped_quotes) {
+  stop_map stops;
+  stops.emplace("S1", std::make_unique<stop>("S1", "Stop 1", 0.0, 0.0));
+  stops.emplace("S2", std::make_unique<stop>("S2", "Stop 2", 0.0, 0.0));
+
+  trip_map trips;
+  trips.emplace("T\"1\"", std::make_unique<trip>(nullptr, nullptr, ""));
+
+  auto const content =
+      "trip_id,stop_id,stop_sequence,stop_headsign,departure_time\n"
+      "\"T\"\"1\"\"\",S1,1,\"to \"\"B\"\", via \"\"C\"\"\",10:00:00\n"
+      "\"T\"\"1\"\"\",S2,2,\"\"\"\",10:10:00\n";
+  EXPECT_EQ(2U, read_stop_times(std::string_view{content}, trips, stops));
+
+  auto& t = trips.at("T\"1\"")->stop_times_;
+  EXPECT_EQ("to \"B\", via \"C\"", t[1].headsign_);
+  EXPECT_EQ(600, t[1].dep_.time_);
+  EXPECT_EQ("S2", t[2].stop_->id_);
+  EXPECT_EQ("\"", t[2].headsign_);
+}
+
 }  // namespace gtfs
 }  // namespace loader
 }  // namespace motis
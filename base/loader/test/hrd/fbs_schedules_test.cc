@@ -1,9 +1,12 @@
 #include <cinttypes>
+#include <cstring>
 #include <iostream>
 #include <string>
 
 #include "gtest/gtest.h"
 
+#include "boost/filesystem.hpp"
+
 #include "motis/loader/bitfield.h"
 #include "motis/loader/hrd/hrd_parser.h"
 #include "motis/schedule-format/Schedule_generated.h"
@@ -139,6 +142,27 @@ TEST(loader_hrd_fbs_services, directions_and_providers) {
   }
 }
 
+TEST(loader_hrd_fbs_services, parallel_parse_identical) {
+  auto count = 0U;
+  for (auto const& entry : boost::filesystem::directory_iterator(SCHEDULES)) {
+    hrd_parser sequential{1U}, parallel{4U};
+    if (!sequential.applicable(entry.path())) {
+      continue;
+    }
+
+    FlatBufferBuilder seq_fbb, par_fbb;
+    sequential.parse(entry.path(), seq_fbb);
+    parallel.parse(entry.path(), par_fbb);
+
+    ASSERT_EQ(seq_fbb.GetSize(), par_fbb.GetSize()) << entry.path();
+    EXPECT_EQ(0, std::memcmp(seq_fbb.GetBufferPointer(),
+                             par_fbb.GetBufferPointer(), seq_fbb.GetSize()))
+        << entry.path();
+    ++count;
+  }
+  EXPECT_NE(0U, count);
+}
+
 }  // namespace hrd
 }  // namespace loader
 }  // namespace motis
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flatbuffers/idl.h"
+
+#include "motis/module/json.h"
+#include "motis/module/message.h"
+
+#include "motis/protocol/resources.h"
+
+#undef GetMessage
+
+using namespace motis::module;
+
+// Compares the schema specialised JSON codec (motis/module/json.h) with the
+// flatbuffers reflection path (flatbuffers::Parser + GenerateText).
+// Usage: motis-json-benchmark [file with one JSON message per line]
+// e.g. batch mode queries or (compact) batch mode responses.
+
+auto const sample = R"({"destination":{"type":"Module","target":"/routing"},)"
+                    R"("content_type":"RoutingRequest","content":{)"
+                    R"("start_type":"PretripStart","start":{"station":{)"
+                    R"("name":"","id":"8000096"},"interval":{)"
+                    R"("begin":1444896228,"end":1444899228}},)"
+                    R"("destination":{"name":"","id":"8000105"},)"
+                    R"("additional_edges":[],"via":[]}})";
+
+std::unique_ptr<flatbuffers::Parser> reflection_parser(bool const compact) {
+  auto parser = std::make_unique<flatbuffers::Parser>();
+  parser->opts.strict_json = true;
+  parser->opts.skip_unexpected_fields_in_json = true;
+  if (compact) {
+    parser->opts.indent_step = -1;
+  }
+  auto message_symbol_index = -1;
+  for (auto i = 0U; i < number_of_symbols; ++i) {
+    if (std::strcmp(filenames[i], "Message.fbs") == 0) {  // NOLINT
+      message_symbol_index = static_cast<int>(i);
+    } else if (!parser->Parse(symbols[i], nullptr, filenames[i])) {  // NOLINT
+      throw std::runtime_error(parser->error_);
+    }
+  }
+  if (message_symbol_index == -1 ||
+      !parser->Parse(symbols[message_symbol_index])) {  // NOLINT
+    throw std::runtime_error(parser->error_);
+  }
+  return parser;
+}
+
+template <typename Fn>
+double measure(Fn&& fn) {
+  auto const start = std::chrono::steady_clock::now();
+  fn();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+void print(char const* name, std::size_t const count, std::size_t const bytes,
+           double const seconds) {
+  std::cout << name << ": " << count << " messages, " << seconds << "s, "
+            << static_cast<double>(count) / seconds << " msg/s, "
+            << static_cast<double>(bytes) / seconds / 1e6 << " MB/s\n";
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> inputs;
+  if (argc > 1) {
+    std::ifstream in(argv[1]);  // NOLINT
+    std::string line;
+    while (std::getline(in, line)) {
+      if (!line.empty()) {
+        inputs.emplace_back(line);
+      }
+    }
+  } else {
+    inputs.assign(100000, sample);
+  }
+
+  auto bytes = 0ULL;
+  for (auto const& json : inputs) {
+    bytes += json.size();
+  }
+
+  auto parser = reflection_parser(true);
+  std::vector<msg_ptr> msgs;
+  msgs.reserve(inputs.size());
+
+  print("decode reflection", inputs.size(), bytes, measure([&]() {
+          for (auto const& json : inputs) {
+            if (!parser->Parse(json.c_str())) {
+              throw std::runtime_error(parser->error_);
+            }
+            msgs.emplace_back(std::make_shared<message>(
+                parser->builder_.GetSize(),
+                parser->builder_.ReleaseBufferPointer()));
+            parser->builder_.Clear();
+          }
+        }));
+
+  auto unsupported = 0U;
+  print("decode codec", inputs.size(), bytes, measure([&]() {
+          for (auto const& json : inputs) {
+            unsupported += read_json(json) ? 0U : 1U;
+          }
+        }));
+  if (unsupported != 0U) {
+    std::cout << "  (" << unsupported
+              << " messages need the parser fallback)\n";
+  }
+
+  std::string out;
+  print("encode reflection", msgs.size(), bytes, measure([&]() {
+          for (auto const& msg : msgs) {
+            out.clear();
+            flatbuffers::GenerateText(*parser, msg->data(), &out);
+          }
+        }));
+
+  print("encode codec", msgs.size(), bytes, measure([&]() {
+          for (auto const& msg : msgs) {
+            out.clear();
+            write_json(*msg, out);
+          }
+        }));
+
+  auto const threads = std::max(1U, std::thread::hardware_concurrency());
+  print("decode codec (all threads)", inputs.size() * threads, bytes * threads,
+        measure([&]() {
+          std::vector<std::thread> workers;
+          for (auto t = 0U; t < threads; ++t) {
+            workers.emplace_back([&]() {
+              for (auto const& json : inputs) {
+                read_json(json);
+              }
+            });
+          }
+          for (auto& w : workers) {
+            w.join();
+          }
+        }));
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+#include "motis/module/message.h"
+
+namespace motis {
+namespace module {
+
+// Schema specialised JSON codec.
+// The reflection schema of the protocol is compiled once into per type
+// field tables (ordered keys, pre-quoted names, enum names, union
+// members). Encoding and decoding only read these immutable tables: no
+// flatbuffers::Parser and no shared mutable state is involved, so both
+// scale across threads.
+
+// Appends the compact JSON representation of the message to `out`.
+// `out` can be reused between calls to avoid reallocations.
+void write_json(message const&, std::string& out);
+
+// Builds the message directly from JSON (SAX style, without an
+// intermediate document). Returns nullptr for input outside the supported
+// subset (e.g. a union value preceding its type, or malformed JSON) -
+// make_msg() then falls back to the flatbuffers parser, which also
+// produces the error message.
+msg_ptr read_json(std::string const& json);
+
+}  // namespace module
+}  // namespace motis
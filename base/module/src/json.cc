@@ -0,0 +1,892 @@
+#include "motis/module/json.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+#include "flatbuffers/reflection.h"
+
+#undef GetMessage
+
+using namespace flatbuffers;
+using reflection::BaseType;
+
+namespace motis {
+namespace module {
+
+namespace {
+
+bool is_float(BaseType const t) {
+  return t == reflection::Float || t == reflection::Double;
+}
+
+struct enum_info {
+  char const* name(int64_t const value) const {
+    auto const it = std::lower_bound(
+        begin(names_), end(names_), value,
+        [](auto const& entry, int64_t const v) { return entry.first < v; });
+    return (it != end(names_) && it->first == value) ? it->second.c_str()
+                                                      : nullptr;
+  }
+
+  std::vector<std::pair<int64_t, std::string>> names_;  // sorted by value
+  std::map<std::string, int64_t, std::less<>> values_;
+  std::map<int64_t, int> union_objects_;  // union type -> object index
+};
+
+struct field_info {
+  std::string name_;
+  std::string key_;  // "name" and ": "
+  voffset_t offset_{0U};  // vtable offset (table) / byte offset (struct)
+  uint16_t id_{0U};
+  BaseType type_{reflection::None}, element_{reflection::None};
+  int index_{-1};  // object or enum index
+  int64_t default_integer_{0};
+  double default_real_{0.0};
+  int union_type_field_{-1};  // union value: position of its _type field
+};
+
+struct object_info {
+  std::vector<field_info> fields_;  // ordered by id (= definition order)
+  std::map<std::string, std::size_t, std::less<>> by_name_;
+  bool is_struct_{false};
+  int bytesize_{0}, minalign_{1};
+  voffset_t numfields_{0U};
+};
+
+struct codec {
+  explicit codec(reflection::Schema const& schema) {
+    std::map<std::string, int> object_idx;
+    for (auto i = 0U; i < schema.objects()->size(); ++i) {
+      object_idx[schema.objects()->Get(i)->name()->str()] = static_cast<int>(i);
+    }
+
+    for (auto const* e : *schema.enums()) {
+      enum_info info;
+      for (auto const* v : *e->values()) {
+        info.names_.emplace_back(v->value(), v->name()->str());
+        info.values_[v->name()->str()] = v->value();
+        if (e->is_union() && v->object() != nullptr) {
+          info.union_objects_[v->value()] =
+              object_idx.at(v->object()->name()->str());
+        }
+      }
+      std::sort(begin(info.names_), end(info.names_));
+      enums_.emplace_back(std::move(info));
+    }
+
+    for (auto const* o : *schema.objects()) {
+      object_info info;
+      info.is_struct_ = o->is_struct();
+      info.bytesize_ = o->bytesize();
+      info.minalign_ = std::max(1, o->minalign());
+      for (auto const* f : *o->fields()) {
+        info.numfields_ =
+            std::max(info.numfields_, static_cast<voffset_t>(f->id() + 1));
+        if (f->deprecated()) {
+          continue;
+        }
+
+        field_info fi;
+        fi.name_ = f->name()->str();
+        fi.key_ = "\"" + fi.name_ + "\": ";
+        fi.offset_ = f->offset();
+        fi.id_ = f->id();
+        fi.type_ = f->type()->base_type();
+        fi.element_ = f->type()->element();
+        fi.index_ = f->type()->index();
+        fi.default_integer_ = f->default_integer();
+        fi.default_real_ = f->default_real();
+        info.fields_.emplace_back(std::move(fi));
+      }
+
+      std::sort(begin(info.fields_), end(info.fields_),
+                [](auto const& a, auto const& b) { return a.id_ < b.id_; });
+      for (auto i = 0U; i < info.fields_.size(); ++i) {
+        info.by_name_[info.fields_[i].name_] = i;
+      }
+      for (auto& f : info.fields_) {
+        if (f.type_ == reflection::Union) {
+          auto const it = info.by_name_.find(f.name_ + "_type");
+          if (it != end(info.by_name_)) {
+            f.union_type_field_ = static_cast<int>(it->second);
+          }
+        }
+      }
+      objects_.emplace_back(std::move(info));
+    }
+
+    root_ = object_idx.at(schema.root_table()->name()->str());
+  }
+
+  std::vector<object_info> objects_;
+  std::vector<enum_info> enums_;
+  int root_{0};
+};
+
+codec const& get_codec() {
+  static codec const c{message::get_schema()};
+  return c;
+}
+
+struct scalar_value {
+  int64_t i_{0};
+  double d_{0.0};
+};
+
+int64_t read_integer(BaseType const t, uint8_t const* p) {
+  switch (t) {
+    case reflection::Byte: return ReadScalar<int8_t>(p);
+    case reflection::Short: return ReadScalar<int16_t>(p);
+    case reflection::UShort: return ReadScalar<uint16_t>(p);
+    case reflection::Int: return ReadScalar<int32_t>(p);
+    case reflection::UInt: return ReadScalar<uint32_t>(p);
+    case reflection::Long:
+    case reflection::ULong: return ReadScalar<int64_t>(p);
+    default: return ReadScalar<uint8_t>(p);
+  }
+}
+
+template <typename T>
+bool in_range(int64_t const v) {
+  return v >= static_cast<int64_t>(std::numeric_limits<T>::min()) &&
+         v <= static_cast<int64_t>(std::numeric_limits<T>::max());
+}
+
+// Long and ULong are range checked by strtoll / strtoull.
+bool fits(BaseType const t, int64_t const v) {
+  switch (t) {
+    case reflection::Byte: return in_range<int8_t>(v);
+    case reflection::Short: return in_range<int16_t>(v);
+    case reflection::UShort: return in_range<uint16_t>(v);
+    case reflection::Int: return in_range<int32_t>(v);
+    case reflection::UInt: return in_range<uint32_t>(v);
+    case reflection::Long:
+    case reflection::ULong: return true;
+    default: return in_range<uint8_t>(v);
+  }
+}
+
+// Decodes one UTF-8 sequence, returns -1 if it is invalid.
+int32_t decode_utf8(char const* s, std::size_t const len, std::size_t& i) {
+  auto const c = static_cast<unsigned char>(s[i]);  // NOLINT
+  auto const n = c >= 0xF0U ? 3U : c >= 0xE0U ? 2U : c >= 0xC0U ? 1U : 0U;
+  if (n == 0U || c >= 0xF8U || i + n >= len) {
+    return -1;
+  }
+  auto cp = static_cast<uint32_t>(c & (0x3FU >> n));
+  for (auto k = 1U; k <= n; ++k) {
+    auto const cc = static_cast<unsigned char>(s[i + k]);  // NOLINT
+    if ((cc & 0xC0U) != 0x80U) {
+      return -1;
+    }
+    cp = (cp << 6U) | (cc & 0x3FU);
+  }
+  i += n;
+  return cp > 0x10FFFFU ? -1 : static_cast<int32_t>(cp);
+}
+
+void store(BaseType const t, scalar_value const v, uint8_t* dst) {
+  switch (t) {
+    case reflection::Byte: WriteScalar<int8_t>(dst, v.i_); break;
+    case reflection::Short: WriteScalar<int16_t>(dst, v.i_); break;
+    case reflection::UShort: WriteScalar<uint16_t>(dst, v.i_); break;
+    case reflection::Int: WriteScalar<int32_t>(dst, v.i_); break;
+    case reflection::UInt: WriteScalar<uint32_t>(dst, v.i_); break;
+    case reflection::Long: WriteScalar<int64_t>(dst, v.i_); break;
+    case reflection::ULong: WriteScalar<uint64_t>(dst, v.i_); break;
+    case reflection::Float: WriteScalar<float>(dst, v.d_); break;
+    case reflection::Double: WriteScalar<double>(dst, v.d_); break;
+    default: WriteScalar<uint8_t>(dst, v.i_); break;
+  }
+}
+
+struct json_writer {
+  void write_hex4(uint32_t const v) {
+    char buf[8];
+    std::snprintf(buf, sizeof(buf), "\\u%04X", v);  // NOLINT
+    out_ += buf;  // NOLINT
+  }
+
+  // Escapes like flatbuffers GenerateText: printable ASCII is copied,
+  // everything else is written as \uXXXX (surrogate pairs above U+FFFF).
+  void write_string(char const* s, std::size_t const len) {
+    out_ += '"';
+    for (auto i = std::size_t{0U}; i < len; ++i) {
+      auto const c = s[i];  // NOLINT
+      switch (c) {
+        case '"': out_ += "\\\""; break;
+        case '\\': out_ += "\\\\"; break;
+        case '\n': out_ += "\\n"; break;
+        case '\r': out_ += "\\r"; break;
+        case '\t': out_ += "\\t"; break;
+        case '\b': out_ += "\\b"; break;
+        case '\f': out_ += "\\f"; break;
+        default:
+          if (c >= ' ' && c <= '~') {
+            out_ += c;
+          } else if (static_cast<unsigned char>(c) < 0x80U) {
+            write_hex4(static_cast<uint32_t>(c));
+          } else if (auto const cp = decode_utf8(s, len, i); cp < 0) {
+            write_hex4(0xFFFDU);  // invalid UTF-8
+          } else if (cp <= 0xFFFF) {
+            write_hex4(static_cast<uint32_t>(cp));
+          } else {
+            auto const u = static_cast<uint32_t>(cp) - 0x10000U;
+            write_hex4(0xD800U + (u >> 10U));
+            write_hex4(0xDC00U + (u & 0x3FFU));
+          }
+      }
+    }
+    out_ += '"';
+  }
+
+  // Fixed notation like flatbuffers FloatToString (12 digits for double, 6
+  // for float) without trailing zeros. JSON has no NaN / infinity: null.
+  void write_float(double const v, int const precision) {
+    if (!std::isfinite(v)) {
+      out_ += "null";
+      return;
+    }
+    char buf[512];
+    auto const n = std::snprintf(buf, sizeof(buf), "%.*f",  // NOLINT
+                                 precision, v);
+    std::string_view str{buf, static_cast<std::size_t>(n)};  // NOLINT
+    auto const last = str.find_last_not_of('0');
+    str = str.substr(0, last + (str[last] == '.' ? 2U : 1U));
+    out_ += str;
+  }
+
+  void write_scalar(BaseType const t, int const enum_idx,
+                    uint8_t const* p) {
+    if (t == reflection::Bool) {
+      out_ += ReadScalar<uint8_t>(p) != 0U ? "true" : "false";
+    } else if (t == reflection::Float) {
+      write_float(ReadScalar<float>(p), 6);
+    } else if (t == reflection::Double) {
+      write_float(ReadScalar<double>(p), 12);
+    } else {
+      auto const v = read_integer(t, p);
+      if (enum_idx != -1) {
+        if (auto const name = c_.enums_[enum_idx].name(v); name != nullptr) {
+          out_ += '"';
+          out_ += name;
+          out_ += '"';
+          return;
+        }
+      }
+      out_ += t == reflection::ULong ? std::to_string(static_cast<uint64_t>(v))
+                                     : std::to_string(v);
+    }
+  }
+
+  void write_struct(object_info const& o, uint8_t const* s) {
+    out_ += '{';
+    auto first = true;
+    for (auto const& f : o.fields_) {
+      if (!first) {
+        out_ += ',';
+      }
+      first = false;
+      out_ += f.key_;
+      if (f.type_ == reflection::Obj) {
+        write_struct(c_.objects_[f.index_], s + f.offset_);  // NOLINT
+      } else {
+        write_scalar(f.type_, f.index_, s + f.offset_);  // NOLINT
+      }
+    }
+    out_ += '}';
+  }
+
+  void write_element(field_info const& f, uint8_t const* p) {
+    auto const target = [p]() { return p + ReadScalar<uoffset_t>(p); };
+    switch (f.element_) {
+      case reflection::String: {
+        auto const s = reinterpret_cast<String const*>(target());
+        write_string(s->c_str(), s->size());
+        break;
+      }
+      case reflection::Obj: {
+        auto const& sub = c_.objects_[f.index_];
+        if (sub.is_struct_) {
+          write_struct(sub, p);
+        } else {
+          write_table(sub, reinterpret_cast<Table const*>(target()));
+        }
+        break;
+      }
+      default: write_scalar(f.element_, f.index_, p);
+    }
+  }
+
+  void write_vector(field_info const& f, uint8_t const* vec) {
+    auto const size = ReadScalar<uoffset_t>(vec);
+    auto const data = vec + sizeof(uoffset_t);  // NOLINT
+
+    auto stride = sizeof(uoffset_t);
+    if (f.element_ == reflection::Obj && c_.objects_[f.index_].is_struct_) {
+      stride = static_cast<std::size_t>(c_.objects_[f.index_].bytesize_);
+    } else if (f.element_ != reflection::String &&
+               f.element_ != reflection::Obj) {
+      stride = GetTypeSize(f.element_);
+    }
+
+    out_ += '[';
+    for (auto i = 0U; i < size; ++i) {
+      if (i != 0U) {
+        out_ += ',';
+      }
+      write_element(f, data + i * stride);  // NOLINT
+    }
+    out_ += ']';
+  }
+
+  void write_table(object_info const& o, Table const* t) {
+    out_ += '{';
+    auto first = true;
+    for (auto const& f : o.fields_) {
+      if (t->GetOptionalFieldOffset(f.offset_) == 0U) {
+        continue;
+      }
+
+      object_info const* union_member = nullptr;
+      if (f.type_ == reflection::Union) {
+        if (f.union_type_field_ == -1) {
+          continue;
+        }
+        auto const type = t->GetField<uint8_t>(
+            o.fields_[f.union_type_field_].offset_, 0U);
+        auto const& members = c_.enums_[f.index_].union_objects_;
+        auto const it = members.find(type);
+        if (it == end(members)) {
+          continue;
+        }
+        union_member = &c_.objects_[it->second];
+      }
+
+      if (!first) {
+        out_ += ',';
+      }
+      first = false;
+      out_ += f.key_;
+
+      switch (f.type_) {
+        case reflection::Union:
+          write_table(*union_member, t->GetPointer<Table const*>(f.offset_));
+          break;
+        case reflection::String: {
+          auto const s = t->GetPointer<String const*>(f.offset_);
+          write_string(s->c_str(), s->size());
+          break;
+        }
+        case reflection::Obj: {
+          auto const& sub = c_.objects_[f.index_];
+          if (sub.is_struct_) {
+            write_struct(sub, t->GetStruct<uint8_t const*>(f.offset_));
+          } else {
+            write_table(sub, t->GetPointer<Table const*>(f.offset_));
+          }
+          break;
+        }
+        case reflection::Vector:
+          write_vector(f, t->GetPointer<uint8_t const*>(f.offset_));
+          break;
+        default: write_scalar(f.type_, f.index_, t->GetAddressOf(f.offset_));
+      }
+    }
+    out_ += '}';
+  }
+
+  codec const& c_;
+  std::string& out_;
+};
+
+struct json_reader {
+  struct unsupported {};  // malformed or outside the supported subset
+
+  struct pending {
+    field_info const* f_{nullptr};
+    scalar_value v_;
+    uoffset_t off_{0U};
+    std::vector<uint8_t> struct_;
+  };
+
+  void ws() {
+    while (p_ != end_ &&
+           (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+      ++p_;  // NOLINT
+    }
+  }
+
+  char peek() {
+    ws();
+    if (p_ == end_) {
+      throw unsupported{};
+    }
+    return *p_;
+  }
+
+  void expect(char const c) {
+    if (peek() != c) {
+      throw unsupported{};
+    }
+    ++p_;  // NOLINT
+  }
+
+  bool consume(char const c) {
+    if (peek() == c) {
+      ++p_;  // NOLINT
+      return true;
+    }
+    return false;
+  }
+
+  unsigned parse_hex4() {
+    if (end_ - p_ < 4) {
+      throw unsupported{};
+    }
+    auto v = 0U;
+    for (auto i = 0; i < 4; ++i) {
+      auto const c = *p_++;  // NOLINT
+      v <<= 4U;
+      if (c >= '0' && c <= '9') {
+        v |= static_cast<unsigned>(c - '0');
+      } else if (c >= 'a' && c <= 'f') {
+        v |= static_cast<unsigned>(c - 'a' + 10);
+      } else if (c >= 'A' && c <= 'F') {
+        v |= static_cast<unsigned>(c - 'A' + 10);
+      } else {
+        throw unsupported{};
+      }
+    }
+    return v;
+  }
+
+  static void append_utf8(std::string& s, unsigned const cp) {
+    if (cp < 0x80U) {
+      s += static_cast<char>(cp);
+    } else if (cp < 0x800U) {
+      s += static_cast<char>(0xC0U | (cp >> 6U));
+      s += static_cast<char>(0x80U | (cp & 0x3FU));
+    } else if (cp < 0x10000U) {
+      s += static_cast<char>(0xE0U | (cp >> 12U));
+      s += static_cast<char>(0x80U | ((cp >> 6U) & 0x3FU));
+      s += static_cast<char>(0x80U | (cp & 0x3FU));
+    } else {
+      s += static_cast<char>(0xF0U | (cp >> 18U));
+      s += static_cast<char>(0x80U | ((cp >> 12U) & 0x3FU));
+      s += static_cast<char>(0x80U | ((cp >> 6U) & 0x3FU));
+      s += static_cast<char>(0x80U | (cp & 0x3FU));
+    }
+  }
+
+  std::string parse_string() {
+    expect('"');
+    std::string s;
+    while (true) {
+      if (p_ == end_) {
+        throw unsupported{};
+      }
+      auto const c = *p_++;  // NOLINT
+      if (c == '"') {
+        return s;
+      } else if (static_cast<unsigned char>(c) < 0x20U) {
+        throw unsupported{};
+      } else if (c != '\\') {
+        s += c;
+        continue;
+      }
+
+      if (p_ == end_) {
+        throw unsupported{};
+      }
+      switch (*p_++) {  // NOLINT
+        case '"': s += '"'; break;
+        case '\\': s += '\\'; break;
+        case '/': s += '/'; break;
+        case 'b': s += '\b'; break;
+        case 'f': s += '\f'; break;
+        case 'n': s += '\n'; break;
+        case 'r': s += '\r'; break;
+        case 't': s += '\t'; break;
+        case 'u': {
+          auto cp = parse_hex4();
+          if (cp >= 0xD800U && cp <= 0xDBFFU) {
+            if (end_ - p_ < 2 || p_[0] != '\\' || p_[1] != 'u') {
+              throw unsupported{};
+            }
+            p_ += 2;  // NOLINT
+            auto const low = parse_hex4();
+            if (low < 0xDC00U || low > 0xDFFFU) {
+              throw unsupported{};
+            }
+            cp = 0x10000U + ((cp - 0xD800U) << 10U) + (low - 0xDC00U);
+          }
+          append_utf8(s, cp);
+          break;
+        }
+        default: throw unsupported{};
+      }
+    }
+  }
+
+  static bool is_literal_char(char const c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+           (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+  }
+
+  void skip_value() {
+    switch (peek()) {
+      case '"': parse_string(); break;
+      case '{':
+        ++p_;  // NOLINT
+        if (!consume('}')) {
+          do {
+            parse_string();
+            expect(':');
+            skip_value();
+          } while (consume(','));
+          expect('}');
+        }
+        break;
+      case '[':
+        ++p_;  // NOLINT
+        if (!consume(']')) {
+          do {
+            skip_value();
+          } while (consume(','));
+          expect(']');
+        }
+        break;
+      default: {
+        auto const start = p_;
+        while (p_ != end_ && is_literal_char(*p_)) {
+          ++p_;  // NOLINT
+        }
+        if (p_ == start) {
+          throw unsupported{};
+        }
+      }
+    }
+  }
+
+  bool consume_literal(char const* lit, std::size_t const len) {
+    if (static_cast<std::size_t>(end_ - p_) >= len &&
+        std::equal(lit, lit + len, p_) &&  // NOLINT
+        (static_cast<std::size_t>(end_ - p_) == len ||
+         !is_literal_char(p_[len]))) {  // NOLINT
+      p_ += len;  // NOLINT
+      return true;
+    }
+    return false;
+  }
+
+  scalar_value parse_scalar(BaseType const t, int const enum_idx) {
+    scalar_value v;
+    auto const c = peek();
+
+    if (c == '"') {
+      if (enum_idx == -1) {
+        throw unsupported{};
+      }
+      auto const& values = c_.enums_[enum_idx].values_;
+      auto const it = values.find(parse_string());
+      if (it == end(values)) {
+        throw unsupported{};
+      }
+      v.i_ = it->second;
+      v.d_ = static_cast<double>(v.i_);
+      return v;
+    }
+
+    if (t == reflection::Bool) {
+      if (consume_literal("true", 4)) {
+        v.i_ = 1;
+        return v;
+      } else if (consume_literal("false", 5)) {
+        return v;
+      }
+    }
+
+    char* num_end = nullptr;
+    errno = 0;
+    if (is_float(t)) {
+      v.d_ = std::strtod(p_, &num_end);
+    } else if (t == reflection::ULong) {
+      if (*p_ == '-') {
+        throw unsupported{};
+      }
+      v.i_ = static_cast<int64_t>(std::strtoull(p_, &num_end, 10));
+    } else {
+      v.i_ = std::strtoll(p_, &num_end, 10);
+    }
+    if (num_end == p_ || num_end > end_ ||
+        (num_end != end_ && is_literal_char(*num_end))) {
+      throw unsupported{};  // e.g. a float for an integer field
+    }
+    if (!is_float(t) && (errno == ERANGE || !fits(t, v.i_))) {
+      throw unsupported{};  // does not fit into the field
+    }
+    p_ = num_end;
+    return v;
+  }
+
+  void parse_struct(object_info const& o, uint8_t* dst) {
+    expect('{');
+    if (consume('}')) {
+      return;
+    }
+    do {
+      auto const it = o.by_name_.find(parse_string());
+      expect(':');
+      if (it == end(o.by_name_)) {
+        skip_value();
+        continue;
+      }
+      auto const& f = o.fields_[it->second];
+      if (f.type_ == reflection::Obj) {
+        parse_struct(c_.objects_[f.index_], dst + f.offset_);  // NOLINT
+      } else {
+        store(f.type_, parse_scalar(f.type_, f.index_),
+              dst + f.offset_);  // NOLINT
+      }
+    } while (consume(','));
+    expect('}');
+  }
+
+  uoffset_t parse_vector(field_info const& f) {
+    auto const* sub =
+        f.element_ == reflection::Obj ? &c_.objects_[f.index_] : nullptr;
+    auto count = 0U;
+
+    expect('[');
+
+    if (f.element_ == reflection::String ||
+        (sub != nullptr && !sub->is_struct_)) {
+      std::vector<uoffset_t> offsets;
+      if (!consume(']')) {
+        do {
+          offsets.emplace_back(f.element_ == reflection::String
+                                   ? fbb_.CreateString(parse_string()).o
+                                   : parse_table(*sub));
+        } while (consume(','));
+        expect(']');
+      }
+      fbb_.StartVector(offsets.size(), sizeof(uoffset_t));
+      for (auto it = offsets.rbegin(); it != offsets.rend(); ++it) {
+        fbb_.PushElement(Offset<void>(*it));
+      }
+      return fbb_.EndVector(offsets.size());
+    }
+
+    if (f.element_ == reflection::Union || f.element_ == reflection::Vector) {
+      throw unsupported{};
+    }
+
+    auto const elem_size = sub != nullptr
+                               ? static_cast<std::size_t>(sub->bytesize_)
+                               : GetTypeSize(f.element_);
+    auto const alignment = sub != nullptr
+                               ? static_cast<std::size_t>(sub->minalign_)
+                               : elem_size;
+    std::vector<uint8_t> bytes;
+    if (!consume(']')) {
+      do {
+        bytes.resize(bytes.size() + elem_size);
+        auto const dst = &bytes[bytes.size() - elem_size];
+        if (sub != nullptr) {
+          parse_struct(*sub, dst);
+        } else {
+          store(f.element_, parse_scalar(f.element_, f.index_), dst);
+        }
+        ++count;
+      } while (consume(','));
+      expect(']');
+    }
+    fbb_.StartVector(count * elem_size / alignment, alignment);
+    if (!bytes.empty()) {
+      fbb_.PushBytes(bytes.data(), bytes.size());
+    }
+    return fbb_.EndVector(count);
+  }
+
+  void add_scalar(field_info const& f, scalar_value const v) {
+    auto const def = f.default_integer_;
+    switch (f.type_) {
+      case reflection::Byte:
+        fbb_.AddElement<int8_t>(f.offset_, static_cast<int8_t>(v.i_),
+                                static_cast<int8_t>(def));
+        break;
+      case reflection::Short:
+        fbb_.AddElement<int16_t>(f.offset_, static_cast<int16_t>(v.i_),
+                                 static_cast<int16_t>(def));
+        break;
+      case reflection::UShort:
+        fbb_.AddElement<uint16_t>(f.offset_, static_cast<uint16_t>(v.i_),
+                                  static_cast<uint16_t>(def));
+        break;
+      case reflection::Int:
+        fbb_.AddElement<int32_t>(f.offset_, static_cast<int32_t>(v.i_),
+                                 static_cast<int32_t>(def));
+        break;
+      case reflection::UInt:
+        fbb_.AddElement<uint32_t>(f.offset_, static_cast<uint32_t>(v.i_),
+                                  static_cast<uint32_t>(def));
+        break;
+      case reflection::Long:
+        fbb_.AddElement<int64_t>(f.offset_, v.i_, def);
+        break;
+      case reflection::ULong:
+        fbb_.AddElement<uint64_t>(f.offset_, static_cast<uint64_t>(v.i_),
+                                  static_cast<uint64_t>(def));
+        break;
+      case reflection::Float:
+        fbb_.AddElement<float>(f.offset_, static_cast<float>(v.d_),
+                               static_cast<float>(f.default_real_));
+        break;
+      case reflection::Double:
+        fbb_.AddElement<double>(f.offset_, v.d_, f.default_real_);
+        break;
+      default:
+        fbb_.AddElement<uint8_t>(f.offset_, static_cast<uint8_t>(v.i_),
+                                 static_cast<uint8_t>(def));
+    }
+  }
+
+  uoffset_t parse_table(object_info const& o) {
+    std::vector<pending> fields;
+    auto const find = [&](field_info const* f) {
+      return std::find_if(begin(fields), end(fields),
+                          [&](pending const& p) { return p.f_ == f; });
+    };
+
+    expect('{');
+    if (!consume('}')) {
+      do {
+        auto const it = o.by_name_.find(parse_string());
+        expect(':');
+        if (it == end(o.by_name_)) {
+          skip_value();
+          continue;
+        }
+
+        if (peek() == 'n' && consume_literal("null", 4)) {
+          continue;  // like the flatbuffers parser: field is not set
+        }
+
+        auto const& f = o.fields_[it->second];
+        if (find(&f) != end(fields)) {
+          throw unsupported{};  // duplicate key
+        }
+
+        pending p;
+        p.f_ = &f;
+        switch (f.type_) {
+          case reflection::String:
+            p.off_ = fbb_.CreateString(parse_string()).o;
+            break;
+          case reflection::Vector: p.off_ = parse_vector(f); break;
+          case reflection::Obj: {
+            auto const& sub = c_.objects_[f.index_];
+            if (sub.is_struct_) {
+              p.struct_.resize(static_cast<std::size_t>(sub.bytesize_));
+              parse_struct(sub, p.struct_.data());
+            } else {
+              p.off_ = parse_table(sub);
+            }
+            break;
+          }
+          case reflection::Union: {
+            if (f.union_type_field_ == -1) {
+              throw unsupported{};
+            }
+            auto const type = find(&o.fields_[f.union_type_field_]);
+            if (type == end(fields)) {
+              throw unsupported{};  // value before type
+            }
+            auto const& members = c_.enums_[f.index_].union_objects_;
+            auto const member = members.find(type->v_.i_);
+            if (member == end(members)) {
+              throw unsupported{};
+            }
+            p.off_ = parse_table(c_.objects_[member->second]);
+            break;
+          }
+          default: p.v_ = parse_scalar(f.type_, f.index_);
+        }
+        fields.emplace_back(std::move(p));
+      } while (consume(','));
+      expect('}');
+    }
+
+    auto const start = fbb_.StartTable();
+    for (auto const& p : fields) {
+      switch (p.f_->type_) {
+        case reflection::String:
+        case reflection::Vector:
+        case reflection::Union:
+          fbb_.AddOffset(p.f_->offset_, Offset<void>(p.off_));
+          break;
+        case reflection::Obj:
+          if (c_.objects_[p.f_->index_].is_struct_) {
+            fbb_.Align(
+                static_cast<std::size_t>(c_.objects_[p.f_->index_].minalign_));
+            fbb_.PushBytes(p.struct_.data(), p.struct_.size());
+            fbb_.AddStructOffset(p.f_->offset_, fbb_.GetSize());
+          } else {
+            fbb_.AddOffset(p.f_->offset_, Offset<void>(p.off_));
+          }
+          break;
+        default: add_scalar(*p.f_, p.v_);
+      }
+    }
+    return fbb_.EndTable(start, o.numfields_);
+  }
+
+  codec const& c_;
+  char const* p_;
+  char const* end_;
+  message_creator& fbb_;
+};
+
+}  // namespace
+
+void write_json(message const& msg, std::string& out) {
+  auto const& c = get_codec();
+  json_writer w{c, out};
+  w.write_table(c.objects_[c.root_], GetRoot<Table>(msg.data()));
+}
+
+msg_ptr read_json(std::string const& json) {
+  auto const& c = get_codec();
+  message_creator fbb;
+  try {
+    json_reader r{c, json.data(), json.data() + json.size(), fbb};
+    auto const root = r.parse_table(c.objects_[c.root_]);
+    r.ws();
+    if (r.p_ != r.end_) {
+      return nullptr;
+    }
+    fbb.Finish(Offset<Message>(root));
+  } catch (json_reader::unsupported const&) {
+    return nullptr;
+  }
+
+  Verifier verifier(fbb.GetBufferPointer(), fbb.GetSize());
+  if (!VerifyMessageBuffer(verifier)) {
+    return nullptr;
+  }
+  return make_msg(fbb);
+}
+
+}  // namespace module
+}  // namespace motis
@@ -5,6 +5,7 @@
 #include "motis/core/common/logging.h"
 
 #include "motis/module/error.h"
+#include "motis/module/json.h"
 
 #include "motis/protocol/resources.h"
 
@@ -20,13 +21,10 @@ using namespace flatbuffers;
 namespace motis {
 namespace module {
 
-std::unique_ptr<Parser> init_parser(bool compact = false) {
+std::unique_ptr<Parser> init_parser() {
   auto parser = std::make_unique<Parser>();
   parser->opts.strict_json = true;
   parser->opts.skip_unexpected_fields_in_json = true;
-  if (compact) {
-    parser->opts.indent_step = -1;
-  }
   int message_symbol_index = -1;
   for (unsigned i = 0; i < number_of_symbols; ++i) {
     if (strcmp(filenames[i], "Message.fbs") == 0) {  // NOLINT
@@ -50,14 +48,22 @@ reflection::Schema const& init_schema(Parser& parser) {
 }
 
 static std::unique_ptr<Parser> json_parser = init_parser();
-static std::unique_ptr<Parser> compact_json_parser = init_parser(true);
 static std::unique_ptr<Parser> reflection_parser = init_parser();
 static reflection::Schema const& schema = init_schema(*reflection_parser);
 
+// Parse() mutates the parser: one instance per thread.
+Parser& thread_json_parser() {
+  thread_local auto const parser = init_parser();
+  return *parser;
+}
+
 std::string message::to_json(bool compact) const {
   std::string json;
-  flatbuffers::GenerateText(compact ? *compact_json_parser : *json_parser,
-                            data(), &json);
+  if (compact) {
+    write_json(*this, json);
+  } else {
+    flatbuffers::GenerateText(*json_parser, data(), &json);
+  }
   return json;
 }
 
@@ -77,21 +83,27 @@ msg_ptr make_msg(std::string const& json) {
     throw std::system_error(error::unable_to_parse_msg);
   }
 
-  bool parse_ok = json_parser->Parse(json.c_str());
+  if (auto msg = read_json(json)) {
+    return msg;
+  }
+
+  auto& parser = thread_json_parser();
+  bool parse_ok = parser.Parse(json.c_str());
   if (!parse_ok) {
-    LOG(motis::logging::error) << "parse error: " << json_parser->error_;
+    LOG(motis::logging::error) << "parse error: " << parser.error_;
     throw std::system_error(error::unable_to_parse_msg);
   }
 
-  flatbuffers::Verifier verifier(json_parser->builder_.GetBufferPointer(),
-                                 json_parser->builder_.GetSize());
+  flatbuffers::Verifier verifier(parser.builder_.GetBufferPointer(),
+                                 parser.builder_.GetSize());
   if (!VerifyMessageBuffer(verifier)) {
+    parser.builder_.Clear();
     throw std::system_error(error::malformed_msg);
   }
-  auto size = json_parser->builder_.GetSize();
-  auto buffer = json_parser->builder_.ReleaseBufferPointer();
+  auto size = parser.builder_.GetSize();
+  auto buffer = parser.builder_.ReleaseBufferPointer();
 
-  json_parser->builder_.Clear();
+  parser.builder_.Clear();
   return std::make_shared<message>(size, std::move(buffer));
 }
 
@@ -0,0 +1,229 @@
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flatbuffers/idl.h"
+
+#include "motis/module/json.h"
+#include "motis/module/message.h"
+#include "motis/protocol/resources.h"
+
+#undef GetMessage
+
+using namespace motis;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::osrm;
+
+auto const routing_query = R"({
+  "destination": {
+    "type": "Module",
+    "target": "/routing"
+  },
+  "content_type": "RoutingRequest",
+  "content": {
+    "start_type": "PretripStart",
+    "start": {
+      "station": {
+        "name": "Frankfurt \"Hbf\" ä\n",
+        "id": "8000105"
+      },
+      "interval": {
+        "begin": 1444896228,
+        "end": 1444899228
+      },
+      "min_connection_count": 3,
+      "extend_interval_later": true
+    },
+    "destination": {
+      "name": "",
+      "id": "8000096"
+    },
+    "search_dir": "Backward",
+    "use_dest_metas": false,
+    "unknown_field": [{"a": [1, 2.5, null]}],
+    "additional_edges": [{
+      "additional_edge_type": "MumoEdge",
+      "additional_edge": {
+        "from_station_id": "START",
+        "to_station_id": "8000105",
+        "duration": 15,
+        "price": 0,
+        "mumo_id": -1
+      }
+    }],
+    "via": []
+  }
+})";
+
+TEST(module_json, read) {
+  auto const msg = read_json(routing_query);
+  ASSERT_TRUE(msg);
+
+  auto const req = motis_content(RoutingRequest, msg);
+  ASSERT_EQ(Start_PretripStart, req->start_type());
+  auto const start = reinterpret_cast<PretripStart const*>(req->start());
+  EXPECT_EQ("Frankfurt \"Hbf\" \xc3\xa4\n", start->station()->name()->str());
+  EXPECT_EQ(1444896228, start->interval()->begin());
+  EXPECT_EQ(1444899228, start->interval()->end());
+  EXPECT_EQ(3, start->min_connection_count());
+  EXPECT_FALSE(start->extend_interval_earlier());
+  EXPECT_TRUE(start->extend_interval_later());
+  EXPECT_EQ(SearchDir_Backward, req->search_dir());
+  EXPECT_TRUE(req->use_start_metas());
+  EXPECT_FALSE(req->use_dest_metas());
+
+  ASSERT_EQ(1, req->additional_edges()->size());
+  auto const edge = req->additional_edges()->Get(0);
+  ASSERT_EQ(AdditionalEdge_MumoEdge, edge->additional_edge_type());
+  auto const mumo = reinterpret_cast<MumoEdge const*>(edge->additional_edge());
+  EXPECT_EQ("START", mumo->from_station_id()->str());
+  EXPECT_EQ(15, mumo->duration());
+  EXPECT_EQ(-1, mumo->mumo_id());
+}
+
+TEST(module_json, round_trip) {
+  auto const msg = read_json(routing_query);
+  ASSERT_TRUE(msg);
+
+  // compact (codec) and pretty (flatbuffers text generator) output both
+  // have to parse back into the same message
+  auto const compact = msg->to_json(true);
+  auto const from_compact = read_json(compact);
+  auto const from_pretty = read_json(msg->to_json());
+  ASSERT_TRUE(from_compact);
+  ASSERT_TRUE(from_pretty);
+  EXPECT_EQ(compact, from_compact->to_json(true));
+  EXPECT_EQ(compact, from_pretty->to_json(true));
+}
+
+namespace {
+
+// Same schema as message::to_json() uses, but compact text output.
+std::unique_ptr<flatbuffers::Parser> compact_parser() {
+  auto parser = std::make_unique<flatbuffers::Parser>();
+  parser->opts.strict_json = true;
+  parser->opts.indent_step = -1;
+  auto message_index = -1;
+  for (auto i = 0U; i < number_of_symbols; ++i) {
+    if (std::strcmp(filenames[i], "Message.fbs") == 0) {  // NOLINT
+      message_index = static_cast<int>(i);
+    } else if (!parser->Parse(symbols[i], nullptr, filenames[i])) {  // NOLINT
+      return nullptr;
+    }
+  }
+  if (message_index == -1 || !parser->Parse(symbols[message_index])) {
+    return nullptr;
+  }
+  return parser;
+}
+
+std::string generate_text(flatbuffers::Parser const& parser,
+                          msg_ptr const& msg) {
+  std::string json;
+  flatbuffers::GenerateText(parser, msg->data(), &json);
+  return json;
+}
+
+auto const osrm_response = R"({
+  "destination": {"type": "Module", "target": ""},
+  "content_type": "OSRMOneToManyResponse",
+  "content": {
+    "costs": [
+      {"duration": 12.5, "distance": 1000.25},
+      {"duration": 0.0, "distance": 3.0},
+      {"duration": -7.125, "distance": 123456.75}
+    ]
+  }
+})";
+
+auto const geo_station_request = R"({
+  "destination": {"type": "Module", "target": "/lookup/geo_station"},
+  "content_type": "LookupGeoStationRequest",
+  "content": {"pos": {"lat": 49.87, "lng": 8.65}, "max_radius": 500.0}
+})";
+
+}  // namespace
+
+TEST(module_json, same_as_generate_text) {
+  auto const parser = compact_parser();
+  ASSERT_TRUE(parser);
+
+  // unions, vector of tables, enums, escaped strings, vector of structs,
+  // struct fields and floats
+  for (auto const& json : {routing_query, osrm_response, geo_station_request}) {
+    auto const msg = read_json(json);
+    ASSERT_TRUE(msg) << json;
+    EXPECT_EQ(generate_text(*parser, msg), msg->to_json(true));
+  }
+}
+
+TEST(module_json, narrow_field_overflow) {
+  auto const with_connection_count = [](std::string const& count) {
+    return std::string{R"({
+      "destination": {"type": "Module", "target": "/routing"},
+      "content_type": "RoutingRequest",
+      "content": {
+        "start_type": "PretripStart",
+        "start": {
+          "station": {"name": "", "id": "8000105"},
+          "interval": {"begin": 1444896228, "end": 1444899228},
+          "min_connection_count": )"} +
+           count + R"(
+        },
+        "destination": {"name": "", "id": "8000096"},
+        "additional_edges": [],
+        "via": []
+      }
+    })";
+  };
+
+  // min_connection_count is a uint
+  EXPECT_TRUE(read_json(with_connection_count("4294967295")));
+  EXPECT_FALSE(read_json(with_connection_count("4294967296")));
+  EXPECT_FALSE(read_json(with_connection_count("-1")));
+  EXPECT_FALSE(read_json(with_connection_count("99999999999999999999")));
+}
+
+TEST(module_json, non_finite_float) {
+  message_creator fbb;
+  auto const inf = std::numeric_limits<double>::infinity();
+  auto const costs = std::vector<Cost>{
+      {std::numeric_limits<double>::quiet_NaN(), inf}, {1.5, -inf}};
+  fbb.create_and_finish(
+      MsgContent_OSRMOneToManyResponse,
+      CreateOSRMOneToManyResponse(fbb, fbb.CreateVectorOfStructs(costs))
+          .Union());
+  auto const msg = make_msg(fbb);
+
+  auto const json = msg->to_json(true);
+  EXPECT_NE(std::string::npos,
+            json.find(R"([{"duration": null,"distance": null},)"
+                      R"({"duration": 1.5,"distance": null}])"))
+      << json;
+
+  auto const parsed = read_json(json);
+  ASSERT_TRUE(parsed);
+  auto const res = motis_content(OSRMOneToManyResponse, parsed);
+  ASSERT_EQ(2U, res->costs()->size());
+  EXPECT_EQ(1.5, res->costs()->Get(1)->duration());
+}
+
+TEST(module_json, fallback) {
+  auto const union_value_first = R"({
+    "destination": {"type": "Module", "target": "/lookup/geo_station"},
+    "content": {"pos": {"lat": 49.87, "lng": 8.65}, "max_radius": 500.0},
+    "content_type": "LookupGeoStationRequest"
+  })";
+
+  EXPECT_FALSE(read_json(union_value_first));
+  EXPECT_FALSE(read_json("{\"destination\": "));
+
+  auto const msg = make_msg(union_value_first);
+  auto const req = motis_content(lookup::LookupGeoStationRequest, msg);
+  EXPECT_DOUBLE_EQ(500.0, req->max_radius());
+}
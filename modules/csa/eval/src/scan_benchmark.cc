@@ -0,0 +1,123 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#include "motis/core/common/logging.h"
+#include "motis/core/schedule/schedule.h"
+
+#include "motis/bootstrap/dataset_settings.h"
+#include "motis/loader/loader.h"
+
+#include "motis/csa/build_csa_timetable.h"
+#include "motis/csa/csa_day_streams.h"
+#include "motis/csa/csa_timetable.h"
+
+#include "conf/options_parser.h"
+
+using namespace motis;
+using namespace motis::bootstrap;
+using namespace motis::csa;
+
+// Compares the connection scan throughput of the csa_connection records
+// (std::bitset pointer per connection) with the struct of arrays scan layout
+// (dense bitfield index + per day bitmap) and per day connection streams.
+// All loops read the same fields.
+struct scan_result {
+  uint64_t scanned_{0U}, valid_{0U}, checksum_{0U};
+  double seconds_{0.0};
+};
+
+template <typename Fn>
+scan_result measure(int const first_day, int const last_day, Fn&& scan_day) {
+  scan_result r;
+  auto const start = std::chrono::steady_clock::now();
+  for (auto day = first_day; day <= last_day; ++day) {
+    scan_day(day, r);
+  }
+  r.seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             start)
+                   .count();
+  return r;
+}
+
+void print(char const* name, scan_result const& r) {
+  std::cout << name << ": " << r.scanned_ << " connections scanned, "
+            << r.valid_ << " valid, " << r.seconds_ << "s, "
+            << static_cast<double>(r.scanned_) / r.seconds_ / 1e6
+            << "M connections/s (checksum " << r.checksum_ << ")\n";
+}
+
+int main(int argc, char** argv) {
+  dataset_settings dataset_opt("rohdaten", "TODAY", 2, false, false, false,
+                               false);
+
+  conf::options_parser parser({&dataset_opt});
+  parser.read_command_line_args(argc, argv);
+
+  if (parser.help()) {
+    std::cout << "\n\tCSA Scan Benchmark\n\n";
+    parser.print_help(std::cout);
+    return 0;
+  } else if (parser.version()) {
+    std::cout << "CSA Scan Benchmark\n";
+    return 0;
+  }
+
+  parser.read_configuration_file();
+  parser.print_used(std::cout);
+
+  auto const sched = loader::load_schedule(dataset_opt);
+  auto const tt = build_csa_timetable(*sched, false, false);
+  auto const first_day = tt->first_event_.day();
+  auto const last_day = tt->last_event_.day();
+
+  auto const records = measure(first_day, last_day, [&](int const day,
+                                                        scan_result& r) {
+    for (auto const& con : tt->fwd_connections_) {
+      ++r.scanned_;
+      if (!con.traffic_days_->test(day)) {
+        continue;
+      }
+      ++r.valid_;
+      r.checksum_ += con.from_station_ + con.to_station_ + con.trip_ +
+                     con.trip_con_idx_ + con.departure_ + con.arrival_;
+    }
+  });
+
+  auto const& scan = tt->fwd_scan_;
+  auto const soa = measure(first_day, last_day, [&](int const day,
+                                                    scan_result& r) {
+    for (auto i = 0U; i < scan.size(); ++i) {
+      ++r.scanned_;
+      if (!tt->traffic_days_.test(day, scan.traffic_days(i))) {
+        continue;
+      }
+      ++r.valid_;
+      r.checksum_ += scan.from_station_[i] + scan.to_station_[i] +
+                     scan.trip_[i] + scan.trip_con_idx_[i] +
+                     scan.departure_[i] + scan.arrival_[i];
+    }
+  });
+
+  csa_day_streams day_streams{1U};
+  auto const streams = measure(first_day, last_day, [&](int const day,
+                                                        scan_result& r) {
+    auto const stream = day_streams.get(*tt, search_dir::FWD, day);
+    r.scanned_ += stream->size();
+    r.valid_ += stream->size();
+    for (auto const i : *stream) {
+      r.checksum_ += scan.from_station_[i] + scan.to_station_[i] +
+                     scan.trip_[i] + scan.trip_con_idx_[i] +
+                     scan.departure_[i] + scan.arrival_[i];
+    }
+  });
+
+  std::cout << "\nsizeof(csa_connection): " << sizeof(csa_connection)
+            << " bytes, scan layout: "
+            << (2 * sizeof(int16_t) + sizeof(uint32_t) +
+                2 * sizeof(station_id) + sizeof(trip_id) + sizeof(con_idx_t))
+            << " bytes per connection\n";
+  print("csa_connection records", records);
+  print("      scan layout (SoA)", soa);
+  print("  day streams (uncached)", streams);
+}
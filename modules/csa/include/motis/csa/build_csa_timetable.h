@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <memory>
+
 #include "motis/core/schedule/schedule.h"
 
 #include "motis/csa/csa_timetable.h"
@@ -8,6 +11,6 @@ namespace motis::csa {
 
 std::unique_ptr<csa_timetable> build_csa_timetable(
     schedule const&, bool bridge_zero_duration_connections,
-    bool add_footpath_connections);
+    bool add_footpath_connections, std::size_t day_stream_cache_size = 0U);
 
 }  // namespace motis::csa
@@ -0,0 +1,23 @@
+#pragma once
+
+// Kernels for instruction set extensions that are not enabled for the whole
+// build are compiled with function level target attributes and selected at
+// runtime.
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define MOTIS_CSA_AVX2
+#define MOTIS_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace motis::csa::cpu {
+
+inline bool has_avx2() {
+#ifdef MOTIS_CSA_AVX2
+  static auto const supported = __builtin_cpu_supports("avx2") != 0;
+  return supported;
+#else
+  return false;
+#endif
+}
+
+}  // namespace motis::csa::cpu
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "motis/csa/csa_journey.h"
+#include "motis/csa/csa_reconstruction.h"
+#include "motis/csa/csa_search_shared.h"
+#include "motis/csa/csa_search_state.h"
+#include "motis/csa/csa_statistics.h"
+#include "motis/csa/csa_timetable.h"
+
+namespace motis::csa::cpu {
+
+// Number of independent queries evaluated in one connection scan.
+// 8 x 32 bit lanes = one 256 bit register.
+constexpr auto BATCH_SIZE = 8U;
+
+// Forward ontrip CSA for up to BATCH_SIZE queries sharing the same start
+// time. Arrival times are stored lane-wise (one lane per query) as minutes
+// since schedule begin, the inner loops run over the lanes and are meant
+// to be auto-vectorized.
+struct csa_batch_search {
+  using lane_times = std::array<int32_t, BATCH_SIZE>;
+  using lane_con_idx = std::array<con_idx_t, BATCH_SIZE>;
+
+  static constexpr auto INVALID =
+      time(std::numeric_limits<int16_t>::max(), 1439).ts();
+  static constexpr auto INVALID_CON_IDX = std::numeric_limits<con_idx_t>::max();
+
+  using search_state = csa_search_state<
+      std::vector<std::array<lane_times, MAX_TRANSFERS + 1>>,
+      std::vector<std::array<lane_con_idx, MAX_TRANSFERS + 1>>>;
+
+  static std::unique_ptr<search_state> make_search_state(
+      csa_timetable const& tt) {
+    lane_times invalid_times;
+    invalid_times.fill(INVALID);
+    lane_con_idx invalid_con_idx;
+    invalid_con_idx.fill(INVALID_CON_IDX);
+    return std::make_unique<search_state>(
+        tt.stations_.size(), tt.trip_count_,
+        array_maker<lane_times, MAX_TRANSFERS + 1>::make_array(invalid_times),
+        array_maker<lane_con_idx, MAX_TRANSFERS + 1>::make_array(
+            invalid_con_idx));
+  }
+
+  // Single query view on the lane-wise search state for the reconstruction.
+  struct lane_arrival_times {
+    struct row {
+      time operator[](int const transfers) const {
+        return time(static_cast<int64_t>(row_[transfers][lane_]));  // NOLINT
+      }
+      std::array<lane_times, MAX_TRANSFERS + 1> const& row_;
+      unsigned lane_;
+    };
+    row operator[](station_id const station) const {
+      return {arrival_time_[station], lane_};
+    }
+    search_state::arrival_times const& arrival_time_;
+    unsigned lane_;
+  };
+
+  struct lane_trip_reachable {
+    struct row {
+      con_idx_t operator[](int const transfers) const {
+        return row_[transfers][lane_];  // NOLINT
+      }
+      std::array<lane_con_idx, MAX_TRANSFERS + 1> const& row_;
+      unsigned lane_;
+    };
+    row operator[](trip_id const trip) const {
+      return {trip_reachable_[trip], lane_};
+    }
+    search_state::trip_reachable const& trip_reachable_;
+    unsigned lane_;
+  };
+
+  // The search state has to be reset before it is handed to the search.
+  csa_batch_search(csa_timetable const& tt, time const& start_time,
+                   search_state& state, csa_statistics& stats)
+      : tt_(tt),
+        start_time_(start_time),
+        state_(state),
+        arrival_time_(state.arrival_time_),
+        trip_reachable_(state.trip_reachable_),
+        stats_(stats) {}
+
+  void add_start(unsigned const lane, csa_station const& station,
+                 time const& initial_duration) {
+    auto const station_arrival = start_time_ + initial_duration;
+    start_times_[lane][station.id_] = station_arrival;  // NOLINT
+    state_.touch_station(station.id_);
+    arrival_time_[station.id_][0][lane] = station_arrival.ts();  // NOLINT
+    stats_.start_count_++;
+
+    lane_times update;
+    update.fill(INVALID);
+    update[lane] = station_arrival.ts();  // NOLINT
+    expand_footpaths(station, update, 0);
+  }
+
+  void search() {
+    if (start_time_ > tt_.last_event_) {
+      return;
+    }
+    auto const& scan = tt_.fwd_scan_;
+    auto const start_mam = static_cast<int16_t>(start_time_.mam());
+    auto const first_connection = static_cast<std::size_t>(
+        std::distance(begin(scan.departure_),
+                      std::lower_bound(begin(scan.departure_),
+                                       end(scan.departure_), start_mam)));
+    auto const time_limit =
+        std::min(start_time_ + MAX_TRAVEL_TIME, tt_.last_event_);
+
+    auto search_day = start_time_.day();
+    for (auto i = first_connection; true; ++i) {
+      if (i == scan.size()) {
+        i = 0U;
+        search_day++;
+      }
+      if (time(search_day, scan.departure_[i]) > time_limit) {
+        break;
+      }
+      if (!tt_.traffic_days_.test(search_day, scan.traffic_days(i))) {
+        continue;
+      }
+      scan_connection(scan, search_day, i);
+    }
+  }
+
+  inline void scan_connection(csa_scan_connections const& scan,
+                              int const search_day, std::size_t const i) {
+    auto const trip = scan.trip_[i];
+    auto const trip_con_idx = scan.trip_con_idx_[i];
+    auto const from_in_allowed = scan.from_in_allowed(i);
+    auto const to_out_allowed = scan.to_out_allowed(i);
+    auto const con_departure = time(search_day, scan.departure_[i]).ts();
+    auto const con_arrival = time(search_day, scan.arrival_[i]).ts();
+    auto& trip_reachable = trip_reachable_[trip];
+    auto const& from_arrival_time = arrival_time_[scan.from_station_[i]];
+    auto const& to_arrival_time = arrival_time_[scan.to_station_[i]];
+
+    stats_.connections_scanned_++;
+    for (auto transfers = 0; transfers < MAX_TRANSFERS; ++transfers) {
+      auto& reachable = trip_reachable[transfers];  // NOLINT
+      auto const& from = from_arrival_time[transfers];  // NOLINT
+      auto const& to = to_arrival_time[transfers + 1];  // NOLINT
+
+      auto trip_updated = false;
+      auto any_update = false;
+      lane_times update;
+      for (auto lane = 0U; lane < BATCH_SIZE; ++lane) {
+        auto const via_trip = reachable[lane] <= trip_con_idx;  // NOLINT
+        auto const via_station =
+            from_in_allowed && from[lane] <= con_departure;  // NOLINT
+        auto const enter = via_station && !via_trip;
+        reachable[lane] = enter ? trip_con_idx : reachable[lane];  // NOLINT
+        trip_updated |= enter;
+
+        auto const improves = (via_trip || via_station) && to_out_allowed &&
+                              con_arrival < to[lane];  // NOLINT
+        update[lane] = improves ? con_arrival : INVALID;  // NOLINT
+        any_update |= improves;
+      }
+
+      if (trip_updated) {
+        state_.touch_trip(trip);
+      }
+      if (any_update) {
+        stats_.footpaths_expanded_++;
+        expand_footpaths(tt_.stations_[scan.to_station_[i]], update,
+                         transfers + 1);
+      }
+    }
+  }
+
+  void expand_footpaths(csa_station const& station,
+                        lane_times const& station_arrival,
+                        int const transfers) {
+    for (auto const& fp : station.footpaths_) {
+      auto& arrival = arrival_time_[fp.to_station_][transfers];  // NOLINT
+      auto improved = false;
+      for (auto lane = 0U; lane < BATCH_SIZE; ++lane) {
+        auto const fp_arrival =
+            station_arrival[lane] == INVALID  // NOLINT
+                ? INVALID
+                : station_arrival[lane] + fp.duration_.ts();  // NOLINT
+        improved |= fp_arrival < arrival[lane];  // NOLINT
+        arrival[lane] = std::min(arrival[lane], fp_arrival);  // NOLINT
+      }
+      if (improved) {
+        state_.touch_station(fp.to_station_);
+      }
+    }
+  }
+
+  std::vector<csa_journey> get_results(unsigned const lane,
+                                       csa_station const& station) {
+    std::vector<csa_journey> journeys;
+    auto const arrival_times = lane_arrival_times{arrival_time_, lane};
+    auto const trip_reachable = lane_trip_reachable{trip_reachable_, lane};
+    for (auto i = 0; i <= MAX_TRANSFERS; ++i) {
+      auto const arrival_time = arrival_times[station.id_][i];
+      if (arrival_time.ts() != INVALID) {
+        csa_reconstruction<search_dir::FWD, lane_arrival_times,
+                           lane_trip_reachable>{
+            tt_, start_times_[lane], arrival_times, trip_reachable}  // NOLINT
+            .extract_journey(journeys.emplace_back(
+                search_dir::FWD, start_time_, arrival_time, i, &station));
+      }
+    }
+    return journeys;
+  }
+
+  csa_timetable const& tt_;
+  time start_time_;
+  search_state& state_;
+  std::array<std::map<station_id, time>, BATCH_SIZE> start_times_;
+  search_state::arrival_times& arrival_time_;  // S, one lane per query
+  search_state::trip_reachable& trip_reachable_;  // T, one lane per query
+  csa_statistics& stats_;
+};
+
+}  // namespace motis::csa::cpu
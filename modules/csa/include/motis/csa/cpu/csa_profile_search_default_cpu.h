@@ -0,0 +1,451 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "utl/verify.h"
+
+#include "motis/core/common/logging.h"
+#include "motis/core/common/timing.h"
+#include "motis/core/schedule/interval.h"
+#include "motis/core/schedule/schedule.h"
+
+#include "motis/csa/csa_journey.h"
+#include "motis/csa/csa_query.h"
+#include "motis/csa/csa_search_shared.h"
+#include "motis/csa/csa_search_state.h"
+#include "motis/csa/csa_statistics.h"
+#include "motis/csa/csa_timetable.h"
+
+namespace motis::csa::cpu {
+
+// Profile CSA: computes the Pareto profiles (departure, arrival, number of
+// trips) of all stations towards the destination with a single scan over the
+// connections in descending departure order. Replaces the iterated ontrip
+// searches of pretrip_iterated_ontrip_search (forward searches only).
+struct csa_profile_search {
+  static constexpr auto INVALID =
+      time(std::numeric_limits<int16_t>::max(), 1439);
+  static constexpr auto NO_WALK = std::numeric_limits<duration>::max();
+
+  using arrivals = std::array<time, MAX_TRANSFERS + 1>;
+
+  struct leg {
+    csa_connection const* enter_con_{nullptr};
+    csa_connection const* exit_con_{nullptr};
+    time enter_time_{INVALID};
+  };
+
+  // Trip labels are kept across searches and invalidated by comparing the
+  // generation instead of refilling the whole vector.
+  struct trip_label {
+    uint32_t generation_{0U};
+    day_idx_t day_{0};
+    arrivals arrival_{
+        array_maker<time, MAX_TRANSFERS + 1>::make_array(INVALID)};
+    std::array<csa_connection const*, MAX_TRANSFERS + 1> exit_con_{};
+  };
+
+  // arrival_[k]: earliest destination arrival using at most k trips when
+  // ready to depart at the station not later than departure_.
+  struct profile_entry {
+    time departure_{INVALID};
+    arrivals arrival_{
+        array_maker<time, MAX_TRANSFERS + 1>::make_array(INVALID)};
+    std::array<leg, MAX_TRANSFERS + 1> legs_{};
+  };
+
+  struct dest_walk {
+    duration duration_{NO_WALK};
+    station_id dest_{0};
+  };
+
+  // Search memory reused across queries (see csa_search_state): reset()
+  // only clears the profiles and destination walks written since the last
+  // reset.
+  struct search_state {
+    search_state(std::size_t const station_count, std::size_t const trip_count)
+        : profiles_(station_count),
+          dest_walk_(station_count),
+          trip_labels_(trip_count) {}
+
+    bool fits(csa_timetable const& tt) const {
+      return profiles_.size() == tt.stations_.size() &&
+             trip_labels_.size() == tt.trip_count_;
+    }
+
+    void reset() {
+      for (auto const station : touched_profiles_) {
+        profiles_[station].clear();
+      }
+      for (auto const station : touched_walks_) {
+        dest_walk_[station] = dest_walk{};
+      }
+      touched_profiles_.clear();
+      touched_walks_.clear();
+      ++generation_;
+    }
+
+    std::vector<std::vector<profile_entry>> profiles_;
+    std::vector<dest_walk> dest_walk_;
+    std::vector<trip_label> trip_labels_;
+    uint32_t generation_{0U};
+    std::vector<station_id> touched_profiles_, touched_walks_;
+  };
+
+  static std::unique_ptr<search_state> make_search_state(
+      csa_timetable const& tt) {
+    return std::make_unique<search_state>(tt.stations_.size(), tt.trip_count_);
+  }
+
+  struct candidate {
+    time begin_, end_;
+    unsigned trips_;
+    station_id start_;
+    footpath const* start_fp_;
+    leg leg_;
+  };
+
+  csa_profile_search(schedule const&, csa_timetable const& tt,
+                     csa_query const& q, csa_statistics& stats,
+                     search_state_pool<search_state>& pool)
+      : tt_{tt},
+        q_{q},
+        stats_{stats},
+        state_{pool, tt, [&]() { return make_search_state(tt); }},
+        profiles_{state_.get().profiles_},
+        trip_labels_{state_.get().trip_labels_},
+        dest_walk_{state_.get().dest_walk_} {}
+
+  template <typename Results>
+  void search_in_interval(Results& results, interval const& search_interval,
+                          bool const ontrip_at_interval_end) {
+    utl::verify(q_.dir_ == search_dir::FWD, "profile csa: fwd only");
+
+    MOTIS_START_TIMING(search_timing);
+    init();
+    auto const last_departure =
+        (ontrip_at_interval_end ? search_interval.end_ + 1
+                                : search_interval.end_) +
+        MAX_TRAVEL_TIME;
+    scan(search_interval.begin_, std::min(last_departure, tt_.last_event_));
+    MOTIS_STOP_TIMING(search_timing);
+
+    MOTIS_START_TIMING(reconstruction_timing);
+    for (auto const& c :
+         collect_candidates(search_interval, ontrip_at_interval_end)) {
+      auto j = reconstruct(c);
+      if (j.is_reconstructed() && j.duration() <= MAX_TRAVEL_TIME) {
+        results.push_back(std::move(j));
+      }
+    }
+    MOTIS_STOP_TIMING(reconstruction_timing);
+
+    stats_.search_duration_ += MOTIS_TIMING_MS(search_timing);
+    stats_.reconstruction_duration_ += MOTIS_TIMING_MS(reconstruction_timing);
+  }
+
+  void init() {
+    auto& state = state_.get();
+    state.reset();
+    for (auto const& dest : q_.meta_dests_) {
+      stats_.destination_count_++;
+      dest_walk_[dest] = {0, dest};
+      state.touched_walks_.emplace_back(dest);
+      for (auto const& fp : tt_.stations_[dest].incoming_footpaths_) {
+        auto& walk = dest_walk_[fp.from_station_];
+        if (fp.from_station_ != fp.to_station_ &&
+            fp.duration_.ts() < walk.duration_) {
+          walk = {static_cast<duration>(fp.duration_.ts()), dest};
+          state.touched_walks_.emplace_back(fp.from_station_);
+        }
+      }
+    }
+  }
+
+  void scan(time const begin, time const end) {
+    auto const& scan = tt_.fwd_scan_;
+    auto const& departures = scan.departure_;
+    for (auto day = end.day(); day >= begin.day(); --day) {
+      // connections are sorted by departure: skip those after `end`
+      auto const last_mam = std::min(end.ts() - day * MINUTES_A_DAY,
+                                     static_cast<int32_t>(MINUTES_A_DAY));
+      auto const first_after = std::upper_bound(
+          std::begin(departures), std::end(departures), last_mam,
+          [](int32_t const mam, int16_t const dep) { return mam < dep; });
+      for (auto i = static_cast<std::size_t>(
+               std::distance(std::begin(departures), first_after));
+           i != 0U; --i) {
+        auto const idx = i - 1;
+        auto const departure = time(day, scan.departure_[idx]);
+        if (departure < begin) {
+          break;
+        }
+        if (!tt_.traffic_days_.test(day, scan.traffic_days(idx))) {
+          continue;
+        }
+        stats_.connections_scanned_++;
+        update(tt_.fwd_connections_[idx], departure,
+               time(day, scan.arrival_[idx]));
+      }
+    }
+  }
+
+  void update(csa_connection const& con, time const departure,
+              time const arrival) {
+    auto& tl = trip_labels_[con.trip_];
+    auto const generation = state_.get().generation_;
+    auto const trip_day =
+        static_cast<day_idx_t>(departure.day() - con.day_offset_);
+    if (tl.generation_ != generation || tl.day_ != trip_day) {
+      tl = trip_label{};
+      tl.generation_ = generation;
+      tl.day_ = trip_day;
+    }
+
+    if (con.to_out_allowed_) {
+      auto const& walk = dest_walk_[con.to_station_];
+      auto const walk_arrival =
+          walk.duration_ == NO_WALK ? INVALID : arrival + walk.duration_;
+      auto const transfer_arrival = eval_transfer(con.to_station_, arrival);
+      for (auto k = 1; k <= MAX_TRANSFERS; ++k) {
+        auto const exit_arrival =
+            std::min(walk_arrival, transfer_arrival[k - 1]);  // NOLINT
+        if (exit_arrival < tl.arrival_[k]) {  // NOLINT
+          tl.arrival_[k] = exit_arrival;  // NOLINT
+          tl.exit_con_[k] = &con;  // NOLINT
+        }
+      }
+    }
+
+    if (con.from_in_allowed_) {
+      add_to_profile(con.from_station_, con, departure, tl);
+    }
+  }
+
+  void add_to_profile(station_id const station, csa_connection const& con,
+                      time const departure, trip_label const& tl) {
+    auto& profile = profiles_[station];
+    auto const improves = [&](profile_entry const& e) {
+      for (auto k = 1; k <= MAX_TRANSFERS; ++k) {
+        if (tl.arrival_[k] < e.arrival_[k]) {  // NOLINT
+          return true;
+        }
+      }
+      return false;
+    };
+
+    if (!profile.empty() && !improves(profile.back())) {
+      return;
+    }
+
+    if (profile.empty()) {
+      state_.get().touched_profiles_.emplace_back(station);
+    }
+    if (profile.empty() || profile.back().departure_ != departure) {
+      auto next = profile.empty() ? profile_entry{} : profile.back();
+      next.departure_ = departure;
+      profile.emplace_back(next);
+    }
+
+    auto& entry = profile.back();
+    for (auto k = 1; k <= MAX_TRANSFERS; ++k) {
+      if (tl.arrival_[k] < entry.arrival_[k]) {  // NOLINT
+        entry.arrival_[k] = tl.arrival_[k];  // NOLINT
+        entry.legs_[k] = {&con, tl.exit_con_[k], departure};  // NOLINT
+      }
+    }
+  }
+
+  profile_entry const* eval(station_id const station, time const t) const {
+    // Entries are sorted by descending departure and the arrivals are
+    // cumulative: the last entry still reachable at t is the best one.
+    auto const& profile = profiles_[station];
+    auto const it = std::partition_point(
+        begin(profile), end(profile),
+        [&](profile_entry const& e) { return e.departure_ >= t; });
+    return it == begin(profile) ? nullptr : &*std::prev(it);
+  }
+
+  arrivals eval_transfer(station_id const station, time const arrival) const {
+    auto best = array_maker<time, MAX_TRANSFERS + 1>::make_array(INVALID);
+    for (auto const& fp : tt_.stations_[station].footpaths_) {
+      auto const e = eval(fp.to_station_, arrival + fp.duration_);
+      if (e == nullptr) {
+        continue;
+      }
+      for (auto k = 1; k <= MAX_TRANSFERS; ++k) {
+        best[k] = std::min(best[k], e->arrival_[k]);  // NOLINT
+      }
+    }
+    return best;
+  }
+
+  std::vector<candidate> collect_candidates(interval const& search_interval,
+                                            bool const ontrip_at_interval_end) {
+    std::vector<candidate> candidates;
+    auto const add_entry = [&](station_id const start, footpath const& fp,
+                               profile_entry const& e, bool const in_interval) {
+      auto const walk =
+          fp.from_station_ == fp.to_station_ ? 0 : fp.duration_.ts();
+      for (auto k = 1; k <= MAX_TRANSFERS; ++k) {
+        auto const& l = e.legs_[k];  // NOLINT
+        if (e.arrival_[k] == INVALID ||  // NOLINT
+            e.arrival_[k] == e.arrival_[k - 1]) {  // NOLINT
+          continue;
+        }
+        auto const journey_begin = l.enter_time_ - walk;
+        if (in_interval && (journey_begin < search_interval.begin_ ||
+                            journey_begin > search_interval.end_)) {
+          continue;
+        }
+        candidates.push_back(candidate{journey_begin, e.arrival_[k],  // NOLINT
+                                       static_cast<unsigned>(k), start, &fp,
+                                       l});
+      }
+    };
+
+    for (auto const& start : q_.meta_starts_) {
+      stats_.start_count_++;
+      for (auto const& fp : tt_.stations_[start].footpaths_) {
+        if (fp.from_station_ != fp.to_station_ &&
+            dest_walk_[fp.to_station_].duration_ == 0) {
+          candidates.push_back(candidate{
+              search_interval.end_, search_interval.end_ + fp.duration_, 0U,
+              start, &fp, leg{}});
+        }
+        for (auto const& e : profiles_[fp.to_station_]) {
+          add_entry(start, fp, e, true);
+        }
+        if (ontrip_at_interval_end) {
+          auto const walk =
+              fp.from_station_ == fp.to_station_ ? 0 : fp.duration_.ts();
+          if (auto const e =
+                  eval(fp.to_station_, search_interval.end_ + 1 + walk);
+              e != nullptr) {
+            add_entry(start, fp, *e, false);
+          }
+        }
+      }
+    }
+
+    // Entries are cumulative: drop duplicates and dominated candidates before
+    // the (comparatively expensive) journey reconstruction.
+    std::sort(begin(candidates), end(candidates),
+              [](candidate const& a, candidate const& b) {
+                return std::tie(b.begin_, a.end_, a.trips_) <
+                       std::tie(a.begin_, b.end_, b.trips_);
+              });
+    std::vector<candidate> pareto;
+    auto best_end = array_maker<time, MAX_TRANSFERS + 1>::make_array(INVALID);
+    for (auto const& c : candidates) {
+      if (std::none_of(begin(best_end), begin(best_end) + c.trips_ + 1,
+                       [&](time const t) { return t <= c.end_; })) {
+        best_end[c.trips_] = c.end_;  // NOLINT
+        pareto.emplace_back(c);
+      }
+    }
+    return pareto;
+  }
+
+  void add_trip_edges(csa_journey& j, leg const& l) const {
+    auto const& trip_cons = tt_.trip_to_connections_[l.enter_con_->trip_];
+    for (auto i = l.enter_con_->trip_con_idx_; i <= l.exit_con_->trip_con_idx_;
+         ++i) {
+      auto const con = trip_cons[i];
+      utl::verify(con->light_con_ != nullptr, "invalid light connection");
+      auto const con_dep_day = l.enter_time_.day() + con->day_offset_ -
+                               l.enter_con_->day_offset_;
+      auto const arr_mam_time = time(con->arrival_);
+      j.edges_.emplace_back(
+          con->light_con_, &tt_.stations_[con->from_station_],
+          &tt_.stations_[con->to_station_], con == l.enter_con_,
+          con == l.exit_con_, time(con_dep_day, con->departure_),
+          time(con_dep_day + arr_mam_time.day(), arr_mam_time.mam()));
+    }
+  }
+
+  csa_journey reconstruct(candidate const& c) {
+    stats_.reconstruction_count_++;
+
+    auto const& start_fp = *c.start_fp_;
+    csa_journey j{search_dir::FWD, c.begin_, c.end_, c.trips_, nullptr};
+    j.start_station_ = &tt_.stations_[c.start_];
+    if (start_fp.from_station_ != start_fp.to_station_) {
+      j.edges_.emplace_back(&tt_.stations_[start_fp.from_station_],
+                            &tt_.stations_[start_fp.to_station_], c.begin_,
+                            c.begin_ + start_fp.duration_, -1);
+    }
+
+    if (c.trips_ == 0U) {
+      j.destination_station_ = &tt_.stations_[start_fp.to_station_];
+      return j;
+    }
+
+    auto l = c.leg_;
+    for (auto k = c.trips_; k > 0; --k) {
+      add_trip_edges(j, l);
+      auto const& exit_edge = j.edges_.back();
+      auto const exit_station = l.exit_con_->to_station_;
+      auto const arrival = exit_edge.arrival_;
+
+      auto const& walk = dest_walk_[exit_station];
+      if (walk.duration_ != NO_WALK && arrival + walk.duration_ <= c.end_) {
+        if (walk.duration_ != 0) {
+          j.edges_.emplace_back(&tt_.stations_[exit_station],
+                                &tt_.stations_[walk.dest_], arrival,
+                                arrival + walk.duration_, -1);
+        }
+        j.destination_station_ = &tt_.stations_[walk.dest_];
+        return j;
+      }
+
+      if (k == 1) {
+        break;
+      }
+
+      auto const next = find_transfer(exit_station, arrival, k - 1, c.end_);
+      if (next.first == nullptr) {
+        break;
+      }
+      if (next.first->from_station_ != next.first->to_station_) {
+        j.edges_.emplace_back(&tt_.stations_[next.first->from_station_],
+                              &tt_.stations_[next.first->to_station_], arrival,
+                              arrival + next.first->duration_, -1);
+      }
+      l = next.second;
+    }
+
+    LOG(logging::warn) << "profile csa: journey reconstruction failed";
+    j.edges_.clear();
+    return j;
+  }
+
+  std::pair<footpath const*, leg> find_transfer(station_id const station,
+                                                time const arrival,
+                                                unsigned const trips,
+                                                time const target) const {
+    for (auto const& fp : tt_.stations_[station].footpaths_) {
+      auto const e = eval(fp.to_station_, arrival + fp.duration_);
+      if (e != nullptr && e->arrival_[trips] <= target) {  // NOLINT
+        return {&fp, e->legs_[trips]};  // NOLINT
+      }
+    }
+    return {nullptr, leg{}};
+  }
+
+  csa_timetable const& tt_;
+  csa_query const& q_;
+  csa_statistics& stats_;
+  search_state_retriever<search_state> state_;
+  std::vector<std::vector<profile_entry>>& profiles_;
+  std::vector<trip_label>& trip_labels_;
+  std::vector<dest_walk>& dest_walk_;
+};
+
+}  // namespace motis::csa::cpu
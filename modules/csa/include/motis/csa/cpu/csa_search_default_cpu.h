@@ -5,13 +5,16 @@
 #include "motis/csa/csa_journey.h"
 #include "motis/csa/csa_reconstruction.h"
 #include "motis/csa/csa_search_shared.h"
+#include "motis/csa/csa_search_state.h"
 #include "motis/csa/csa_statistics.h"
 #include "motis/csa/csa_timetable.h"
 
 #include <algorithm>
 #include <array>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
 
 #include "utl/erase_if.h"
 
@@ -23,16 +26,28 @@ struct csa_search {
       Dir == search_dir::FWD ? time(std::numeric_limits<int16_t>::max(), 1439)
                              : time(std::numeric_limits<int16_t>::min(), 0);
 
+  using search_state =
+      csa_search_state<std::vector<std::array<time, MAX_TRANSFERS + 1>>,
+                       std::vector<std::array<con_idx_t, MAX_TRANSFERS + 1>>>;
+
+  static std::unique_ptr<search_state> make_search_state(
+      csa_timetable const& tt) {
+    return std::make_unique<search_state>(
+        tt.stations_.size(), tt.trip_count_,
+        array_maker<time, MAX_TRANSFERS + 1>::make_array(INVALID),
+        array_maker<con_idx_t, MAX_TRANSFERS + 1>::make_array(
+            std::numeric_limits<con_idx_t>::max()));
+  }
+
+  // The search state has to be reset before it is handed to the search.
   csa_search(csa_timetable const& tt, time const& start_time,
-             csa_statistics& stats)
+             search_state& state, csa_statistics& stats)
       : tt_(tt),
         start_time_(start_time),
-        arrival_time_(
-            tt.stations_.size(),
-            array_maker<time, MAX_TRANSFERS + 1>::make_array(INVALID)),
-        trip_reachable_(tt.trip_count_,
-                        array_maker<con_idx_t, MAX_TRANSFERS + 1>::make_array(
-                            std::numeric_limits<con_idx_t>::max())),
+        state_(state),
+        start_times_(state.start_times_),
+        arrival_time_(state.arrival_time_),
+        trip_reachable_(state.trip_reachable_),
         stats_(stats) {}
 
   void add_start(csa_station const& station, time const& initial_duration) {
@@ -40,6 +55,7 @@ struct csa_search {
                                      ? start_time_ + initial_duration
                                      : start_time_ - initial_duration;
     start_times_[station.id_] = station_arrival;
+    state_.touch_station(station.id_);
     arrival_time_[station.id_][0] = station_arrival;
     stats_.start_count_++;
     expand_footpaths(station, station_arrival, 0);
@@ -50,78 +66,111 @@ struct csa_search {
     if (start_time_ > tt_.last_event_) {
       return;
     }
-    auto const& connections =
-        Dir == search_dir::FWD ? tt_.fwd_connections_ : tt_.bwd_connections_;
+    auto const& scan = Dir == search_dir::FWD ? tt_.fwd_scan_ : tt_.bwd_scan_;
+    auto const& scan_times =
+        Dir == search_dir::FWD ? scan.departure_ : scan.arrival_;
 
-    auto search_day = start_time_.day();
-
-    csa_connection const start_at{start_time_};
-    auto const first_connection = std::lower_bound(
-        begin(connections), end(connections), start_at,
-        [&](csa_connection const& a, csa_connection const& b) {
-          return Dir == search_dir::FWD ? a.departure_ < b.departure_
-                                        : a.arrival_ > b.arrival_;
-        });
+    auto const start_mam = static_cast<int16_t>(start_time_.mam());
+    auto const first_connection = static_cast<std::size_t>(std::distance(
+        begin(scan_times),
+        Dir == search_dir::FWD
+            ? std::lower_bound(begin(scan_times), end(scan_times), start_mam)
+            : std::lower_bound(begin(scan_times), end(scan_times), start_mam,
+                               std::greater<>())));
 
     auto const time_limit =
         Dir == search_dir::FWD
             ? std::min(start_time_ + MAX_TRAVEL_TIME, tt_.last_event_)
             : start_time_ - MAX_TRAVEL_TIME;
+    auto const time_limit_reached = [&](int const day, std::size_t const i) {
+      return Dir == search_dir::FWD
+                 ? time(day, scan.departure_[i]) > time_limit
+                 : time(day, scan.arrival_[i]) < time_limit;
+    };
+
+    if (Dir == search_dir::FWD && tt_.day_streams_ != nullptr) {
+      // Only visit connections operating on the search day.
+      for (auto search_day = start_time_.day(); true; ++search_day) {
+        auto const stream = tt_.day_streams_->get(tt_, Dir, search_day);
+        auto it = begin(*stream);
+        if (search_day == start_time_.day()) {
+          it = std::lower_bound(begin(*stream), end(*stream),
+                                static_cast<uint32_t>(first_connection));
+        }
+        for (; it != end(*stream); ++it) {
+          if (time_limit_reached(search_day, *it)) {
+            return;
+          }
+          scan_connection(scan, search_day, *it);
+        }
+        if (scan.size() == 0U ||
+            time_limit_reached(search_day + 1, std::size_t{0U})) {
+          return;
+        }
+      }
+    }
 
-    for (auto it = first_connection; true; ++it) {
-      if (it == end(connections)) {
-        it = begin(connections);
+    auto search_day = start_time_.day();
+    for (auto i = first_connection; true; ++i) {
+      if (i == scan.size()) {
+        i = 0U;
         search_day++;
       }
-      auto const& con = *it;
 
-      auto const time_limit_reached =
-          Dir == search_dir::FWD ? time(search_day, con.departure_) > time_limit
-                                 : time(search_day, con.arrival_) < time_limit;
-      if (time_limit_reached) {
+      if (time_limit_reached(search_day, i)) {
         break;
       }
 
-      if (!con.traffic_days_->test(search_day)) {
+      if (!tt_.traffic_days_.test(search_day, scan.traffic_days(i))) {
         continue;
       }
-      auto const con_departure_time = time(search_day, con.departure_);
-      auto const con_arrival_time = time(search_day, con.arrival_);
-      auto& trip_reachable = trip_reachable_[con.trip_];
-      auto const& from_arrival_time = arrival_time_[con.from_station_];
-      auto const& to_arrival_time = arrival_time_[con.to_station_];
-
-      stats_.connections_scanned_++;
-      for (auto transfers = 0; transfers < MAX_TRANSFERS; ++transfers) {
-        auto const via_trip =
-            trip_reachable[transfers] <= con.trip_con_idx_;  // NOLINT
-        auto const via_station =
+      scan_connection(scan, search_day, i);
+    }
+  }
+
+  inline void scan_connection(csa_scan_connections const& scan,
+                              int const search_day, std::size_t const i) {
+    auto const trip = scan.trip_[i];
+    auto const trip_con_idx = scan.trip_con_idx_[i];
+    auto const from_in_allowed = scan.from_in_allowed(i);
+    auto const to_out_allowed = scan.to_out_allowed(i);
+    auto const con_departure_time = time(search_day, scan.departure_[i]);
+    auto const con_arrival_time = time(search_day, scan.arrival_[i]);
+    auto& trip_reachable = trip_reachable_[trip];
+    auto const& from_arrival_time = arrival_time_[scan.from_station_[i]];
+    auto const& to_arrival_time = arrival_time_[scan.to_station_[i]];
+
+    stats_.connections_scanned_++;
+    for (auto transfers = 0; transfers < MAX_TRANSFERS; ++transfers) {
+      auto const via_trip =
+          trip_reachable[transfers] <= trip_con_idx;  // NOLINT
+      auto const via_station =
+          Dir == search_dir::FWD
+              ? (from_arrival_time[transfers] <= con_departure_time  // NOLINT
+                 && from_in_allowed)
+              : (to_arrival_time[transfers] >= con_arrival_time &&  // NOLINT
+                 to_out_allowed);
+      if (via_trip || via_station) {
+        if (!via_trip) {
+          state_.touch_trip(trip);
+          trip_reachable[transfers] = trip_con_idx;  // NOLINT
+        }
+        auto const update =
             Dir == search_dir::FWD
-                ? (from_arrival_time[transfers] <= con_departure_time  // NOLINT
-                   && con.from_in_allowed_)
-                : (to_arrival_time[transfers] >= con_arrival_time &&  // NOLINT
-                   con.to_out_allowed_);
-        if (via_trip || via_station) {
-          if (!via_trip) {
-            trip_reachable[transfers] = con.trip_con_idx_;  // NOLINT
-          }
-          auto const update =
-              Dir == search_dir::FWD
-                  ? con_arrival_time <
-                            to_arrival_time[transfers + 1] &&  // NOLINT
-                        con.to_out_allowed_
-                  : (con_departure_time >=
-                     from_arrival_time[transfers + 1]) &&  // NOLINT
-                        con.from_in_allowed_;
-          if (update) {
-            stats_.footpaths_expanded_++;
-            if (Dir == search_dir::FWD) {
-              expand_footpaths(tt_.stations_[con.to_station_], con_arrival_time,
-                               transfers + 1);
-            } else {
-              expand_footpaths(tt_.stations_[con.from_station_],
-                               con_departure_time, transfers + 1);
-            }
+                ? con_arrival_time <
+                          to_arrival_time[transfers + 1] &&  // NOLINT
+                      to_out_allowed
+                : (con_departure_time >=
+                   from_arrival_time[transfers + 1]) &&  // NOLINT
+                      from_in_allowed;
+        if (update) {
+          stats_.footpaths_expanded_++;
+          if (Dir == search_dir::FWD) {
+            expand_footpaths(tt_.stations_[scan.to_station_[i]],
+                             con_arrival_time, transfers + 1);
+          } else {
+            expand_footpaths(tt_.stations_[scan.from_station_[i]],
+                             con_departure_time, transfers + 1);
           }
         }
       }
@@ -134,6 +183,7 @@ struct csa_search {
       for (auto const& fp : station.footpaths_) {
         auto const fp_arrival = station_arrival + fp.duration_;
         if (arrival_time_[fp.to_station_][transfers] > fp_arrival) {
+          state_.touch_station(fp.to_station_);
           arrival_time_[fp.to_station_][transfers] = fp_arrival;
         }
       }
@@ -141,6 +191,7 @@ struct csa_search {
       for (auto const& fp : station.incoming_footpaths_) {
         auto const fp_arrival = station_arrival - fp.duration_;
         if (arrival_time_[fp.from_station_][transfers] < fp_arrival) {
+          state_.touch_station(fp.from_station_);
           arrival_time_[fp.from_station_][transfers] = fp_arrival;
         }
       }
@@ -153,8 +204,8 @@ struct csa_search {
     for (auto i = 0; i <= MAX_TRANSFERS; ++i) {
       auto const arrival_time = station_arrival[i];  // NOLINT
       if (arrival_time != INVALID) {
-        csa_reconstruction<Dir, decltype(arrival_time_),
-                           decltype(trip_reachable_)>{
+        csa_reconstruction<Dir, typename search_state::arrival_times,
+                           typename search_state::trip_reachable>{
             tt_, start_times_, arrival_time_, trip_reachable_}
             .extract_journey(journeys.emplace_back(Dir, start_time_,
                                                    arrival_time, i, &station));
@@ -165,9 +216,10 @@ struct csa_search {
 
   csa_timetable const& tt_;
   time start_time_;
-  std::map<station_id, time> start_times_;
-  std::vector<std::array<time, MAX_TRANSFERS + 1>> arrival_time_;  // S
-  std::vector<std::array<con_idx_t, MAX_TRANSFERS + 1>>
+  search_state& state_;
+  std::map<station_id, time>& start_times_;
+  typename search_state::arrival_times& arrival_time_;  // S
+  typename search_state::trip_reachable&
       trip_reachable_;  // T  connection index from which the trip can be used
   csa_statistics& stats_;
 };
@@ -0,0 +1,320 @@
+#pragma once
+
+#include "motis/csa/cpu/cpu_features.h"
+
+#ifdef MOTIS_CSA_AVX2
+
+#include <immintrin.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+
+#include "boost/align/aligned_allocator.hpp"
+
+#include "motis/csa/csa_journey.h"
+#include "motis/csa/csa_reconstruction.h"
+#include "motis/csa/csa_search_shared.h"
+#include "motis/csa/csa_search_state.h"
+#include "motis/csa/csa_statistics.h"
+#include "motis/csa/csa_timetable.h"
+
+namespace motis::csa::cpu::avx2 {
+
+template <typename T>
+using aligned_vector =
+    std::vector<T, boost::alignment::aligned_allocator<T, 32>>;
+
+// 256 bit = all transfer rounds of one station / trip as 32 bit values.
+static_assert(MAX_TRANSFERS == 7);
+
+// Times are stored as minutes since schedule begin (time::ts()).
+// Only call with has_avx2() == true.
+template <search_dir Dir>
+struct csa_search {
+  static constexpr auto INVALID = Dir == search_dir::FWD
+                                      ? std::numeric_limits<int32_t>::max()
+                                      : std::numeric_limits<int32_t>::min();
+  static constexpr auto INVALID_TIME =
+      Dir == search_dir::FWD ? time(std::numeric_limits<int16_t>::max(), 1439)
+                             : time(std::numeric_limits<int16_t>::min(), 0);
+
+  using row = std::array<int32_t, MAX_TRANSFERS + 1>;
+  using search_state =
+      csa_search_state<aligned_vector<row>, aligned_vector<row>>;
+
+  static std::unique_ptr<search_state> make_search_state(
+      csa_timetable const& tt) {
+    return std::make_unique<search_state>(
+        tt.stations_.size(), tt.trip_count_,
+        array_maker<int32_t, MAX_TRANSFERS + 1>::make_array(INVALID),
+        array_maker<int32_t, MAX_TRANSFERS + 1>::make_array(
+            std::numeric_limits<int32_t>::max()));
+  }
+
+  // Views for the reconstruction (which works on motis::time / con_idx_t).
+  struct arrival_times_view {
+    struct row_view {
+      time operator[](int const transfers) const {
+        auto const ts = row_[transfers];  // NOLINT
+        return ts == INVALID ? INVALID_TIME : time(static_cast<int64_t>(ts));
+      }
+      row const& row_;
+    };
+    row_view operator[](station_id const station) const {
+      return {rows_[station]};
+    }
+    aligned_vector<row> const& rows_;
+  };
+
+  struct trip_reachable_view {
+    struct row_view {
+      con_idx_t operator[](int const transfers) const {
+        return static_cast<con_idx_t>(std::min(
+            row_[transfers],  // NOLINT
+            static_cast<int32_t>(std::numeric_limits<con_idx_t>::max())));
+      }
+      row const& row_;
+    };
+    row_view operator[](trip_id const trip) const { return {rows_[trip]}; }
+    aligned_vector<row> const& rows_;
+  };
+
+  // The search state has to be reset before it is handed to the search.
+  csa_search(csa_timetable const& tt, time const& start_time,
+             search_state& state, csa_statistics& stats)
+      : tt_(tt),
+        start_time_(start_time),
+        state_(state),
+        start_times_(state.start_times_),
+        arrival_time_(state.arrival_time_),
+        trip_reachable_(state.trip_reachable_),
+        stats_(stats) {}
+
+  MOTIS_AVX2_TARGET void add_start(csa_station const& station,
+                                   time const& initial_duration) {
+    auto const station_arrival = Dir == search_dir::FWD
+                                     ? start_time_ + initial_duration
+                                     : start_time_ - initial_duration;
+    start_times_[station.id_] = station_arrival;
+    state_.touch_station(station.id_);
+    arrival_time_[station.id_][0] = station_arrival.ts();
+    stats_.start_count_++;
+    expand_footpaths(station, station_arrival.ts(),
+                     _mm256_setr_epi32(-1, 0, 0, 0, 0, 0, 0, 0));
+  }
+
+  MOTIS_AVX2_TARGET void search() {
+    if (start_time_ > tt_.last_event_) {
+      return;
+    }
+    auto const& scan = Dir == search_dir::FWD ? tt_.fwd_scan_ : tt_.bwd_scan_;
+    auto const& scan_times =
+        Dir == search_dir::FWD ? scan.departure_ : scan.arrival_;
+
+    auto const start_mam = static_cast<int16_t>(start_time_.mam());
+    auto const first_connection = static_cast<std::size_t>(std::distance(
+        begin(scan_times),
+        Dir == search_dir::FWD
+            ? std::lower_bound(begin(scan_times), end(scan_times), start_mam)
+            : std::lower_bound(begin(scan_times), end(scan_times), start_mam,
+                               std::greater<>())));
+
+    auto const time_limit =
+        Dir == search_dir::FWD
+            ? std::min(start_time_ + MAX_TRAVEL_TIME, tt_.last_event_)
+            : start_time_ - MAX_TRAVEL_TIME;
+    auto const time_limit_reached = [&](int const day, std::size_t const i) {
+      return Dir == search_dir::FWD
+                 ? time(day, scan.departure_[i]) > time_limit
+                 : time(day, scan.arrival_[i]) < time_limit;
+    };
+
+    if (Dir == search_dir::FWD && tt_.day_streams_ != nullptr) {
+      for (auto search_day = start_time_.day(); true; ++search_day) {
+        auto const stream = tt_.day_streams_->get(tt_, Dir, search_day);
+        auto it = begin(*stream);
+        if (search_day == start_time_.day()) {
+          it = std::lower_bound(begin(*stream), end(*stream),
+                                static_cast<uint32_t>(first_connection));
+        }
+        for (; it != end(*stream); ++it) {
+          if (time_limit_reached(search_day, *it)) {
+            return;
+          }
+          scan_connection(scan, search_day, *it);
+        }
+        if (scan.size() == 0U ||
+            time_limit_reached(search_day + 1, std::size_t{0U})) {
+          return;
+        }
+      }
+    }
+
+    auto search_day = start_time_.day();
+    for (auto i = first_connection; true; ++i) {
+      if (i == scan.size()) {
+        i = 0U;
+        search_day++;
+      }
+      if (time_limit_reached(search_day, i)) {
+        break;
+      }
+      if (!tt_.traffic_days_.test(search_day, scan.traffic_days(i))) {
+        continue;
+      }
+      scan_connection(scan, search_day, i);
+    }
+  }
+
+  MOTIS_AVX2_TARGET inline void scan_connection(
+      csa_scan_connections const& scan, int const search_day,
+      std::size_t const i) {
+    auto const trip = scan.trip_[i];
+    auto const con_departure = time(search_day, scan.departure_[i]).ts();
+    auto const con_arrival = time(search_day, scan.arrival_[i]).ts();
+    auto& trip_reachable = trip_reachable_[trip];
+    auto& from_arrival_time = arrival_time_[scan.from_station_[i]];
+    auto& to_arrival_time = arrival_time_[scan.to_station_[i]];
+
+    stats_.connections_scanned_++;
+
+    // via_trip = trip_reachable <= trip_con_idx
+    auto const m_trip_reachable =
+        _mm256_load_si256(reinterpret_cast<__m256i*>(trip_reachable.data()));
+    auto const m_trip_con_idx = _mm256_set1_epi32(scan.trip_con_idx_[i]);
+    auto const m_via_trip = _mm256_cmpgt_epi32(
+        _mm256_add_epi32(m_trip_con_idx, _mm256_set1_epi32(1)),
+        m_trip_reachable);
+
+    auto m_via_station = _mm256_setzero_si256();
+    if (Dir == search_dir::FWD && scan.from_in_allowed(i)) {
+      // from_arrival_time <= con.departure
+      auto const m_from_arrival_time = _mm256_load_si256(
+          reinterpret_cast<__m256i*>(from_arrival_time.data()));
+      m_via_station = _mm256_cmpgt_epi32(_mm256_set1_epi32(con_departure + 1),
+                                         m_from_arrival_time);
+    } else if (Dir == search_dir::BWD && scan.to_out_allowed(i)) {
+      // to_arrival_time >= con.arrival
+      auto const m_to_arrival_time =
+          _mm256_load_si256(reinterpret_cast<__m256i*>(to_arrival_time.data()));
+      m_via_station = _mm256_cmpgt_epi32(
+          m_to_arrival_time, _mm256_set1_epi32(con_arrival - 1));
+    }
+
+    auto const m_enter = _mm256_andnot_si256(m_via_trip, m_via_station);
+    if (_mm256_testz_si256(m_enter, m_enter) == 0) {
+      state_.touch_trip(trip);
+      _mm256_store_si256(
+          reinterpret_cast<__m256i*>(trip_reachable.data()),
+          _mm256_blendv_epi8(m_trip_reachable, m_trip_con_idx, m_enter));
+    }
+
+    if ((Dir == search_dir::FWD && !scan.to_out_allowed(i)) ||
+        (Dir == search_dir::BWD && !scan.from_in_allowed(i))) {
+      return;
+    }
+
+    // Round k reachable => round k + 1 may be improved.
+    auto const m_reachable = _mm256_or_si256(m_via_trip, m_via_station);
+    auto const m_reachable_next = _mm256_and_si256(
+        _mm256_permutevar8x32_epi32(m_reachable,
+                                    _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6)),
+        _mm256_setr_epi32(0, -1, -1, -1, -1, -1, -1, -1));
+
+    __m256i m_improved;
+    if (Dir == search_dir::FWD) {
+      // con.arrival < to_arrival_time[k + 1]
+      auto const m_to_arrival_time =
+          _mm256_load_si256(reinterpret_cast<__m256i*>(to_arrival_time.data()));
+      m_improved = _mm256_cmpgt_epi32(m_to_arrival_time,
+                                      _mm256_set1_epi32(con_arrival));
+    } else {
+      // con.departure >= from_arrival_time[k + 1]
+      auto const m_from_arrival_time = _mm256_load_si256(
+          reinterpret_cast<__m256i*>(from_arrival_time.data()));
+      m_improved = _mm256_cmpgt_epi32(_mm256_set1_epi32(con_departure + 1),
+                                      m_from_arrival_time);
+    }
+
+    auto const m_update = _mm256_and_si256(m_reachable_next, m_improved);
+    if (_mm256_testz_si256(m_update, m_update) == 0) {
+      stats_.footpaths_expanded_++;
+      if (Dir == search_dir::FWD) {
+        expand_footpaths(tt_.stations_[scan.to_station_[i]], con_arrival,
+                         m_update);
+      } else {
+        expand_footpaths(tt_.stations_[scan.from_station_[i]], con_departure,
+                         m_update);
+      }
+    }
+  }
+
+  MOTIS_AVX2_TARGET void expand_footpaths(csa_station const& station,
+                                          int32_t const station_arrival,
+                                          __m256i const& m_update) {
+    auto const m_invalid = _mm256_set1_epi32(INVALID);
+    if (Dir == search_dir::FWD) {
+      for (auto const& fp : station.footpaths_) {
+        auto& arrival = arrival_time_[fp.to_station_];
+        auto const m_fp_arrival = _mm256_blendv_epi8(
+            m_invalid, _mm256_set1_epi32(station_arrival + fp.duration_.ts()),
+            m_update);
+        auto const m_old =
+            _mm256_load_si256(reinterpret_cast<__m256i*>(arrival.data()));
+        auto const m_improved = _mm256_cmpgt_epi32(m_old, m_fp_arrival);
+        if (_mm256_testz_si256(m_improved, m_improved) == 0) {
+          state_.touch_station(fp.to_station_);
+          _mm256_store_si256(reinterpret_cast<__m256i*>(arrival.data()),
+                             _mm256_min_epi32(m_old, m_fp_arrival));
+        }
+      }
+    } else {
+      for (auto const& fp : station.incoming_footpaths_) {
+        auto& arrival = arrival_time_[fp.from_station_];
+        auto const m_fp_arrival = _mm256_blendv_epi8(
+            m_invalid, _mm256_set1_epi32(station_arrival - fp.duration_.ts()),
+            m_update);
+        auto const m_old =
+            _mm256_load_si256(reinterpret_cast<__m256i*>(arrival.data()));
+        auto const m_improved = _mm256_cmpgt_epi32(m_fp_arrival, m_old);
+        if (_mm256_testz_si256(m_improved, m_improved) == 0) {
+          state_.touch_station(fp.from_station_);
+          _mm256_store_si256(reinterpret_cast<__m256i*>(arrival.data()),
+                             _mm256_max_epi32(m_old, m_fp_arrival));
+        }
+      }
+    }
+  }
+
+  std::vector<csa_journey> get_results(csa_station const& station) {
+    std::vector<csa_journey> journeys;
+    auto const arrival_times = arrival_times_view{arrival_time_};
+    auto const trip_reachable = trip_reachable_view{trip_reachable_};
+    for (auto i = 0; i <= MAX_TRANSFERS; ++i) {
+      auto const arrival_time = arrival_times[station.id_][i];
+      if (arrival_time != INVALID_TIME) {
+        csa_reconstruction<Dir, arrival_times_view, trip_reachable_view>{
+            tt_, start_times_, arrival_times, trip_reachable}
+            .extract_journey(journeys.emplace_back(Dir, start_time_,
+                                                   arrival_time, i, &station));
+      }
+    }
+    return journeys;
+  }
+
+  csa_timetable const& tt_;
+  time start_time_;
+  search_state& state_;
+  std::map<station_id, time>& start_times_;
+  typename search_state::arrival_times& arrival_time_;  // S
+  typename search_state::trip_reachable& trip_reachable_;  // T
+  csa_statistics& stats_;
+};
+
+}  // namespace motis::csa::cpu::avx2
+
+#endif
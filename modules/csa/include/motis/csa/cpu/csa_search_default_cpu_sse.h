@@ -9,6 +9,7 @@ static_assert(__AVX__, "AVX not enabled!");
 #include <iostream>
 #include <limits>
 #include <map>
+#include <memory>
 
 #include "boost/align/aligned_allocator.hpp"
 
@@ -19,6 +20,7 @@ static_assert(__AVX__, "AVX not enabled!");
 #include "motis/csa/csa_journey.h"
 #include "motis/csa/csa_reconstruction.h"
 #include "motis/csa/csa_search_shared.h"
+#include "motis/csa/csa_search_state.h"
 #include "motis/csa/csa_statistics.h"
 #include "motis/csa/csa_timetable.h"
 
@@ -38,14 +40,28 @@ struct csa_search {
                                       ? std::numeric_limits<time>::max()
                                       : std::numeric_limits<time>::min();
 
-  csa_search(csa_timetable const& tt, time start_time, csa_statistics& stats)
+  using search_state =
+      csa_search_state<aligned_vector<std::array<time, MAX_TRANSFERS + 1>>,
+                       aligned_vector<std::array<uint16_t, MAX_TRANSFERS + 1>>>;
+
+  static std::unique_ptr<search_state> make_search_state(
+      csa_timetable const& tt) {
+    return std::make_unique<search_state>(
+        tt.stations_.size(), tt.trip_count_,
+        array_maker<time, MAX_TRANSFERS + 1>::make_array(INVALID),
+        std::array<uint16_t, MAX_TRANSFERS + 1>{});
+  }
+
+  // The search state has to be reset before it is handed to the search.
+  csa_search(csa_timetable const& tt, time start_time, search_state& state,
+             csa_statistics& stats)
       : tt_(tt),
         start_time_(start_time),
         stop_time_(INVALID),
-        arrival_time_(
-            tt.stations_.size(),
-            array_maker<time, MAX_TRANSFERS + 1>::make_array(INVALID)),
-        trip_reachable_(tt.trip_count_),
+        state_(state),
+        start_times_(state.start_times_),
+        arrival_time_(state.arrival_time_),
+        trip_reachable_(state.trip_reachable_),
         stats_(stats) {}
 
   void add_start(csa_station const& station, time initial_duration) {
@@ -53,6 +69,7 @@ struct csa_search {
                                      ? start_time_ + initial_duration
                                      : start_time_ - initial_duration;
     start_times_[station.id_] = station_arrival;
+    state_.touch_station(station.id_);
     arrival_time_[station.id_][0] = station_arrival;
     stats_.start_count_++;
     expand_footpaths(station, station_arrival,
@@ -124,8 +141,11 @@ struct csa_search {
             _mm_setzero_si128());
         m_reachable = _mm_or_si128(m_via_trip, m_via_station);
       }
-      _mm_store_si128(reinterpret_cast<__m128i*>(trip_reachable.data()),
-                      m_reachable);
+      if (_mm_testz_si128(m_reachable, m_reachable) == 0) {
+        state_.touch_trip(con.trip_);
+        _mm_store_si128(reinterpret_cast<__m128i*>(trip_reachable.data()),
+                        m_reachable);
+      }
 
       if ((Dir == search_dir::FWD && !con.to_out_allowed_) ||
           (Dir == search_dir::BWD && !con.from_in_allowed_)) {
@@ -182,6 +202,7 @@ struct csa_search {
       for (auto const& fp : station.footpaths_) {
         // fp_arrival = (~m_update & ~0) | (fp.arrival & update)
         // arrival = min(arrival, fp_arrival)
+        state_.touch_station(fp.to_station_);
         auto& arrival = arrival_time_[fp.to_station_];
         auto const no_update = _mm_andnot_si128(m_update, all_ones);
         auto const fp_arrival = _mm_or_si128(
@@ -197,6 +218,7 @@ struct csa_search {
     } else {
       for (auto const& fp : station.incoming_footpaths_) {
         // arrival = max(arrival, (fp.arrival & update))
+        state_.touch_station(fp.from_station_);
         auto& arrival = arrival_time_[fp.from_station_];
         auto const fp_arrival = _mm_and_si128(
             _mm_set1_epi16(station_arrival - fp.duration_), m_update);
@@ -215,8 +237,8 @@ struct csa_search {
     for (auto i = 0; i <= MAX_TRANSFERS; ++i) {
       auto const arrival_time = station_arrival[i];  // NOLINT
       if (arrival_time != INVALID) {
-        csa_reconstruction<Dir, decltype(arrival_time_),
-                           decltype(trip_reachable_)>{
+        csa_reconstruction<Dir, typename search_state::arrival_times,
+                           typename search_state::trip_reachable>{
             tt_, start_times_, arrival_time_, trip_reachable_}
             .extract_journey(journeys.emplace_back(Dir, start_time_,
                                                    arrival_time, i, &station));
@@ -228,9 +250,10 @@ struct csa_search {
   csa_timetable const& tt_;
   time start_time_;
   time stop_time_;
-  std::map<station_id, time> start_times_;
-  aligned_vector<std::array<time, MAX_TRANSFERS + 1>> arrival_time_;
-  aligned_vector<std::array<uint16_t, MAX_TRANSFERS + 1>> trip_reachable_;
+  search_state& state_;
+  std::map<station_id, time>& start_times_;
+  typename search_state::arrival_times& arrival_time_;
+  typename search_state::trip_reachable& trip_reachable_;
   csa_statistics& stats_;
 };
 
@@ -11,6 +11,8 @@
 namespace motis::csa {
 
 struct csa_timetable;
+struct csa_search_state_pools;
+struct csa_rt_state;
 
 struct csa : public motis::module::module {
   csa();
@@ -28,6 +30,8 @@ struct csa : public motis::module::module {
 
   motis::module::msg_ptr route(motis::module::msg_ptr const&,
                                implementation_type) const;
+  motis::module::msg_ptr route_batch(motis::module::msg_ptr const&) const;
+  motis::module::msg_ptr rt_update(motis::module::msg_ptr const&);
 
 #ifdef MOTIS_CUDA
   bool bridge_zero_duration_connections_{true};
@@ -36,7 +40,10 @@ struct csa : public motis::module::module {
   bool bridge_zero_duration_connections_{false};
   bool add_footpath_connections_{false};
 #endif
+  std::size_t day_stream_cache_size_{16U};
   std::unique_ptr<csa_timetable> timetable_;
+  std::unique_ptr<csa_search_state_pools> search_states_;
+  std::unique_ptr<csa_rt_state> rt_;
 };
 
 }  // namespace motis::csa
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "motis/core/common/lru_cache.h"
+#include "motis/core/schedule/search_dir.h"
+
+namespace motis::csa {
+
+struct csa_timetable;
+
+// Indices (into fwd_scan_ / bwd_scan_) of all connections that operate on
+// a specific day, in scan order.
+using csa_day_stream = std::vector<uint32_t>;
+
+// Lazily built per day connection streams. The number of cached streams is
+// bounded by max_size, the least recently used stream is evicted first.
+// Streams are handed out as shared_ptr: evicting a stream that is still
+// being scanned by another search is safe.
+struct csa_day_streams {
+  explicit csa_day_streams(std::size_t max_size);
+
+  std::shared_ptr<csa_day_stream const> get(csa_timetable const&, search_dir,
+                                            int day);
+
+  std::size_t size();
+  void clear();
+
+private:
+  lru_cache<std::pair<search_dir, int>, std::shared_ptr<csa_day_stream const>>
+      cache_;
+};
+
+}  // namespace motis::csa
@@ -2,6 +2,6 @@
 
 namespace motis::csa {
 
-enum class implementation_type { CPU, CPU_SSE, GPU };
+enum class implementation_type { CPU, CPU_SSE, CPU_AVX2, CPU_PROFILE, GPU };
 
 }  // namespace motis::csa
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "motis/csa/csa_timetable.h"
+
+namespace motis::csa {
+
+// Search memory (arrival times, trip reachability, start times) that is
+// reused across searches. reset() only restores the rows written since the
+// last reset instead of refilling the arrays.
+template <typename ArrivalTimes, typename TripReachable>
+struct csa_search_state {
+  using arrival_times = ArrivalTimes;
+  using trip_reachable = TripReachable;
+  using arrival_row = typename ArrivalTimes::value_type;
+  using trip_row = typename TripReachable::value_type;
+
+  csa_search_state(std::size_t const station_count,
+                   std::size_t const trip_count,
+                   arrival_row const& invalid_arrival,
+                   trip_row const& invalid_trip)
+      : invalid_arrival_{invalid_arrival},
+        invalid_trip_{invalid_trip},
+        arrival_time_(station_count, invalid_arrival),
+        trip_reachable_(trip_count, invalid_trip),
+        station_touched_(station_count, false),
+        trip_touched_(trip_count, false) {}
+
+  bool fits(csa_timetable const& tt) const {
+    return arrival_time_.size() == tt.stations_.size() &&
+           trip_reachable_.size() == tt.trip_count_;
+  }
+
+  inline void touch_station(station_id const station) {
+    if (!station_touched_[station]) {
+      station_touched_[station] = true;
+      touched_stations_.emplace_back(station);
+    }
+  }
+
+  inline void touch_trip(trip_id const trip) {
+    if (!trip_touched_[trip]) {
+      trip_touched_[trip] = true;
+      touched_trips_.emplace_back(trip);
+    }
+  }
+
+  void reset() {
+    for (auto const station : touched_stations_) {
+      arrival_time_[station] = invalid_arrival_;
+      station_touched_[station] = false;
+    }
+    for (auto const trip : touched_trips_) {
+      trip_reachable_[trip] = invalid_trip_;
+      trip_touched_[trip] = false;
+    }
+    touched_stations_.clear();
+    touched_trips_.clear();
+    start_times_.clear();
+  }
+
+  arrival_row invalid_arrival_;
+  trip_row invalid_trip_;
+  ArrivalTimes arrival_time_;
+  TripReachable trip_reachable_;
+  std::map<station_id, time> start_times_;
+  std::vector<bool> station_touched_, trip_touched_;
+  std::vector<station_id> touched_stations_;
+  std::vector<trip_id> touched_trips_;
+};
+
+template <typename State>
+struct search_state_pool {
+  struct entry {
+    bool in_use_{false};
+    std::unique_ptr<State> state_;
+  };
+
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<entry>> entries_;
+};
+
+template <typename State>
+struct search_state_retriever {
+  template <typename CreateFn>
+  search_state_retriever(search_state_pool<State>& pool,
+                         csa_timetable const& tt, CreateFn&& create)
+      : pool_(pool), entry_(retrieve()) {
+    if (entry_->state_ == nullptr || !entry_->state_->fits(tt)) {
+      entry_->state_ = create();
+    }
+  }
+
+  search_state_retriever(search_state_retriever const&) = delete;
+  search_state_retriever& operator=(search_state_retriever const&) = delete;
+
+  search_state_retriever(search_state_retriever&&) = delete;
+  search_state_retriever& operator=(search_state_retriever&&) = delete;
+
+  ~search_state_retriever() {
+    std::lock_guard<std::mutex> lock(pool_.mutex_);
+    entry_->in_use_ = false;
+  }
+
+  State& get() { return *entry_->state_; }
+
+private:
+  typename search_state_pool<State>::entry* retrieve() {
+    std::lock_guard<std::mutex> lock(pool_.mutex_);
+    auto& entries = pool_.entries_;
+    auto it = std::find_if(begin(entries), end(entries),
+                           [](auto&& e) { return !e->in_use_; });
+    if (it == end(entries)) {
+      entries.emplace_back(
+          std::make_unique<typename search_state_pool<State>::entry>());
+      it = std::prev(end(entries));
+    }
+    it->get()->in_use_ = true;
+    return it->get();
+  }
+
+  search_state_pool<State>& pool_;
+  typename search_state_pool<State>::entry* entry_;
+};
+
+}  // namespace motis::csa
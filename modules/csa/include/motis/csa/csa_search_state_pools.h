@@ -0,0 +1,71 @@
+#pragma once
+
+#include <type_traits>
+
+#ifdef MOTIS_AVX
+#include "motis/csa/cpu/csa_search_default_cpu_sse.h"
+#endif
+#include "motis/csa/cpu/csa_batch_search_default_cpu.h"
+#include "motis/csa/cpu/csa_profile_search_default_cpu.h"
+#include "motis/csa/cpu/csa_search_default_cpu.h"
+#include "motis/csa/cpu/csa_search_default_cpu_avx2.h"
+#include "motis/csa/csa_search_state.h"
+
+namespace motis::csa {
+
+// One pool per search implementation and direction: the states differ in
+// their invalid values even if they share the same type.
+struct csa_search_state_pools {
+  template <typename CSASearch>
+  search_state_pool<typename CSASearch::search_state>& get() {
+    if constexpr (std::is_same_v<CSASearch, cpu::csa_search<search_dir::FWD>>) {
+      return cpu_fwd_;
+    } else if constexpr (std::is_same_v<CSASearch,
+                                        cpu::csa_search<search_dir::BWD>>) {
+      return cpu_bwd_;
+    } else if constexpr (std::is_same_v<CSASearch, cpu::csa_batch_search>) {
+      return cpu_batch_;
+    } else if constexpr (std::is_same_v<CSASearch, cpu::csa_profile_search>) {
+      return cpu_profile_;
+    }
+#ifdef MOTIS_CSA_AVX2
+    else if constexpr (std::is_same_v<CSASearch,
+                                      cpu::avx2::csa_search<search_dir::FWD>>) {
+      return avx2_fwd_;
+    } else if constexpr (std::is_same_v<
+                             CSASearch,
+                             cpu::avx2::csa_search<search_dir::BWD>>) {
+      return avx2_bwd_;
+    }
+#endif
+#ifdef MOTIS_AVX
+    else if constexpr (std::is_same_v<CSASearch,
+                                      cpu::sse::csa_search<search_dir::FWD>>) {
+      return sse_fwd_;
+    } else if constexpr (std::is_same_v<
+                             CSASearch,
+                             cpu::sse::csa_search<search_dir::BWD>>) {
+      return sse_bwd_;
+    }
+#endif
+  }
+
+  search_state_pool<cpu::csa_search<search_dir::FWD>::search_state> cpu_fwd_;
+  search_state_pool<cpu::csa_search<search_dir::BWD>::search_state> cpu_bwd_;
+  search_state_pool<cpu::csa_batch_search::search_state> cpu_batch_;
+  search_state_pool<cpu::csa_profile_search::search_state> cpu_profile_;
+#ifdef MOTIS_CSA_AVX2
+  search_state_pool<cpu::avx2::csa_search<search_dir::FWD>::search_state>
+      avx2_fwd_;
+  search_state_pool<cpu::avx2::csa_search<search_dir::BWD>::search_state>
+      avx2_bwd_;
+#endif
+#ifdef MOTIS_AVX
+  search_state_pool<cpu::sse::csa_search<search_dir::FWD>::search_state>
+      sse_fwd_;
+  search_state_pool<cpu::sse::csa_search<search_dir::BWD>::search_state>
+      sse_bwd_;
+#endif
+};
+
+}  // namespace motis::csa
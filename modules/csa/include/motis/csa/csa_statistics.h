@@ -22,6 +22,7 @@ struct csa_statistics {
   uint64_t trip_price_init_{};
   uint64_t price_bounds_updated_{};
   uint64_t price_bounds_filtered_{};
+  uint64_t reset_duration_{};  // microseconds
   uint64_t search_duration_{};
   uint64_t reconstruction_duration_{};
   uint64_t total_duration_{};
@@ -45,6 +46,7 @@ inline stats_category to_stats_category(char const* name,
            {"trip_price_init", s.trip_price_init_},
            {"price_bounds_updated", s.price_bounds_updated_},
            {"price_bounds_filtered", s.price_bounds_filtered_},
+           {"reset_duration", s.reset_duration_},
            {"search_duration", s.search_duration_},
            {"reconstruction_duration", s.reconstruction_duration_},
            {"total_duration", s.total_duration_}}};
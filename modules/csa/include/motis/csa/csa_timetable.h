@@ -1,15 +1,22 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <iterator>
 
+#include "motis/core/schedule/compact_bitfield.h"
 #include "motis/core/schedule/connection.h"
 #include "motis/core/schedule/footpath.h"
 #include "motis/core/schedule/time.h"
 
 #include <map>
+#include <memory>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
+#include "motis/csa/csa_day_streams.h"
+
 #ifdef MOTIS_CUDA
 #include "motis/csa/gpu/gpu_timetable.h"
 #endif
@@ -18,6 +25,7 @@ namespace motis {
 
 struct light_connection;
 class station;
+struct trip;
 
 namespace csa {
 
@@ -31,7 +39,7 @@ struct csa_connection {
                  int16_t arrival, uint16_t price, trip_id trip,
                  con_idx_t trip_con_idx, bool from_in_allowed,
                  bool to_out_allowed, uint8_t clasz,
-                 loader::bitfield const* traffic_days,
+                 compact_bitfield const* traffic_days,
                  light_connection const* light_con, day_idx_t day_offset)
       : from_station_(from_station),
         to_station_(to_station),
@@ -54,7 +62,7 @@ struct csa_connection {
   station_id from_station_{0};
   station_id to_station_{0};
   trip_id trip_{0};
-  loader::bitfield const* traffic_days_;
+  compact_bitfield const* traffic_days_;
   int16_t departure_;
   int16_t arrival_{0};
   uint16_t price_{0};
@@ -66,6 +74,101 @@ struct csa_connection {
   day_idx_t day_offset_{0};
 };
 
+// Scan-critical connection data as struct of arrays, index-parallel to
+// fwd_connections_ / bwd_connections_. A scan first only touches the
+// departure (or arrival) and the traffic day arrays. The full csa_connection
+// records are only accessed by the reconstruction.
+struct csa_scan_connections {
+  static constexpr auto IN_ALLOWED = uint32_t{1U} << 31U;
+  static constexpr auto OUT_ALLOWED = uint32_t{1U} << 30U;
+  static constexpr auto TRAFFIC_DAYS_MASK = OUT_ALLOWED - 1U;
+
+  void push_back(csa_connection const& con, uint32_t const traffic_days_idx) {
+    departure_.emplace_back(con.departure_);
+    arrival_.emplace_back(con.arrival_);
+    traffic_days_.emplace_back(traffic_days_idx |
+                               (con.from_in_allowed_ ? IN_ALLOWED : 0U) |
+                               (con.to_out_allowed_ ? OUT_ALLOWED : 0U));
+    from_station_.emplace_back(con.from_station_);
+    to_station_.emplace_back(con.to_station_);
+    trip_.emplace_back(con.trip_);
+    trip_con_idx_.emplace_back(con.trip_con_idx_);
+  }
+
+  inline std::size_t size() const { return departure_.size(); }
+
+  // Same as std::rotate on all arrays (used by the real time update).
+  void rotate(std::size_t const first, std::size_t const middle,
+              std::size_t const last) {
+    auto const r = [&](auto& v) {
+      std::rotate(std::next(begin(v), first), std::next(begin(v), middle),
+                  std::next(begin(v), last));
+    };
+    r(departure_);
+    r(arrival_);
+    r(traffic_days_);
+    r(from_station_);
+    r(to_station_);
+    r(trip_);
+    r(trip_con_idx_);
+  }
+
+  inline uint32_t traffic_days(std::size_t const i) const {
+    return traffic_days_[i] & TRAFFIC_DAYS_MASK;
+  }
+  inline bool from_in_allowed(std::size_t const i) const {
+    return (traffic_days_[i] & IN_ALLOWED) != 0U;
+  }
+  inline bool to_out_allowed(std::size_t const i) const {
+    return (traffic_days_[i] & OUT_ALLOWED) != 0U;
+  }
+
+  std::vector<int16_t> departure_, arrival_;
+  std::vector<uint32_t> traffic_days_;  // dense bitfield idx + in/out flags
+  std::vector<station_id> from_station_, to_station_;
+  std::vector<trip_id> trip_;
+  std::vector<con_idx_t> trip_con_idx_;
+};
+
+// For every day: one bit per (deduplicated) traffic day bitfield.
+// Replaces the pointer chase to the 512 bit std::bitset in the scan.
+struct csa_traffic_days {
+  inline bool test(int const day, uint32_t const traffic_days_idx) const {
+    if (day < 0 || day >= static_cast<int>(loader::BIT_COUNT)) {
+      return false;
+    }
+    auto const word = static_cast<std::size_t>(day) * words_per_day_ +
+                      traffic_days_idx / 64U;
+    return ((bits_[word] >> (traffic_days_idx % 64U)) & 1U) != 0U;
+  }
+
+  // Appends a bitfield (real time updates that move a connection to another
+  // day) and returns its index.
+  uint32_t add(compact_bitfield const& bf) {
+    auto const idx = static_cast<uint32_t>(count_++);
+    if (count_ > words_per_day_ * 64U) {
+      std::vector<uint64_t> bits(loader::BIT_COUNT * (words_per_day_ + 1U));
+      for (auto day = 0U; day < loader::BIT_COUNT; ++day) {
+        std::copy(std::next(begin(bits_), day * words_per_day_),
+                  std::next(begin(bits_), (day + 1U) * words_per_day_),
+                  std::next(begin(bits), day * (words_per_day_ + 1U)));
+      }
+      ++words_per_day_;
+      bits_ = std::move(bits);
+    }
+    for (auto day = 0U; day < loader::BIT_COUNT; ++day) {
+      if (bf.test(day)) {
+        bits_[day * words_per_day_ + idx / 64U] |= uint64_t{1U} << (idx % 64U);
+      }
+    }
+    return idx;
+  }
+
+  std::size_t words_per_day_{0U};
+  std::size_t count_{0U};
+  std::vector<uint64_t> bits_;
+};
+
 struct csa_station {
   csa_station() = delete;
   explicit csa_station(station const* station_ptr);
@@ -83,8 +186,12 @@ struct csa_timetable {
   std::vector<csa_station> stations_;
   std::vector<csa_connection> fwd_connections_, bwd_connections_;
   std::vector<uint32_t> fwd_bucket_starts_, bwd_bucket_starts_;
+  csa_scan_connections fwd_scan_, bwd_scan_;
+  csa_traffic_days traffic_days_;
+  std::unique_ptr<csa_day_streams> day_streams_;  // nullptr = disabled
 
   std::vector<std::vector<csa_connection const*>> trip_to_connections_;
+  std::unordered_map<trip const*, trip_id> trip_ids_;
 
   // long int first_day_;
   // long int last_day_;
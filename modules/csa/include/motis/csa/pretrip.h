@@ -7,20 +7,23 @@
 
 #include "motis/csa/collect_start_times.h"
 #include "motis/csa/csa_query.h"
+#include "motis/csa/csa_search_state.h"
 #include "motis/csa/csa_statistics.h"
 #include "motis/csa/csa_timetable.h"
 #include "motis/csa/pareto_set.h"
 #include "motis/csa/response.h"
 
 #include <algorithm>
+#include <utility>
 
 namespace motis::csa {
 
 template <typename SearchStrategy>
 struct pretrip : public SearchStrategy {
+  template <typename... Args>
   pretrip(schedule const& sched, csa_timetable const& tt, csa_query const& q,
-          csa_statistics& stats)
-      : SearchStrategy{sched, tt, q, stats},
+          csa_statistics& stats, Args&&... args)
+      : SearchStrategy{sched, tt, q, stats, std::forward<Args>(args)...},
         schedule_begin_{SCHEDULE_OFFSET_MINUTES},
         schedule_end_{static_cast<motis::time>(
             (sched.schedule_end_ - sched.schedule_begin_) / 60)} {}
@@ -109,9 +112,16 @@ private:
 
 template <typename CSASearch>
 struct pretrip_iterated_ontrip_search {
+  using search_state = typename CSASearch::search_state;
+
   pretrip_iterated_ontrip_search(schedule const& sched, csa_timetable const& tt,
-                                 csa_query const& q, csa_statistics& stats)
-      : sched_{sched}, tt_{tt}, q_{q}, stats_{stats} {}
+                                 csa_query const& q, csa_statistics& stats,
+                                 search_state_pool<search_state>& pool)
+      : sched_{sched},
+        tt_{tt},
+        q_{q},
+        stats_{stats},
+        state_{pool, tt, [&]() { return CSASearch::make_search_state(tt); }} {}
 
   template <typename Results>
   void search_in_interval(Results& results, interval const& search_interval,
@@ -119,7 +129,12 @@ struct pretrip_iterated_ontrip_search {
     auto const start_times =
         collect_start_times(tt_, q_, search_interval, ontrip_at_interval_end);
     for (auto const& start_time : start_times) {
-      CSASearch csa{tt_, start_time, stats_};
+      MOTIS_START_TIMING(reset_timing);
+      state_.get().reset();
+      MOTIS_STOP_TIMING(reset_timing);
+      stats_.reset_duration_ += MOTIS_TIMING_US(reset_timing);
+
+      CSASearch csa{tt_, start_time, state_.get(), stats_};
       for (auto const& start_idx : q_.meta_starts_) {
         csa.add_start(tt_.stations_.at(start_idx), 0);
       }
@@ -152,6 +167,7 @@ struct pretrip_iterated_ontrip_search {
   csa_timetable const& tt_;
   csa_query const& q_;
   csa_statistics& stats_;
+  search_state_retriever<search_state> state_;
 };
 
 }  // namespace motis::csa
\ No newline at end of file
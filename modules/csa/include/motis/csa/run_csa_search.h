@@ -14,7 +14,18 @@
 
 namespace motis::csa {
 
+struct csa_search_state_pools;
+
 response run_csa_search(schedule const&, csa_timetable const&, csa_query const&,
-                        motis::routing::SearchType, implementation_type);
+                        motis::routing::SearchType, implementation_type,
+                        csa_search_state_pools&);
+
+// Forward ontrip queries with the same start time are answered together by
+// the batch search (up to cpu::BATCH_SIZE per connection scan). All other
+// queries are answered one by one. Responses are in query order.
+std::vector<response> run_csa_batch_search(schedule const&,
+                                           csa_timetable const&,
+                                           std::vector<csa_query> const&,
+                                           csa_search_state_pools&);
 
 }  // namespace motis::csa
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "motis/core/schedule/compact_bitfield.h"
+#include "motis/core/schedule/event_type.h"
+#include "motis/core/schedule/schedule.h"
+#include "motis/core/statistics/statistics.h"
+
+#include "motis/csa/csa_timetable.h"
+
+#include "motis/protocol/RtUpdate_generated.h"
+
+namespace motis::csa {
+
+struct csa_update_statistics {
+  uint64_t batches_{};
+  uint64_t shifted_nodes_{};
+  uint64_t connections_updated_{};
+  uint64_t connections_moved_{};
+  uint64_t trip_not_found_{};
+  uint64_t event_not_found_{};
+  uint64_t station_not_found_{};
+  uint64_t day_changed_{};
+  uint64_t canceled_{};
+  uint64_t last_update_duration_{};  // microseconds
+  uint64_t max_update_duration_{};  // microseconds
+  uint64_t total_update_duration_{};  // microseconds
+};
+
+inline stats_category to_stats_category(char const* name,
+                                        csa_update_statistics const& s) {
+  return {name,
+          {{"batches", s.batches_},
+           {"shifted_nodes", s.shifted_nodes_},
+           {"connections_updated", s.connections_updated_},
+           {"connections_moved", s.connections_moved_},
+           {"trip_not_found", s.trip_not_found_},
+           {"event_not_found", s.event_not_found_},
+           {"station_not_found", s.station_not_found_},
+           {"day_changed", s.day_changed_},
+           {"canceled", s.canceled_},
+           {"last_update_duration", s.last_update_duration_},
+           {"max_update_duration", s.max_update_duration_},
+           {"total_update_duration", s.total_update_duration_}}};
+}
+
+// Scheduled departure / arrival of every connection that has been shifted
+// by a real time update: the updates carry absolute times. Times are
+// relative to the first day of the trip (day_offset_ * 1440 + minute).
+using csa_schedule_times =
+    std::map<std::tuple<trip_id, con_idx_t, event_type>, int16_t>;
+
+// Scheduled day offset and traffic days of a connection whose departure
+// has been moved to another day.
+struct csa_schedule_days {
+  day_idx_t day_offset_{0};
+  compact_bitfield const* traffic_days_{nullptr};
+  uint32_t traffic_days_idx_{0U};
+};
+
+struct csa_rt_state {
+  csa_schedule_times schedule_times_;
+  std::map<std::pair<trip_id, con_idx_t>, csa_schedule_days> schedule_days_;
+
+  // (scheduled traffic days index, day shift) -> shifted traffic days
+  std::map<std::pair<uint32_t, int>,
+           std::pair<compact_bitfield const*, uint32_t>>
+      shifted_traffic_days_;
+  std::deque<compact_bitfield> shifted_bitfields_;
+  std::deque<std::vector<uint64_t>> shifted_words_;
+
+  csa_update_statistics stats_;
+};
+
+// Applies the shifted nodes of one real time batch to the connection arrays
+// in place. Shifted connections are moved to their new position (only the
+// range between the old and the new time is touched). Pointers to moved
+// connections (trip_to_connections_, station in/out lists) are fixed up.
+// Departures are kept normalized to a minute of the day: a departure that
+// moves to another day changes the day offset and the traffic days.
+void update_csa_timetable(schedule const&, csa_timetable&, csa_rt_state&,
+                          motis::rt::RtUpdate const&);
+
+}  // namespace motis::csa
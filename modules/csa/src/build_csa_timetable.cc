@@ -69,6 +69,37 @@ void init_stop_to_connections(csa_timetable& tt) {
   }
 }
 
+void init_scan_connections(schedule const& sched, csa_timetable& tt) {
+  scoped_timer timer("csa: scan connections");
+  auto const& bitfields = sched.compact_bitfields_;
+  utl::verify(bitfields.size() <= csa_scan_connections::TRAFFIC_DAYS_MASK,
+              "csa: too many traffic day bitfields");
+
+  auto const init = [&](std::vector<csa_connection> const& connections,
+                        csa_scan_connections& scan) {
+    for (auto const& con : connections) {
+      scan.push_back(con, static_cast<uint32_t>(std::distance(
+                              bitfields.data(), con.traffic_days_)));
+    }
+  };
+  init(tt.fwd_connections_, tt.fwd_scan_);
+  init(tt.bwd_connections_, tt.bwd_scan_);
+
+  auto& traffic_days = tt.traffic_days_;
+  traffic_days.words_per_day_ = (bitfields.size() + 63U) / 64U;
+  traffic_days.count_ = bitfields.size();
+  traffic_days.bits_.resize(loader::BIT_COUNT * traffic_days.words_per_day_);
+  for (auto bf_idx = 0U; bf_idx < bitfields.size(); ++bf_idx) {
+    auto const& bf = bitfields[bf_idx];
+    for (auto day = 0U; day < loader::BIT_COUNT; ++day) {
+      if (bf.test(day)) {
+        traffic_days.bits_[day * traffic_days.words_per_day_ + bf_idx / 64U] |=
+            uint64_t{1U} << (bf_idx % 64U);
+      }
+    }
+  }
+}
+
 std::vector<uint32_t> get_bucket_starts(
     std::vector<csa_connection>::const_iterator const it_begin,
     std::vector<csa_connection>::const_iterator const it_end,
@@ -162,6 +193,7 @@ trip_id get_connections_from_expanded_trips(
           });
 
       for (auto const& trp : route_trips) {
+        tt.trip_ids_.emplace(static_cast<trip const*>(trp), trip_idx);
         auto const trp_sections = sections{trp};
         for (auto sec_it = trp_sections.begin(); sec_it != trp_sections.end();
              ++sec_it) {
@@ -295,7 +327,8 @@ void add_footpaths(schedule const& sched, csa_timetable& tt) {
 
 std::unique_ptr<csa_timetable> build_csa_timetable(
     schedule const& sched, bool const bridge_zero_duration_connections,
-    bool const add_footpath_connections) {
+    bool const add_footpath_connections,
+    std::size_t const day_stream_cache_size) {
   scoped_timer timer("building csa timetable");
 
   auto tt = std::make_unique<csa_timetable>();
@@ -315,6 +348,10 @@ std::unique_ptr<csa_timetable> build_csa_timetable(
       unix_to_motistime(sched.schedule_begin_, sched.last_event_schedule_time_);
   reinit_trip_to_connections(*tt);
   init_stop_to_connections(*tt);
+  init_scan_connections(sched, *tt);
+  if (day_stream_cache_size != 0U) {
+    tt->day_streams_ = std::make_unique<csa_day_streams>(day_stream_cache_size);
+  }
 
 #ifdef MOTIS_CUDA
   {
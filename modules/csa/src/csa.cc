@@ -6,41 +6,77 @@
 #include "motis/module/context/get_schedule.h"
 
 #include "motis/csa/build_csa_timetable.h"
+#include "motis/csa/cpu/cpu_features.h"
 #include "motis/csa/csa_query.h"
+#include "motis/csa/csa_search_state_pools.h"
 #include "motis/csa/csa_statistics.h"
 #include "motis/csa/csa_timetable.h"
 #include "motis/csa/csa_to_journey.h"
 #include "motis/csa/error.h"
 #include "motis/csa/run_csa_search.h"
+#include "motis/csa/update_csa_timetable.h"
 
 using namespace motis::module;
 using namespace motis::routing;
 
 namespace motis::csa {
 
-csa::csa() : module("CSA", "csa") {
+csa::csa()
+    : module("CSA", "csa"),
+      search_states_{std::make_unique<csa_search_state_pools>()},
+      rt_{std::make_unique<csa_rt_state>()} {
   bool_param(bridge_zero_duration_connections_, "bridge",
              "Bridge zero duration connections (required for GPU CSA)");
   bool_param(add_footpath_connections_, "expand_footpaths",
              "Add CSA connections representing connection and footpath");
+  size_t_param(day_stream_cache_size_, "day_stream_cache_size",
+               "max. number of cached per day connection streams (0=off)");
 }
 
 csa::~csa() = default;
 
+namespace {
+
+implementation_type default_implementation_type() {
+  if (cpu::has_avx2()) {
+    return implementation_type::CPU_AVX2;
+  }
+#ifdef MOTIS_AVX
+  return implementation_type::CPU_SSE;
+#else
+  return implementation_type::CPU;
+#endif
+}
+
+}  // namespace
+
 void csa::init(motis::module::registry& reg) {
   timetable_ = build_csa_timetable(synced_sched<RO>().sched(),
                                    bridge_zero_duration_connections_,
-                                   add_footpath_connections_);
+                                   add_footpath_connections_,
+                                   day_stream_cache_size_);
+  reg.subscribe(
+      "/rt/update", [&](msg_ptr const& msg) { return rt_update(msg); },
+      access_t::WRITE);
   reg.register_op("/csa", [&](msg_ptr const& msg) {
-#ifdef MOTIS_AVX
-    return route(msg, implementation_type::CPU_SSE);
-#else
-    return route(msg, implementation_type::CPU);
-#endif
+    return route(msg, default_implementation_type());
   });
   reg.register_op("/csa/cpu", [&](msg_ptr const& msg) {
     return route(msg, implementation_type::CPU);
   });
+  reg.register_op("/csa/batch",
+                  [&](msg_ptr const& msg) { return route_batch(msg); });
+  reg.register_op("/csa/cpu/profile", [&](msg_ptr const& msg) {
+    return route(msg, implementation_type::CPU_PROFILE);
+  });
+
+#ifdef MOTIS_CSA_AVX2
+  if (cpu::has_avx2()) {
+    reg.register_op("/csa/cpu/avx2", [&](msg_ptr const& msg) {
+      return route(msg, implementation_type::CPU_AVX2);
+    });
+  }
+#endif
 
 #ifdef MOTIS_AVX
   reg.register_op("/csa/cpu/sse", [&](msg_ptr const& msg) {
@@ -57,29 +93,76 @@ void csa::init(motis::module::registry& reg) {
 
 csa_timetable const* csa::get_timetable() const { return timetable_.get(); }
 
+namespace {
+
+flatbuffers::Offset<RoutingResponse> write_response(
+    message_creator& mc, schedule const& sched, response const& r,
+    csa_update_statistics const& rt_stats) {
+  return CreateRoutingResponse(
+      mc,
+      mc.CreateVector(std::vector<flatbuffers::Offset<Statistics>>{
+          to_fbs(mc, to_stats_category("csa", r.stats_)),
+          to_fbs(mc, to_stats_category("csa_rt", rt_stats))}),
+      mc.CreateVector(utl::to_vec(r.journeys_,
+                                  [&](auto const& cj) {
+                                    return to_connection(
+                                        mc, csa_to_journey(sched, cj));
+                                  })),
+      motis_to_unixtime(sched, r.searched_interval_.begin_),
+      motis_to_unixtime(sched, r.searched_interval_.end_),
+      mc.CreateVector(std::vector<flatbuffers::Offset<DirectConnection>>()));
+}
+
+}  // namespace
+
 motis::module::msg_ptr csa::route(motis::module::msg_ptr const& msg,
                                   implementation_type impl_type) const {
   auto const req = motis_content(RoutingRequest, msg);
   auto const& sched = get_schedule();
-  auto const response = run_csa_search(
-      sched, *timetable_, csa_query(sched, req), req->search_type(), impl_type);
+  auto const response =
+      run_csa_search(sched, *timetable_, csa_query(sched, req),
+                     req->search_type(), impl_type, *search_states_);
   message_creator mc;
   mc.create_and_finish(
       MsgContent_RoutingResponse,
-      CreateRoutingResponse(
-          mc,
-          mc.CreateVector(std::vector<flatbuffers::Offset<Statistics>>{
-              to_fbs(mc, to_stats_category("csa", response.stats_))}),
-          mc.CreateVector(utl::to_vec(response.journeys_,
-                                      [&](auto const& cj) {
-                                        return to_connection(
-                                            mc, csa_to_journey(sched, cj));
-                                      })),
-          motis_to_unixtime(sched, response.searched_interval_.begin_),
-          motis_to_unixtime(sched, response.searched_interval_.end_),
-          mc.CreateVector(std::vector<flatbuffers::Offset<DirectConnection>>()))
+      write_response(mc, sched, response, rt_->stats_).Union());
+  return make_msg(mc);
+}
+
+motis::module::msg_ptr csa::route_batch(
+    motis::module::msg_ptr const& msg) const {
+  auto const req = motis_content(RoutingBatchRequest, msg);
+  auto const& sched = get_schedule();
+  auto const queries = utl::to_vec(*req->requests(), [&](auto&& r) {
+    if (r->search_type() != SearchType_Default) {
+      throw std::system_error(error::search_type_not_supported);
+    }
+    return csa_query(sched, r);
+  });
+  auto const responses =
+      run_csa_batch_search(sched, *timetable_, queries, *search_states_);
+  message_creator mc;
+  mc.create_and_finish(
+      MsgContent_RoutingBatchResponse,
+      CreateRoutingBatchResponse(
+          mc, mc.CreateVector(utl::to_vec(
+                  responses,
+                  [&](auto const& r) {
+                    return write_response(mc, sched, r, rt_->stats_);
+                  })))
           .Union());
   return make_msg(mc);
 }
 
+motis::module::msg_ptr csa::rt_update(motis::module::msg_ptr const& msg) {
+  using motis::rt::RtUpdate;
+  update_csa_timetable(get_schedule(), *timetable_, *rt_,
+                       *motis_content(RtUpdate, msg));
+  LOG(logging::info) << "csa rt update: "
+                     << rt_->stats_.last_update_duration_ << "us, "
+                     << rt_->stats_.connections_updated_
+                     << " connections updated in total";
+  return nullptr;
+}
+
 }  // namespace motis::csa
@@ -0,0 +1,44 @@
+#include "motis/csa/csa_day_streams.h"
+
+#include "motis/csa/csa_timetable.h"
+
+namespace motis::csa {
+
+namespace {
+
+csa_day_stream build_stream(csa_timetable const& tt, search_dir const dir,
+                            int const day) {
+  auto const& scan = dir == search_dir::FWD ? tt.fwd_scan_ : tt.bwd_scan_;
+  csa_day_stream stream;
+  for (auto i = 0U; i < scan.size(); ++i) {
+    if (tt.traffic_days_.test(day, scan.traffic_days(i))) {
+      stream.emplace_back(i);
+    }
+  }
+  stream.shrink_to_fit();
+  return stream;
+}
+
+}  // namespace
+
+csa_day_streams::csa_day_streams(std::size_t const max_size)
+    : cache_{max_size} {}
+
+std::shared_ptr<csa_day_stream const> csa_day_streams::get(
+    csa_timetable const& tt, search_dir const dir, int const day) {
+  auto const k = std::pair{dir, day};
+  if (auto cached = cache_.get(k)) {
+    return *cached;
+  }
+
+  // Built without holding the lock: concurrent searches for other days are
+  // not blocked. If two searches build the same day, the first one wins.
+  return cache_.put(
+      k, std::make_shared<csa_day_stream const>(build_stream(tt, dir, day)));
+}
+
+std::size_t csa_day_streams::size() { return cache_.size(); }
+
+void csa_day_streams::clear() { cache_.clear(); }
+
+}  // namespace motis::csa
@@ -1,14 +1,18 @@
 #include "motis/csa/run_csa_search.h"
 
+#include <algorithm>
+#include <map>
+
 #include "motis/core/common/timing.h"
 
-#ifdef MOTIS_AVX
-#include "motis/csa/cpu/csa_search_default_cpu_sse.h"
-#endif
 #ifdef MOTIS_CUDA
 #include "motis/csa/gpu/gpu_search.h"
 #endif
+#include "motis/csa/cpu/csa_batch_search_default_cpu.h"
+#include "motis/csa/cpu/csa_profile_search_default_cpu.h"
 #include "motis/csa/cpu/csa_search_default_cpu.h"
+#include "motis/csa/cpu/csa_search_default_cpu_avx2.h"
+#include "motis/csa/csa_search_state_pools.h"
 #include "motis/csa/error.h"
 #include "motis/csa/pareto_set.h"
 #include "motis/csa/pretrip.h"
@@ -27,12 +31,20 @@ inline auto make_ontrip_pareto_set() {
 
 template <typename CSASearch>
 response run_search(schedule const& sched, csa_timetable const& tt,
-                    csa_query const& q) {
+                    csa_query const& q, csa_search_state_pools& pools) {
   csa_statistics stats;
+  auto& pool = pools.get<CSASearch>();
 
   if (q.is_ontrip()) {
     MOTIS_START_TIMING(total_timing);
-    CSASearch csa(tt, q.search_interval_.begin_, stats);
+    search_state_retriever<typename CSASearch::search_state> state{
+        pool, tt, [&]() { return CSASearch::make_search_state(tt); }};
+
+    MOTIS_START_TIMING(reset_timing);
+    state.get().reset();
+    MOTIS_STOP_TIMING(reset_timing);
+
+    CSASearch csa(tt, q.search_interval_.begin_, state.get(), stats);
     for (auto const& start_idx : q.meta_starts_) {
       csa.add_start(tt.stations_.at(start_idx), 0);
     }
@@ -51,6 +63,7 @@ response run_search(schedule const& sched, csa_timetable const& tt,
     MOTIS_STOP_TIMING(reconstruction_timing);
     MOTIS_STOP_TIMING(total_timing);
 
+    stats.reset_duration_ = MOTIS_TIMING_US(reset_timing);
     stats.search_duration_ = MOTIS_TIMING_MS(search_timing);
     stats.reconstruction_duration_ = MOTIS_TIMING_MS(reconstruction_timing);
     stats.total_duration_ = MOTIS_TIMING_MS(total_timing);
@@ -58,7 +71,7 @@ response run_search(schedule const& sched, csa_timetable const& tt,
     return {stats, std::move(results.set_), q.search_interval_};
   } else {
     return pretrip<pretrip_iterated_ontrip_search<CSASearch>>(sched, tt, q,
-                                                              stats)
+                                                              stats, pool)
         .search();
   }
 }
@@ -66,22 +79,52 @@ response run_search(schedule const& sched, csa_timetable const& tt,
 template <search_dir Dir>
 response dispatch_search_type(schedule const& sched, csa_timetable const& tt,
                               csa_query const& q, SearchType const search_type,
-                              implementation_type const impl_type) {
+                              implementation_type const impl_type,
+                              csa_search_state_pools& pools) {
   switch (impl_type) {
     case implementation_type::CPU:
       switch (search_type) {
         case SearchType_Default:
           // case SearchType_Accessibility:
-          return run_search<cpu::csa_search<Dir>>(sched, tt, q);
+          return run_search<cpu::csa_search<Dir>>(sched, tt, q, pools);
+        default: throw std::system_error(error::search_type_not_supported);
+      }
+
+    case implementation_type::CPU_PROFILE:
+      switch (search_type) {
+        case SearchType_Default:
+          // Ontrip and backward queries fall back to the regular CPU search.
+          if constexpr (Dir == search_dir::FWD) {
+            if (!q.is_ontrip()) {
+              csa_statistics stats;
+              return pretrip<cpu::csa_profile_search>(
+                         sched, tt, q, stats,
+                         pools.get<cpu::csa_profile_search>())
+                  .search();
+            }
+          }
+          return run_search<cpu::csa_search<Dir>>(sched, tt, q, pools);
         default: throw std::system_error(error::search_type_not_supported);
       }
 
+#ifdef MOTIS_CSA_AVX2
+    case implementation_type::CPU_AVX2:
+      if (!cpu::has_avx2()) {
+        throw std::system_error(error::search_type_not_supported);
+      }
+      switch (search_type) {
+        case SearchType_Default:
+          return run_search<cpu::avx2::csa_search<Dir>>(sched, tt, q, pools);
+        default: throw std::system_error(error::search_type_not_supported);
+      }
+#endif
+
 #ifdef MOTIS_AVX
     case implementation_type::CPU_SSE:
       switch (search_type) {
         case SearchType_Default:
           // case SearchType_Accessibility:
-          return run_search<cpu::sse::csa_search<Dir>>(sched, tt, q);
+          return run_search<cpu::sse::csa_search<Dir>>(sched, tt, q, pools);
         default: throw std::system_error(error::search_type_not_supported);
       }
 #endif
@@ -116,7 +159,8 @@ response dispatch_search_type(schedule const& sched, csa_timetable const& tt,
 
 response run_csa_search(schedule const& sched, csa_timetable const& tt,
                         csa_query const& q, SearchType const search_type,
-                        implementation_type const impl_type) {
+                        implementation_type const impl_type,
+                        csa_search_state_pools& pools) {
   if ((tt.fwd_connections_.empty() && q.dir_ == search_dir::FWD) ||
       (tt.bwd_connections_.empty() && q.dir_ == search_dir::BWD)) {
     response r;
@@ -124,10 +168,95 @@ response run_csa_search(schedule const& sched, csa_timetable const& tt,
     return r;
   }
 
-  return q.dir_ == search_dir::FWD ? dispatch_search_type<search_dir::FWD>(
-                                         sched, tt, q, search_type, impl_type)
-                                   : dispatch_search_type<search_dir::BWD>(
-                                         sched, tt, q, search_type, impl_type);
+  return q.dir_ == search_dir::FWD
+             ? dispatch_search_type<search_dir::FWD>(sched, tt, q, search_type,
+                                                     impl_type, pools)
+             : dispatch_search_type<search_dir::BWD>(sched, tt, q, search_type,
+                                                     impl_type, pools);
+}
+
+void run_batch(csa_timetable const& tt, std::vector<csa_query> const& queries,
+               std::vector<std::size_t> const& batch, time const start_time,
+               csa_search_state_pools& pools,
+               std::vector<response>& responses) {
+  csa_statistics stats;
+
+  MOTIS_START_TIMING(total_timing);
+  search_state_retriever<cpu::csa_batch_search::search_state> state{
+      pools.get<cpu::csa_batch_search>(), tt,
+      [&]() { return cpu::csa_batch_search::make_search_state(tt); }};
+
+  MOTIS_START_TIMING(reset_timing);
+  state.get().reset();
+  MOTIS_STOP_TIMING(reset_timing);
+
+  cpu::csa_batch_search csa(tt, start_time, state.get(), stats);
+  for (auto lane = 0U; lane < batch.size(); ++lane) {
+    for (auto const& start_idx : queries[batch[lane]].meta_starts_) {
+      csa.add_start(lane, tt.stations_.at(start_idx), 0);
+    }
+  }
+
+  MOTIS_START_TIMING(search_timing);
+  csa.search();
+  MOTIS_STOP_TIMING(search_timing);
+
+  MOTIS_START_TIMING(reconstruction_timing);
+  std::vector<std::vector<csa_journey>> journeys(batch.size());
+  for (auto lane = 0U; lane < batch.size(); ++lane) {
+    auto results = make_ontrip_pareto_set();
+    for (auto const& dest_idx : queries[batch[lane]].meta_dests_) {
+      for (auto j : csa.get_results(lane, tt.stations_.at(dest_idx))) {
+        results.push_back(j);
+      }
+    }
+    journeys[lane] = std::move(results.set_);
+  }
+  MOTIS_STOP_TIMING(reconstruction_timing);
+  MOTIS_STOP_TIMING(total_timing);
+
+  stats.reset_duration_ = MOTIS_TIMING_US(reset_timing);
+  stats.search_duration_ = MOTIS_TIMING_MS(search_timing);
+  stats.reconstruction_duration_ = MOTIS_TIMING_MS(reconstruction_timing);
+  stats.total_duration_ = MOTIS_TIMING_MS(total_timing);
+
+  for (auto lane = 0U; lane < batch.size(); ++lane) {
+    auto const& q = queries[batch[lane]];
+    responses[batch[lane]] = {stats, std::move(journeys[lane]),
+                              q.search_interval_};
+  }
+}
+
+std::vector<response> run_csa_batch_search(
+    schedule const& sched, csa_timetable const& tt,
+    std::vector<csa_query> const& queries, csa_search_state_pools& pools) {
+  std::vector<response> responses(queries.size());
+
+  std::map<time, std::vector<std::size_t>> batches;
+  for (auto i = 0U; i < queries.size(); ++i) {
+    auto const& q = queries[i];
+    if (q.dir_ == search_dir::FWD && q.is_ontrip() &&
+        !tt.fwd_connections_.empty()) {
+      batches[q.search_interval_.begin_].emplace_back(i);
+    } else {
+      responses[i] = run_csa_search(sched, tt, q, SearchType_Default,
+                                    implementation_type::CPU, pools);
+    }
+  }
+
+  for (auto const& [start_time, query_indices] : batches) {
+    for (auto offset = std::size_t{0U}; offset < query_indices.size();
+         offset += cpu::BATCH_SIZE) {
+      auto const batch_end = std::min(
+          offset + std::size_t{cpu::BATCH_SIZE}, query_indices.size());
+      run_batch(tt, queries,
+                {std::next(begin(query_indices), offset),
+                 std::next(begin(query_indices), batch_end)},
+                start_time, pools, responses);
+    }
+  }
+
+  return responses;
 }
 
 }  // namespace motis::csa
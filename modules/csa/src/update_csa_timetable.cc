@@ -0,0 +1,351 @@
+#include "motis/csa/update_csa_timetable.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "utl/verify.h"
+
+#include "motis/core/common/timing.h"
+#include "motis/core/access/station_access.h"
+#include "motis/core/access/time_access.h"
+#include "motis/core/conv/event_type_conv.h"
+#include "motis/core/conv/trip_conv.h"
+
+namespace motis::csa {
+
+namespace {
+
+struct rotation {
+  // Index of the element at old_idx after std::rotate(first, middle, last).
+  std::size_t new_index(std::size_t const old_idx) const {
+    if (old_idx < first_ || old_idx >= last_) {
+      return old_idx;
+    }
+    return old_idx < middle_ ? old_idx + (last_ - middle_)
+                             : old_idx - (middle_ - first_);
+  }
+
+  bool empty() const { return first_ == last_; }
+
+  std::size_t first_{0U}, middle_{0U}, last_{0U};
+};
+
+// Position of connection i after its sort key changed. cmp(a, b) is the
+// sort order of the array (FWD: departure ascending, BWD: arrival
+// descending). Like a stable sort, the connection stays in front of the
+// connections with the same key that followed it and behind those that
+// preceded it (e.g. zero duration connections of the same trip).
+template <typename Key, typename Cmp>
+rotation get_rotation(std::vector<csa_connection> const& cons,
+                      std::size_t const i, Key&& key, Cmp&& cmp) {
+  auto const k = key(cons[i]);
+  auto const before = [&](int16_t const t, csa_connection const& c) {
+    return cmp(t, key(c));
+  };
+  auto const after = [&](csa_connection const& c, int16_t const t) {
+    return cmp(key(c), t);
+  };
+  if (i + 1U < cons.size() && cmp(key(cons[i + 1U]), k)) {
+    auto const j = std::lower_bound(std::next(begin(cons), i + 1U), end(cons),
+                                    k, after);
+    return {i, i + 1U,
+            static_cast<std::size_t>(std::distance(begin(cons), j))};
+  } else if (i != 0U && cmp(k, key(cons[i - 1U]))) {
+    auto const j =
+        std::upper_bound(begin(cons), std::next(begin(cons), i), k, before);
+    return {static_cast<std::size_t>(std::distance(begin(cons), j)), i,
+            i + 1U};
+  }
+  return {};
+}
+
+void apply(std::vector<csa_connection>& cons, csa_scan_connections& scan,
+           rotation const& r) {
+  std::rotate(std::next(begin(cons), r.first_),
+              std::next(begin(cons), r.middle_),
+              std::next(begin(cons), r.last_));
+  scan.rotate(r.first_, r.middle_, r.last_);
+}
+
+// trip_to_connections_ and the station lists point into fwd_connections_.
+void fix_pointers(csa_timetable& tt, rotation const& r) {
+  auto& cons = tt.fwd_connections_;
+  std::vector<station_id> stations;
+  for (auto i = r.first_; i < r.last_; ++i) {
+    auto const& con = cons[i];
+    if (con.light_con_ != nullptr) {
+      tt.trip_to_connections_[con.trip_][con.trip_con_idx_] = &con;
+    }
+    stations.emplace_back(con.from_station_);
+    stations.emplace_back(con.to_station_);
+  }
+  std::sort(begin(stations), end(stations));
+  stations.erase(std::unique(begin(stations), end(stations)), end(stations));
+
+  auto const remap = [&](std::vector<csa_connection const*>& list) {
+    for (auto& con : list) {
+      con = &cons[r.new_index(
+          static_cast<std::size_t>(std::distance(cons.data(), con)))];
+    }
+  };
+  for (auto const s : stations) {
+    remap(tt.stations_[s].outgoing_connections_);
+    remap(tt.stations_[s].incoming_connections_);
+  }
+}
+
+// bwd_connections_ are sorted by arrival (descending).
+std::size_t find_bwd(csa_timetable const& tt, csa_connection const& fwd_con) {
+  auto const& cons = tt.bwd_connections_;
+  auto const arrival = fwd_con.arrival_;
+  auto const lower = std::lower_bound(
+      begin(cons), end(cons), arrival,
+      [](csa_connection const& c, int16_t const t) { return c.arrival_ > t; });
+  auto const upper = std::upper_bound(
+      lower, end(cons), arrival,
+      [](int16_t const t, csa_connection const& c) { return t > c.arrival_; });
+  auto const it = std::find_if(lower, upper, [&](csa_connection const& c) {
+    return c.trip_ == fwd_con.trip_ &&
+           c.trip_con_idx_ == fwd_con.trip_con_idx_;
+  });
+  return it == upper ? cons.size()
+                     : static_cast<std::size_t>(std::distance(begin(cons), it));
+}
+
+// Minutes relative to the first day of the trip.
+int trip_time(csa_connection const& c, event_type const ev_type) {
+  return c.day_offset_ * MINUTES_A_DAY +
+         (ev_type == event_type::DEP ? c.departure_ : c.arrival_);
+}
+
+int day_of(int const trip_time) {
+  return trip_time >= 0
+             ? trip_time / MINUTES_A_DAY
+             : -((-trip_time + MINUTES_A_DAY - 1) / MINUTES_A_DAY);
+}
+
+// Bitfield with day d set iff day d - shift is set in bf.
+compact_bitfield shift_days(compact_bitfield const& bf, int const shift,
+                            std::deque<std::vector<uint64_t>>& words) {
+  auto const first = std::max(0, bf.first_day_ + shift);
+  auto const last = std::max(first, bf.first_day_ + bf.day_count_ + shift);
+
+  compact_bitfield shifted;
+  shifted.first_day_ = static_cast<uint16_t>(first);
+  shifted.day_count_ = static_cast<uint16_t>(last - first);
+  auto* bits = &shifted.bits_;
+  if (shifted.day_count_ > 64U) {
+    bits = words.emplace_back((shifted.day_count_ + 63U) / 64U).data();
+    shifted.words_ = bits;
+  }
+  for (auto day = first; day < last; ++day) {
+    if (bf.test(static_cast<std::size_t>(day - shift))) {
+      auto const rel = static_cast<unsigned>(day - first);
+      bits[rel / 64U] |= uint64_t{1U} << (rel % 64U);
+    }
+  }
+  return shifted;
+}
+
+// Traffic days of a connection whose departure moved by shift days.
+std::pair<compact_bitfield const*, uint32_t> get_traffic_days(
+    csa_timetable& tt, csa_rt_state& rt, csa_schedule_days const& sched_days,
+    int const shift) {
+  if (shift == 0) {
+    return {sched_days.traffic_days_, sched_days.traffic_days_idx_};
+  }
+
+  auto const [it, inserted] = rt.shifted_traffic_days_.emplace(
+      std::make_pair(sched_days.traffic_days_idx_, shift),
+      std::pair<compact_bitfield const*, uint32_t>{});
+  if (inserted) {
+    auto const& bf = rt.shifted_bitfields_.emplace_back(
+        shift_days(*sched_days.traffic_days_, shift, rt.shifted_words_));
+    auto const idx = tt.traffic_days_.add(bf);
+    utl::verify(idx <= csa_scan_connections::TRAFFIC_DAYS_MASK,
+                "csa: too many traffic day bitfields");
+    it->second = {&bf, idx};
+  }
+  return it->second;
+}
+
+void set_traffic_days(csa_scan_connections& scan, std::size_t const i,
+                      uint32_t const idx) {
+  scan.traffic_days_[i] =
+      (scan.traffic_days_[i] & ~csa_scan_connections::TRAFFIC_DAYS_MASK) | idx;
+}
+
+}  // namespace
+
+void update_csa_timetable(schedule const& sched, csa_timetable& tt,
+                          csa_rt_state& rt, motis::rt::RtUpdate const& update) {
+  MOTIS_START_TIMING(update_timing);
+
+  auto& stats = rt.stats_;
+  auto const by_departure = [](csa_connection const& c) {
+    return c.departure_;
+  };
+  auto const by_arrival = [](csa_connection const& c) { return c.arrival_; };
+
+  for (auto const& node : *update.shifted_nodes()) {
+    ++stats.shifted_nodes_;
+    if (node->canceled()) {
+      ++stats.canceled_;
+      continue;
+    }
+
+    trip const* trp = nullptr;
+    try {
+      trp = from_fbs(sched, node->trip());
+    } catch (...) {
+      trp = nullptr;
+    }
+    auto const trip_it =
+        trp == nullptr ? end(tt.trip_ids_) : tt.trip_ids_.find(trp);
+    if (trip_it == end(tt.trip_ids_)) {
+      ++stats.trip_not_found_;
+      continue;
+    }
+
+    auto const st = find_station(sched, node->station_id()->str());
+    if (st == nullptr) {
+      ++stats.station_not_found_;
+      continue;
+    }
+
+    auto const ev_type = from_fbs(node->event_type());
+    auto const station = st->index_;
+    auto const sched_time = unix_to_motistime(sched, node->schedule_time());
+    auto const delay =
+        unix_to_motistime(sched, node->updated_time()).ts() - sched_time.ts();
+
+    // Find the connection (trip_to_connections_ points into fwd).
+    auto const& trip_cons = tt.trip_to_connections_[trip_it->second];
+    auto const con_it =
+        std::find_if(begin(trip_cons), end(trip_cons), [&](auto&& c) {
+          auto const key = std::make_tuple(c->trip_, c->trip_con_idx_, ev_type);
+          auto const orig_it = rt.schedule_times_.find(key);
+          auto const orig = orig_it != end(rt.schedule_times_)
+                                ? orig_it->second
+                                : trip_time(*c, ev_type);
+          return (ev_type == event_type::DEP ? c->from_station_
+                                             : c->to_station_) == station &&
+                 time(orig).mam() == sched_time.mam();
+        });
+    if (con_it == end(trip_cons)) {
+      ++stats.event_not_found_;
+      continue;
+    }
+
+    auto const fwd_idx = static_cast<std::size_t>(
+        std::distance(tt.fwd_connections_.data(), *con_it));
+    auto& fwd_con = tt.fwd_connections_[fwd_idx];
+    auto const current = trip_time(fwd_con, ev_type);
+    auto const orig =
+        rt.schedule_times_
+            .emplace(std::make_tuple(fwd_con.trip_, fwd_con.trip_con_idx_,
+                                     ev_type),
+                     static_cast<int16_t>(current))
+            .first->second;
+    auto const new_time = orig + delay;
+    if (new_time == current) {
+      continue;
+    }
+
+    auto const bwd_idx = find_bwd(tt, fwd_con);
+    auto const old_departure = fwd_con.departure_;
+    auto const old_arrival = fwd_con.arrival_;
+    ++stats.connections_updated_;
+
+    // departure_ stays a minute of the day, arrival_ is relative to the
+    // departure day (before the departure until the propagated arrival of
+    // the same batch has been applied)
+    if (ev_type == event_type::DEP) {
+      auto const arrival = trip_time(fwd_con, event_type::ARR);
+      rt.schedule_times_.emplace(
+          std::make_tuple(fwd_con.trip_, fwd_con.trip_con_idx_,
+                          event_type::ARR),
+          static_cast<int16_t>(arrival));
+      auto const day = day_of(new_time);
+      if (day != fwd_con.day_offset_) {
+        ++stats.day_changed_;
+        auto const& sched_days =
+            rt.schedule_days_
+                .emplace(std::make_pair(fwd_con.trip_, fwd_con.trip_con_idx_),
+                         csa_schedule_days{fwd_con.day_offset_,
+                                           fwd_con.traffic_days_,
+                                           tt.fwd_scan_.traffic_days(fwd_idx)})
+                .first->second;
+        auto const [bf, bf_idx] =
+            get_traffic_days(tt, rt, sched_days, day - sched_days.day_offset_);
+        fwd_con.traffic_days_ = bf;
+        fwd_con.day_offset_ = static_cast<day_idx_t>(day);
+        set_traffic_days(tt.fwd_scan_, fwd_idx, bf_idx);
+        if (bwd_idx != tt.bwd_connections_.size()) {
+          set_traffic_days(tt.bwd_scan_, bwd_idx, bf_idx);
+        }
+      }
+      fwd_con.departure_ = static_cast<int16_t>(new_time - day * MINUTES_A_DAY);
+      fwd_con.arrival_ = static_cast<int16_t>(arrival - day * MINUTES_A_DAY);
+    } else {
+      fwd_con.arrival_ = static_cast<int16_t>(
+          new_time - fwd_con.day_offset_ * MINUTES_A_DAY);
+    }
+
+    // A departure delayed past the day change may precede the not (yet)
+    // delayed arrival: arrivals are read as unsigned minutes of the
+    // departure day (time(day, arrival)), negative values would wrap.
+    fwd_con.arrival_ = std::max(fwd_con.arrival_, fwd_con.departure_);
+    tt.fwd_scan_.departure_[fwd_idx] = fwd_con.departure_;
+    tt.fwd_scan_.arrival_[fwd_idx] = fwd_con.arrival_;
+
+    if (bwd_idx != tt.bwd_connections_.size()) {
+      auto& bwd_con = tt.bwd_connections_[bwd_idx];
+      bwd_con.departure_ = fwd_con.departure_;
+      bwd_con.arrival_ = fwd_con.arrival_;
+      bwd_con.day_offset_ = fwd_con.day_offset_;
+      bwd_con.traffic_days_ = fwd_con.traffic_days_;
+      tt.bwd_scan_.departure_[bwd_idx] = bwd_con.departure_;
+      tt.bwd_scan_.arrival_[bwd_idx] = bwd_con.arrival_;
+    }
+
+    // fwd: departure is the sort key (invalidates fwd_con)
+    if (fwd_con.departure_ != old_departure) {
+      auto const r = get_rotation(tt.fwd_connections_, fwd_idx, by_departure,
+                                  std::less<>());
+      if (!r.empty()) {
+        apply(tt.fwd_connections_, tt.fwd_scan_, r);
+        fix_pointers(tt, r);
+        ++stats.connections_moved_;
+      }
+    }
+
+    // bwd: arrival is the sort key
+    if (bwd_idx != tt.bwd_connections_.size() &&
+        tt.bwd_connections_[bwd_idx].arrival_ != old_arrival) {
+      auto const r = get_rotation(tt.bwd_connections_, bwd_idx, by_arrival,
+                                  std::greater<>());
+      if (!r.empty()) {
+        apply(tt.bwd_connections_, tt.bwd_scan_, r);
+        ++stats.connections_moved_;
+      }
+    }
+  }
+
+  if (tt.day_streams_ != nullptr) {
+    tt.day_streams_->clear();
+  }
+
+  MOTIS_STOP_TIMING(update_timing);
+  auto const duration = static_cast<uint64_t>(MOTIS_TIMING_US(update_timing));
+  ++stats.batches_;
+  stats.last_update_duration_ = duration;
+  stats.max_update_duration_ = std::max(stats.max_update_duration_, duration);
+  stats.total_update_duration_ += duration;
+}
+
+}  // namespace motis::csa
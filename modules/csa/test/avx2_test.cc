@@ -0,0 +1,80 @@
+#include "gtest/gtest.h"
+
+#include "motis/core/access/time_access.h"
+
+#include "motis/csa/cpu/csa_search_default_cpu.h"
+#include "motis/csa/cpu/csa_search_default_cpu_avx2.h"
+#include "motis/csa/csa.h"
+
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace motis;
+using namespace motis::test;
+using motis::test::schedule::simple_realtime::dataset_opt;
+
+#ifdef MOTIS_CSA_AVX2
+
+struct csa_avx2 : public motis_instance_test {
+  csa_avx2() : motis::test::motis_instance_test(dataset_opt, {"csa"}) {}
+
+  csa::csa_timetable const& tt() {
+    return *get_module<csa::csa>("csa").get_timetable();
+  }
+};
+
+// Forward search only: the scalar backward scan is not adjusted to the
+// traffic day bitfields yet (see csa_search::search).
+TEST_F(csa_avx2, same_results_as_scalar_search) {  // NOLINT
+  if (!csa::cpu::has_avx2()) {
+    GTEST_SKIP() << "AVX2 not supported";
+  }
+
+  using scalar_search = csa::cpu::csa_search<search_dir::FWD>;
+  using avx2_search = csa::cpu::avx2::csa_search<search_dir::FWD>;
+  using avx2_arrivals = avx2_search::arrival_times_view;
+  auto const& stations = tt().stations_;
+  auto journey_count = 0U;
+
+  for (auto const hhmm : {0, 1000, 1400, 2300}) {
+    auto const start_time = motis_time(hhmm);
+    for (auto const& start : stations) {
+      SCOPED_TRACE(start.id_);
+      auto const scalar_state = scalar_search::make_search_state(tt());
+      csa::csa_statistics scalar_stats;
+      scalar_search scalar{tt(), start_time, *scalar_state, scalar_stats};
+      scalar.add_start(start, motis::time{0});
+      scalar.search();
+
+      auto const avx2_state = avx2_search::make_search_state(tt());
+      csa::csa_statistics avx2_stats;
+      avx2_search avx2{tt(), start_time, *avx2_state, avx2_stats};
+      avx2.add_start(start, motis::time{0});
+      avx2.search();
+
+      auto const arrivals = avx2_arrivals{avx2.arrival_time_};
+      for (auto const& s : stations) {
+        for (auto k = 0; k <= csa::MAX_TRANSFERS; ++k) {
+          EXPECT_EQ(scalar.arrival_time_[s.id_][k],  // NOLINT
+                    arrivals[s.id_][k]);
+        }
+
+        auto const expected = scalar.get_results(s);
+        auto const actual = avx2.get_results(s);
+        ASSERT_EQ(expected.size(), actual.size());
+        journey_count += expected.size();
+        for (auto i = 0U; i < expected.size(); ++i) {
+          EXPECT_EQ(expected[i].arrival_time_, actual[i].arrival_time_);
+          EXPECT_EQ(expected[i].transfers_, actual[i].transfers_);
+          ASSERT_EQ(expected[i].edges_.size(), actual[i].edges_.size());
+          for (auto e = 0U; e < expected[i].edges_.size(); ++e) {
+            EXPECT_EQ(expected[i].edges_[e].con_, actual[i].edges_[e].con_);
+          }
+        }
+      }
+    }
+  }
+  EXPECT_NE(0U, journey_count);
+}
+
+#endif
@@ -0,0 +1,201 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "utl/to_vec.h"
+
+#include "motis/core/access/time_access.h"
+#include "motis/module/message.h"
+
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+
+#include "motis/csa/cpu/csa_batch_search_default_cpu.h"
+#include "motis/csa/cpu/csa_search_default_cpu.h"
+#include "motis/csa/csa.h"
+
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::test;
+using motis::test::schedule::simple_realtime::dataset_opt_short;
+
+using request_fn =
+    std::function<Offset<RoutingRequest>(message_creator&)>;
+
+struct csa_batch : public motis_instance_test {
+  csa_batch() : motis::test::motis_instance_test(dataset_opt_short, {"csa"}) {}
+
+  csa::csa_timetable const& tt() {
+    return *get_module<csa::csa>("csa").get_timetable();
+  }
+
+  static Offset<RoutingRequest> ontrip_request(message_creator& fbb,
+                                               char const* from,
+                                               char const* to) {
+    return CreateRoutingRequest(
+        fbb, Start_OntripStationStart,
+        CreateOntripStationStart(
+            fbb,
+            CreateInputStation(fbb, fbb.CreateString(from),
+                               fbb.CreateString("")),
+            unix_time(1400))
+            .Union(),
+        CreateInputStation(fbb, fbb.CreateString(to), fbb.CreateString("")),
+        SearchType_Default, SearchDir_Forward,
+        fbb.CreateVector(std::vector<Offset<Via>>()),
+        fbb.CreateVector(std::vector<Offset<AdditionalEdgeWrapper>>()));
+  }
+
+  static Offset<RoutingRequest> pretrip_request(message_creator& fbb,
+                                                char const* from,
+                                                char const* to) {
+    auto const interval = Interval{unix_time(1400), unix_time(1500)};
+    return CreateRoutingRequest(
+        fbb, Start_PretripStart,
+        CreatePretripStart(fbb,
+                           CreateInputStation(fbb, fbb.CreateString(from),
+                                              fbb.CreateString("")),
+                           &interval)
+            .Union(),
+        CreateInputStation(fbb, fbb.CreateString(to), fbb.CreateString("")),
+        SearchType_Default, SearchDir_Forward,
+        fbb.CreateVector(std::vector<Offset<Via>>()),
+        fbb.CreateVector(std::vector<Offset<AdditionalEdgeWrapper>>()));
+  }
+
+  std::vector<journey> single_query(request_fn const& create_request) {
+    message_creator fbb;
+    fbb.create_and_finish(MsgContent_RoutingRequest,
+                          create_request(fbb).Union(), "/csa");
+    auto const msg = call(make_msg(fbb));
+    return message_to_journeys(motis_content(RoutingResponse, msg));
+  }
+
+  static void expect_same_journeys(std::vector<journey> const& expected,
+                                   std::vector<journey> const& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (auto i = 0U; i < expected.size(); ++i) {
+      auto const& e = expected[i];
+      auto const& a = actual[i];
+      EXPECT_EQ(e.transports_.size(), a.transports_.size());
+      EXPECT_EQ(e.trips_.size(), a.trips_.size());
+      ASSERT_EQ(e.stops_.size(), a.stops_.size());
+      for (auto s = 0U; s < e.stops_.size(); ++s) {
+        EXPECT_EQ(e.stops_[s].eva_no_, a.stops_[s].eva_no_);
+        EXPECT_EQ(e.stops_[s].arrival_.timestamp_,
+                  a.stops_[s].arrival_.timestamp_);
+        EXPECT_EQ(e.stops_[s].departure_.timestamp_,
+                  a.stops_[s].departure_.timestamp_);
+      }
+    }
+  }
+};
+
+TEST_F(csa_batch, same_results_as_single_queries) {  // NOLINT
+  auto const queries = std::vector<request_fn>{
+      [](message_creator& fbb) {
+        return ontrip_request(fbb, "8000031", "8000105");
+      },
+      [](message_creator& fbb) {
+        return ontrip_request(fbb, "8000068", "8000207");
+      },
+      [](message_creator& fbb) {
+        return pretrip_request(fbb, "8000068", "8000207");
+      }};
+
+  message_creator fbb;
+  auto const requests = utl::to_vec(
+      queries, [&](request_fn const& create_request) {
+        return create_request(fbb);
+      });
+  fbb.create_and_finish(
+      MsgContent_RoutingBatchRequest,
+      CreateRoutingBatchRequest(fbb, fbb.CreateVector(requests)).Union(),
+      "/csa/batch");
+  auto const msg = call(make_msg(fbb));
+  auto const res = motis_content(RoutingBatchResponse, msg);
+  ASSERT_EQ(queries.size(), res->responses()->size());
+
+  for (auto i = 0U; i < queries.size(); ++i) {
+    SCOPED_TRACE(i);
+    expect_same_journeys(single_query(queries[i]),
+                         message_to_journeys(res->responses()->Get(i)));
+  }
+
+  auto const simple = message_to_journeys(res->responses()->Get(0));
+  ASSERT_EQ(1, simple.size());
+  ASSERT_EQ(3, simple[0].stops_.size());
+  EXPECT_EQ("8000031", simple[0].stops_[0].eva_no_);
+  EXPECT_EQ(unix_time(1409), simple[0].stops_[0].departure_.timestamp_);
+  EXPECT_EQ("8000105", simple[0].stops_[2].eva_no_);
+  EXPECT_EQ(unix_time(1440), simple[0].stops_[2].arrival_.timestamp_);
+
+  auto const pretrip = message_to_journeys(res->responses()->Get(2));
+  ASSERT_EQ(1, pretrip.size());
+  auto const& j = pretrip[0];
+  int i = 0;
+  EXPECT_EQ("8000068", j.stops_[i++].eva_no_);
+  EXPECT_EQ("8000105", j.stops_[i++].eva_no_);
+  EXPECT_EQ("8070003", j.stops_[i++].eva_no_);
+  EXPECT_EQ("8073368", j.stops_[i++].eva_no_);
+  EXPECT_EQ("8003368", j.stops_[i++].eva_no_);
+  EXPECT_EQ("8000207", j.stops_[i++].eva_no_);
+}
+
+// Runs the batch kernel directly (one lane per start station) and compares
+// every lane with a scalar search from the same station.
+TEST_F(csa_batch, kernel_same_as_scalar_search) {  // NOLINT
+  using scalar_search = csa::cpu::csa_search<search_dir::FWD>;
+  using batch_search = csa::cpu::csa_batch_search;
+  auto const& stations = tt().stations_;
+  auto journey_count = 0U;
+
+  for (auto const hhmm : {0, 1400, 2300}) {
+    auto const start_time = motis_time(hhmm);
+    for (auto first = 0U; first < stations.size();
+         first += csa::cpu::BATCH_SIZE) {
+      auto const lanes = std::min(
+          csa::cpu::BATCH_SIZE, static_cast<unsigned>(stations.size() - first));
+      auto const batch_state = batch_search::make_search_state(tt());
+      csa::csa_statistics batch_stats;
+      batch_search batch{tt(), start_time, *batch_state, batch_stats};
+      for (auto lane = 0U; lane < lanes; ++lane) {
+        batch.add_start(lane, stations[first + lane], motis::time{0});
+      }
+      batch.search();
+
+      for (auto lane = 0U; lane < lanes; ++lane) {
+        SCOPED_TRACE(first + lane);
+        auto const state = scalar_search::make_search_state(tt());
+        csa::csa_statistics stats;
+        scalar_search scalar{tt(), start_time, *state, stats};
+        scalar.add_start(stations[first + lane], motis::time{0});
+        scalar.search();
+
+        for (auto const& dest : stations) {
+          auto const expected = scalar.get_results(dest);
+          auto const actual = batch.get_results(lane, dest);
+          ASSERT_EQ(expected.size(), actual.size());
+          journey_count += expected.size();
+          for (auto i = 0U; i < expected.size(); ++i) {
+            EXPECT_EQ(expected[i].arrival_time_, actual[i].arrival_time_);
+            EXPECT_EQ(expected[i].transfers_, actual[i].transfers_);
+            ASSERT_EQ(expected[i].edges_.size(), actual[i].edges_.size());
+            for (auto e = 0U; e < expected[i].edges_.size(); ++e) {
+              EXPECT_EQ(expected[i].edges_[e].con_, actual[i].edges_[e].con_);
+              EXPECT_EQ(expected[i].edges_[e].departure_,
+                        actual[i].edges_[e].departure_);
+            }
+          }
+        }
+      }
+    }
+  }
+  EXPECT_NE(0U, journey_count);
+}
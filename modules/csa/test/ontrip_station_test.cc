@@ -9,6 +9,8 @@
 #include "motis/core/journey/journey.h"
 #include "motis/core/journey/message_to_journeys.h"
 
+#include "motis/csa/cpu/cpu_features.h"
+
 #include "motis/test/motis_instance_test.h"
 #include "motis/test/schedule/simple_realtime.h"
 
@@ -33,6 +35,14 @@ struct csa_ontrip_station
   csa_ontrip_station& operator=(csa_ontrip_station const&) = delete;
   csa_ontrip_station& operator=(csa_ontrip_station&&) = delete;
   ~csa_ontrip_station() override = default;
+
+  void SetUp() override {
+    // "/csa/cpu/avx2" is only registered on CPUs that support it
+    if (std::string_view{std::get<TARGET>(GetParam())} == "/csa/cpu/avx2" &&
+        !motis::csa::cpu::has_avx2()) {
+      GTEST_SKIP() << "AVX2 not supported";
+    }
+  }
 };
 
 TEST_P(csa_ontrip_station, simple_fwd) {  // NOLINT
@@ -196,11 +206,15 @@ TEST_P(csa_ontrip_station, interchange_fwd_pretrip) {  // NOLINT
 INSTANTIATE_TEST_SUITE_P(
     csa_ontrip_station, csa_ontrip_station,
     ::testing::Values(std::make_tuple(SearchType_Default, "/csa/cpu"),
+                      std::make_tuple(SearchType_Default, "/csa/cpu/profile"),
                       std::make_tuple(SearchType_Default, "/csa/cpu/sse"),
+                      std::make_tuple(SearchType_Default, "/csa/cpu/avx2"),
                       std::make_tuple(SearchType_Default, "/csa/gpu")));
 #else
 INSTANTIATE_TEST_SUITE_P(
     csa_ontrip_station, csa_ontrip_station,
     ::testing::Values(std::make_tuple(SearchType_Default, "/csa/cpu"),
-                      std::make_tuple(SearchType_Default, "/csa/cpu/sse")));
+                      std::make_tuple(SearchType_Default, "/csa/cpu/profile"),
+                      std::make_tuple(SearchType_Default, "/csa/cpu/sse"),
+                      std::make_tuple(SearchType_Default, "/csa/cpu/avx2")));
 #endif
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "motis/core/access/time_access.h"
+#include "motis/module/message.h"
+
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::test;
+using motis::test::schedule::simple_realtime::dataset_opt_short;
+
+// (departure, arrival, trip count, stations) of every journey
+using journey_summary =
+    std::tuple<int64_t, int64_t, std::size_t, std::vector<std::string>>;
+
+struct csa_profile : public motis_instance_test {
+  csa_profile()
+      : motis::test::motis_instance_test(dataset_opt_short, {"csa"}) {}
+
+  std::vector<journey_summary> route(char const* target, char const* from,
+                                     char const* to) {
+    auto const interval = Interval{unix_time(1400), unix_time(1500)};
+    message_creator fbb;
+    fbb.create_and_finish(
+        MsgContent_RoutingRequest,
+        CreateRoutingRequest(
+            fbb, Start_PretripStart,
+            CreatePretripStart(fbb,
+                               CreateInputStation(fbb, fbb.CreateString(from),
+                                                  fbb.CreateString("")),
+                               &interval)
+                .Union(),
+            CreateInputStation(fbb, fbb.CreateString(to),
+                               fbb.CreateString("")),
+            SearchType_Default, SearchDir_Forward,
+            fbb.CreateVector(std::vector<Offset<Via>>()),
+            fbb.CreateVector(std::vector<Offset<AdditionalEdgeWrapper>>()))
+            .Union(),
+        target);
+    auto const msg = call(make_msg(fbb));
+
+    std::vector<journey_summary> summaries;
+    for (auto const& j :
+         message_to_journeys(motis_content(RoutingResponse, msg))) {
+      std::vector<std::string> stations;
+      for (auto const& s : j.stops_) {
+        stations.emplace_back(s.eva_no_);
+      }
+      summaries.emplace_back(j.stops_.front().departure_.timestamp_,
+                             j.stops_.back().arrival_.timestamp_,
+                             j.trips_.size(), stations);
+    }
+    std::sort(begin(summaries), end(summaries));
+    return summaries;
+  }
+};
+
+TEST_F(csa_profile, same_results_as_iterated_ontrip_search) {  // NOLINT
+  auto const profile = route("/csa/cpu/profile", "8000068", "8000207");
+  ASSERT_EQ(1U, profile.size());
+  EXPECT_EQ(route("/csa/cpu", "8000068", "8000207"), profile);
+}
+
+TEST_F(csa_profile, reused_search_state) {  // NOLINT
+  // The second query of each pair runs on the pooled state of the other
+  // query: profiles and trip labels must not leak between searches.
+  auto const a = route("/csa/cpu/profile", "8000068", "8000207");
+  auto const b = route("/csa/cpu/profile", "8000031", "8000105");
+  ASSERT_FALSE(a.empty());
+  ASSERT_FALSE(b.empty());
+  EXPECT_EQ(a, route("/csa/cpu/profile", "8000068", "8000207"));
+  EXPECT_EQ(b, route("/csa/cpu/profile", "8000031", "8000105"));
+}
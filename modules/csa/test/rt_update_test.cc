@@ -0,0 +1,147 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "motis/core/access/time_access.h"
+#include "motis/core/conv/event_type_conv.h"
+#include "motis/core/conv/trip_conv.h"
+#include "motis/module/message.h"
+
+#include "motis/csa/csa.h"
+#include "motis/csa/csa_timetable.h"
+#include "motis/csa/update_csa_timetable.h"
+
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis;
+using namespace motis::module;
+using namespace motis::test;
+using motis::test::schedule::simple_realtime::dataset_opt;
+
+struct csa_rt_update : public motis_instance_test {
+  csa_rt_update() : motis::test::motis_instance_test(dataset_opt, {"csa"}) {}
+
+  csa::csa& module() { return get_module<csa::csa>("csa"); }
+  csa::csa_timetable const& tt() { return *module().get_timetable(); }
+
+  trip const* get_trip(csa::trip_id const id) {
+    auto const& ids = tt().trip_ids_;
+    auto const it = std::find_if(begin(ids), end(ids),
+                                 [&](auto const& e) { return e.second == id; });
+    return it == end(ids) ? nullptr : it->first;
+  }
+
+  void publish_departure(csa::csa_connection const& con, char const* station,
+                         motis::time const schedule_time,
+                         motis::time const updated_time) {
+    message_creator fbb;
+    fbb.create_and_finish(
+        MsgContent_RtUpdate,
+        rt::CreateRtUpdate(
+            fbb, fbb.CreateVector(std::vector<Offset<rt::ShiftedNode>>{
+                     rt::CreateShiftedNode(
+                         fbb, to_fbs(sched(), fbb, get_trip(con.trip_)),
+                         fbb.CreateString(station),
+                         motis_to_unixtime(sched(), schedule_time),
+                         to_fbs(event_type::DEP),
+                         motis_to_unixtime(sched(), updated_time),
+                         TimestampReason_IS, false)}))
+            .Union(),
+        "/rt/update", DestinationType_Topic);
+    publish(make_msg(fbb));
+  }
+
+  // Sort order, struct of arrays and all pointers into fwd_connections_.
+  void check_timetable() {
+    auto const& t = tt();
+    auto const check_scan = [](std::vector<csa::csa_connection> const& cons,
+                               csa::csa_scan_connections const& scan) {
+      ASSERT_EQ(cons.size(), scan.size());
+      for (auto i = 0U; i < cons.size(); ++i) {
+        EXPECT_EQ(cons[i].departure_, scan.departure_[i]);
+        EXPECT_EQ(cons[i].arrival_, scan.arrival_[i]);
+        EXPECT_EQ(cons[i].trip_, scan.trip_[i]);
+        EXPECT_EQ(cons[i].trip_con_idx_, scan.trip_con_idx_[i]);
+        EXPECT_GE(cons[i].departure_, 0);
+        EXPECT_LT(cons[i].departure_, MINUTES_A_DAY);
+      }
+    };
+    check_scan(t.fwd_connections_, t.fwd_scan_);
+    check_scan(t.bwd_connections_, t.bwd_scan_);
+
+    EXPECT_TRUE(std::is_sorted(
+        begin(t.fwd_connections_), end(t.fwd_connections_),
+        [](auto&& a, auto&& b) { return a.departure_ < b.departure_; }));
+    EXPECT_TRUE(std::is_sorted(
+        begin(t.bwd_connections_), end(t.bwd_connections_),
+        [](auto&& a, auto&& b) { return a.arrival_ > b.arrival_; }));
+
+    for (auto trip = 0U; trip < t.trip_to_connections_.size(); ++trip) {
+      auto const& cons = t.trip_to_connections_[trip];
+      for (auto i = 0U; i < cons.size(); ++i) {
+        EXPECT_EQ(trip, cons[i]->trip_);
+        EXPECT_EQ(i, cons[i]->trip_con_idx_);
+      }
+    }
+
+    for (auto const& s : t.stations_) {
+      for (auto const& con : s.outgoing_connections_) {
+        EXPECT_EQ(s.id_, con->from_station_);
+      }
+      for (auto const& con : s.incoming_connections_) {
+        EXPECT_EQ(s.id_, con->to_station_);
+      }
+    }
+  }
+};
+
+TEST_F(csa_rt_update, departure_moves_to_next_day) {  // NOLINT
+  constexpr auto const kDay = static_cast<int>(SCHEDULE_OFFSET_DAYS);
+
+  // latest departure on the first day: +1 day after the update
+  auto const& cons = tt().fwd_connections_;
+  auto const con_it = std::find_if(
+      cons.rbegin(), cons.rend(), [&](csa::csa_connection const& c) {
+        return c.light_con_ != nullptr && c.traffic_days_->test(kDay);
+      });
+  ASSERT_NE(cons.rend(), con_it);
+
+  auto const con = *con_it;
+  auto const station = sched().stations_.at(con.from_station_)->eva_nr_;
+  auto const schedule_time = motis::time(kDay, con.departure_);
+  auto const updated_time = motis::time(kDay + 1, 30);
+
+  publish_departure(con, "invalid_station", schedule_time, updated_time);
+  EXPECT_EQ(1U, module().rt_->stats_.station_not_found_);
+  EXPECT_EQ(0U, module().rt_->stats_.connections_updated_);
+
+  publish_departure(con, station.c_str(), schedule_time, updated_time);
+  auto const& stats = module().rt_->stats_;
+  EXPECT_EQ(1U, stats.connections_updated_);
+  EXPECT_EQ(1U, stats.day_changed_);
+  EXPECT_LE(1U, stats.connections_moved_);
+  check_timetable();
+
+  auto const& moved = *tt().trip_to_connections_[con.trip_][con.trip_con_idx_];
+  EXPECT_EQ(30, moved.departure_);
+  EXPECT_EQ(con.day_offset_ + 1, moved.day_offset_);
+  // arrival is unchanged, now relative to the new departure day
+  EXPECT_EQ(con.arrival_ - MINUTES_A_DAY, moved.arrival_);
+  for (auto day = 1; day < 16; ++day) {
+    EXPECT_EQ(con.traffic_days_->test(day - 1),
+              moved.traffic_days_->test(day));
+  }
+
+  // back to the schedule: scheduled day and traffic days again
+  publish_departure(con, station.c_str(), schedule_time, schedule_time);
+  check_timetable();
+  auto const& restored =
+      *tt().trip_to_connections_[con.trip_][con.trip_con_idx_];
+  EXPECT_EQ(con.departure_, restored.departure_);
+  EXPECT_EQ(con.arrival_, restored.arrival_);
+  EXPECT_EQ(con.day_offset_, restored.day_offset_);
+  EXPECT_EQ(con.traffic_days_, restored.traffic_days_);
+}
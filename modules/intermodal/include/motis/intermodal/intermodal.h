@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "motis/module/module.h"
@@ -7,6 +8,8 @@
 namespace motis {
 namespace intermodal {
 
+struct mumo_cache;
+
 struct intermodal : public motis::module::module {
 public:
   intermodal();
@@ -23,6 +26,9 @@ public:
 
 private:
   motis::module::msg_ptr route(motis::module::msg_ptr const&);
+
+  std::size_t mumo_cache_size_{1024};
+  std::unique_ptr<mumo_cache> mumo_cache_;
 };
 
 }  // namespace intermodal
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "geo/latlng.h"
+
+#include "motis/core/common/lru_cache.h"
+#include "motis/core/schedule/time.h"
+
+#include "motis/protocol/Message_generated.h"
+
+namespace motis {
+namespace intermodal {
+
+enum class mumo_type : int;
+
+// Stations reachable from a position with a single mode: (station id,
+// duration in minutes), as returned by /lookup/geo_station + /osrm.
+using mumo_targets = std::vector<std::pair<std::string, duration>>;
+
+using mumo_cache_key = std::tuple<int32_t /* lat */, int32_t /* lng */,
+                                  mumo_type, int /* max_dur */,
+                                  osrm::Direction>;
+
+// Mumo edge expansions keyed by quantised position (~10m grid), mode,
+// max. duration and OSRM direction. Repeated queries around popular
+// points are answered without calling lookup and OSRM.
+struct mumo_cache
+    : public lru_cache<mumo_cache_key, std::shared_ptr<mumo_targets const>> {
+  static constexpr auto kPrecision = 10000.0;  // 1e-4 degrees
+
+  using lru_cache::lru_cache;
+
+  static key make_key(geo::latlng const&, mumo_type, int max_dur,
+                      osrm::Direction);
+};
+
+}  // namespace intermodal
+}  // namespace motis
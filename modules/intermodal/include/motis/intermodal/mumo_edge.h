@@ -1,8 +1,17 @@
+#pragma once
+
+#include <functional>
+#include <memory>
 #include <vector>
 
+#include "ctx/ctx.h"
+
 #include "geo/latlng.h"
 
 #include "motis/core/schedule/time.h"
+#include "motis/module/ctx_data.h"
+
+#include "motis/intermodal/mumo_cache.h"
 
 #include "motis/protocol/Message_generated.h"
 
@@ -33,10 +42,26 @@ struct mumo_edge {
 using appender_fun =
     std::function<void(std::string const&, duration const, mumo_type const)>;
 
-void make_starts(IntermodalRoutingRequest const*, geo::latlng const&,
-                 appender_fun const&);
-void make_dests(IntermodalRoutingRequest const*, geo::latlng const&,
-                appender_fun const&);
+// Expansion of one mode, running concurrently as a ctx job.
+struct mumo_expansion {
+  struct result {
+    std::shared_ptr<mumo_targets const> targets_;
+    bool cache_hit_;
+  };
+
+  mumo_type type_;
+  ctx::future_ptr<module::ctx_data, result> result_;
+};
+
+std::vector<mumo_expansion> make_starts(IntermodalRoutingRequest const*,
+                                        geo::latlng const&, mumo_cache&);
+std::vector<mumo_expansion> make_dests(IntermodalRoutingRequest const*,
+                                       geo::latlng const&, mumo_cache&);
+
+// Waits for the expansions and passes their edges to the appender.
+// Returns the number of expansions answered from the cache.
+unsigned append_edges(std::vector<mumo_expansion> const&,
+                      appender_fun const&);
 
 void remove_intersection(std::vector<mumo_edge>& starts,
                          std::vector<mumo_edge> const& destinations,
@@ -5,8 +5,10 @@
 #include "utl/to_vec.h"
 
 #include "motis/core/common/constants.h"
+#include "motis/core/common/timing.h"
 #include "motis/core/journey/journeys_to_message.h"
 #include "motis/core/journey/message_to_journeys.h"
+#include "motis/core/statistics/statistics.h"
 #include "motis/module/context/motis_call.h"
 
 #include "motis/intermodal/error.h"
@@ -24,21 +26,32 @@ using namespace motis::routing;
 namespace motis {
 namespace intermodal {
 
-intermodal::intermodal() : module("Intermodal Options", "intermodal") {}
+intermodal::intermodal() : module("Intermodal Options", "intermodal") {
+  size_t_param(mumo_cache_size_, "mumo_cache_size",
+               "max. number of cached start/destination expansions (0=off)");
+}
 
 intermodal::~intermodal() = default;
 
 void intermodal::init(motis::module::registry& r) {
+  mumo_cache_ = std::make_unique<mumo_cache>(mumo_cache_size_);
   r.register_op("/intermodal", [this](msg_ptr const& m) { return route(m); });
 }
 
 msg_ptr postprocess_response(msg_ptr const& response_msg,
                              query_start const& q_start,
-                             query_dest const& q_dest, SearchDir const dir) {
+                             query_dest const& q_dest, SearchDir const dir,
+                             stats_category const& intermodal_stats) {
   auto routing_response = motis_content(RoutingResponse, response_msg);
   auto journeys = message_to_journeys(routing_response);
 
   message_creator mc;
+  auto stats = utl::to_vec(*routing_response->statistics(),
+                           [&mc](Statistics const* category) {
+                             return to_fbs(mc, from_fbs(category));
+                           });
+  stats.emplace_back(to_fbs(mc, intermodal_stats));
+
   for (auto& journey : journeys) {
     auto& stops = journey.stops_;
     if (stops.size() < 2) {
@@ -70,7 +83,7 @@ msg_ptr postprocess_response(msg_ptr const& response_msg,
   mc.create_and_finish(
       MsgContent_RoutingResponse,
       CreateRoutingResponse(
-          mc, routing_response->statistics(),
+          mc, mc.CreateVectorOfSortedTables(&stats),
           mc.CreateVector(utl::to_vec(
               journeys,
               [&mc](journey const& j) { return to_connection(mc, j); })),
@@ -95,34 +108,39 @@ msg_ptr intermodal::route(msg_ptr const& msg) {
   std::vector<mumo_edge> deps;
   std::vector<mumo_edge> arrs;
 
+  MOTIS_START_TIMING(mumo_edge_timing);
+
+  // start and destination expansions (all modes) run concurrently
+  auto const start_expansions =
+      start.is_intermodal_ ? make_starts(req, start.pos_, *mumo_cache_)
+                           : std::vector<mumo_expansion>{};
+  auto const dest_expansions =
+      dest.is_intermodal_ ? make_dests(req, dest.pos_, *mumo_cache_)
+                          : std::vector<mumo_expansion>{};
+
+  auto cache_hits = 0U;
   using namespace std::placeholders;
   if (req->search_dir() == SearchDir_Forward) {
-    if (start.is_intermodal_) {
-      make_starts(req, start.pos_,
-                  std::bind(appender, std::ref(deps),  //
-                            STATION_START, _1, _2, _3));
-    }
-    if (dest.is_intermodal_) {
-      make_dests(req, dest.pos_,
-                 std::bind(appender, std::ref(arrs),  //
-                           _1, STATION_END, _2, _3));
-    }
+    cache_hits += append_edges(start_expansions,
+                               std::bind(appender, std::ref(deps),  //
+                                         STATION_START, _1, _2, _3));
+    cache_hits += append_edges(dest_expansions,
+                               std::bind(appender, std::ref(arrs),  //
+                                         _1, STATION_END, _2, _3));
   } else {
-    if (start.is_intermodal_) {
-      make_starts(req, start.pos_,
-                  std::bind(appender, std::ref(deps),  //
-                            _1, STATION_START, _2, _3));
-    }
-    if (dest.is_intermodal_) {
-      make_dests(req, dest.pos_,
-                 std::bind(appender, std::ref(arrs),  //
-                           STATION_END, _1, _2, _3));
-    }
+    cache_hits += append_edges(start_expansions,
+                               std::bind(appender, std::ref(deps),  //
+                                         _1, STATION_START, _2, _3));
+    cache_hits += append_edges(dest_expansions,
+                               std::bind(appender, std::ref(arrs),  //
+                                         STATION_END, _1, _2, _3));
   }
 
   remove_intersection(deps, arrs, req->search_dir());
   auto edges = write_edges(mc, deps, arrs);
 
+  MOTIS_STOP_TIMING(mumo_edge_timing);
+
   mc.create_and_finish(
       MsgContent_RoutingRequest,
       CreateRoutingRequest(mc, start.start_type_, start.start_, dest.station_,
@@ -132,8 +150,20 @@ msg_ptr intermodal::route(msg_ptr const& msg) {
           .Union(),
       "/routing");
 
+  MOTIS_START_TIMING(routing_timing);
   auto resp = motis_call(make_msg(mc))->val();
-  return postprocess_response(resp, start, dest, req->search_dir());
+  MOTIS_STOP_TIMING(routing_timing);
+
+  auto const mumo_edge_ms = MOTIS_TIMING_MS(mumo_edge_timing);
+  auto const routing_ms = MOTIS_TIMING_MS(routing_timing);
+  return postprocess_response(
+      resp, start, dest, req->search_dir(),
+      stats_category{"intermodal",
+                     {stats_entry{"mumo_edge_duration",
+                                  static_cast<uint64_t>(mumo_edge_ms)},
+                      stats_entry{"routing_duration",
+                                  static_cast<uint64_t>(routing_ms)},
+                      stats_entry{"mumo_cache_hits", cache_hits}}});
 }
 
 }  // namespace intermodal
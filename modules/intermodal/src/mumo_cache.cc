@@ -0,0 +1,19 @@
+#include "motis/intermodal/mumo_cache.h"
+
+#include <cmath>
+
+#include "motis/intermodal/mumo_edge.h"
+
+namespace motis {
+namespace intermodal {
+
+mumo_cache::key mumo_cache::make_key(geo::latlng const& pos,
+                                     mumo_type const type, int const max_dur,
+                                     osrm::Direction const direction) {
+  return {static_cast<int32_t>(std::lround(pos.lat_ * kPrecision)),
+          static_cast<int32_t>(std::lround(pos.lng_ * kPrecision)), type,
+          max_dur, direction};
+}
+
+}  // namespace intermodal
+}  // namespace motis
@@ -6,6 +6,7 @@
 
 #include "motis/core/common/constants.h"
 #include "motis/module/context/motis_call.h"
+#include "motis/module/context/motis_spawn.h"
 #include "motis/module/message.h"
 
 #include "motis/intermodal/error.h"
@@ -49,9 +50,11 @@ msg_ptr make_osrm_request(latlng const& pos,
   return make_msg(mc);
 }
 
-void osrm_edges(latlng const& pos, int max_dur, int max_dist,
-                mumo_type const type, Direction direction,
-                appender_fun const& appender) {
+std::shared_ptr<mumo_targets const> osrm_edges(latlng const& pos,
+                                               int const max_dur,
+                                               int const max_dist,
+                                               mumo_type const type,
+                                               Direction const direction) {
   auto geo_msg = motis_call(make_geo_request(pos, max_dist))->val();
   auto geo_resp = motis_content(LookupGeoStationResponse, geo_msg);
   auto stations = geo_resp->stations();
@@ -61,26 +64,48 @@ void osrm_edges(latlng const& pos, int max_dur, int max_dist,
           ->val();
   auto osrm_resp = motis_content(OSRMOneToManyResponse, osrm_msg);
 
+  auto targets = std::make_shared<mumo_targets>();
   for (auto i = 0ul; i < stations->size(); ++i) {
     auto const dur = osrm_resp->costs()->Get(i)->duration();
     if (dur > max_dur) {
       continue;
     }
 
-    appender(stations->Get(i)->id()->str(), dur / 60, type);
+    targets->emplace_back(stations->Get(i)->id()->str(),
+                          static_cast<duration>(dur / 60));
   }
+  return targets;
 }
 
-void make_edges(Vector<Offset<ModeWrapper>> const* modes, latlng const& pos,
-                Direction const osrm_direction, appender_fun const& appender) {
+mumo_expansion expand(latlng const& pos, int const max_dur,
+                      int const max_dist, mumo_type const type,
+                      Direction const direction, mumo_cache& cache) {
+  return {type, spawn_job([=, &cache]() {
+            auto const key =
+                mumo_cache::make_key(pos, type, max_dur, direction);
+            if (auto cached = cache.get(key)) {
+              return mumo_expansion::result{std::move(*cached), true};
+            }
+
+            auto targets = osrm_edges(pos, max_dur, max_dist, type, direction);
+            cache.put(key, targets);
+            return mumo_expansion::result{std::move(targets), false};
+          })};
+}
+
+std::vector<mumo_expansion> make_edges(Vector<Offset<ModeWrapper>> const* modes,
+                                       latlng const& pos,
+                                       Direction const osrm_direction,
+                                       mumo_cache& cache) {
+  std::vector<mumo_expansion> expansions;
   for (auto const& wrapper : *modes) {
     switch (wrapper->mode_type()) {
       case Mode_Foot: {
         auto max_dur =
             reinterpret_cast<Foot const*>(wrapper->mode())->max_duration();
         auto max_dist = max_dur * WALK_SPEED;
-        osrm_edges(pos, max_dur, max_dist, mumo_type::FOOT, osrm_direction,
-                   appender);
+        expansions.emplace_back(expand(pos, max_dur, max_dist, mumo_type::FOOT,
+                                       osrm_direction, cache));
         break;
       }
 
@@ -88,8 +113,8 @@ void make_edges(Vector<Offset<ModeWrapper>> const* modes, latlng const& pos,
         auto max_dur =
             reinterpret_cast<Bike const*>(wrapper->mode())->max_duration();
         auto max_dist = max_dur * BIKE_SPEED;
-        osrm_edges(pos, max_dur, max_dist, mumo_type::BIKE, osrm_direction,
-                   appender);
+        expansions.emplace_back(expand(pos, max_dur, max_dist, mumo_type::BIKE,
+                                       osrm_direction, cache));
         break;
       }
 
@@ -97,24 +122,38 @@ void make_edges(Vector<Offset<ModeWrapper>> const* modes, latlng const& pos,
         auto max_dur =
             reinterpret_cast<Car const*>(wrapper->mode())->max_duration();
         auto max_dist = max_dur * CAR_SPEED;
-        osrm_edges(pos, max_dur, max_dist, mumo_type::CAR, osrm_direction,
-                   appender);
+        expansions.emplace_back(expand(pos, max_dur, max_dist, mumo_type::CAR,
+                                       osrm_direction, cache));
         break;
       }
 
       default: throw std::system_error(error::unknown_mode);
     }
   }
+  return expansions;
+}
+
+std::vector<mumo_expansion> make_starts(IntermodalRoutingRequest const* req,
+                                        latlng const& pos, mumo_cache& cache) {
+  return make_edges(req->start_modes(), pos, Direction_Forward, cache);
 }
 
-void make_starts(IntermodalRoutingRequest const* req, latlng const& pos,
-                 appender_fun const& appender) {
-  make_edges(req->start_modes(), pos, Direction_Forward, appender);
+std::vector<mumo_expansion> make_dests(IntermodalRoutingRequest const* req,
+                                       latlng const& pos, mumo_cache& cache) {
+  return make_edges(req->destination_modes(), pos, Direction_Backward, cache);
 }
 
-void make_dests(IntermodalRoutingRequest const* req, latlng const& pos,
-                appender_fun const& appender) {
-  make_edges(req->destination_modes(), pos, Direction_Backward, appender);
+unsigned append_edges(std::vector<mumo_expansion> const& expansions,
+                      appender_fun const& appender) {
+  auto cache_hits = 0U;
+  for (auto const& e : expansions) {
+    auto const result = e.result_->val();
+    for (auto const& [station_id, dur] : *result.targets_) {
+      appender(station_id, dur, e.type_);
+    }
+    cache_hits += result.cache_hit_ ? 1U : 0U;
+  }
+  return cache_hits;
 }
 
 void remove_intersection(std::vector<mumo_edge>& starts,
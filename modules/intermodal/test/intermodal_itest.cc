@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 
+#include <atomic>
 #include <string>
 
 #include "flatbuffers/flatbuffers.h"
@@ -30,7 +31,8 @@ struct intermodal_itest : public motis_instance_test {
   intermodal_itest()
       : motis::test::motis_instance_test(dataset_opt,
                                          {"intermodal", "routing", "lookup"}) {
-    instance_->register_op("/osrm/one_to_many", [](msg_ptr const& msg) {
+    instance_->register_op("/osrm/one_to_many", [this](msg_ptr const& msg) {
+      ++osrm_calls_;
       auto const req = motis_content(OSRMOneToManyRequest, msg);
       auto one = latlng{req->one()->lat(), req->one()->lng()};
 
@@ -48,6 +50,17 @@ struct intermodal_itest : public motis_instance_test {
       return make_msg(mc);
     });
   }
+
+  static uint64_t mumo_cache_hits(RoutingResponse const* res) {
+    auto const category = res->statistics()->LookupByKey("intermodal");
+    if (category == nullptr) {
+      return 0U;
+    }
+    auto const hits = category->entries()->LookupByKey("mumo_cache_hits");
+    return hits == nullptr ? 0U : hits->value();
+  }
+
+  std::atomic<unsigned> osrm_calls_{0U};
 };
 
 TEST_F(intermodal_itest, forward) {
@@ -127,6 +140,66 @@ TEST_F(intermodal_itest, forward) {
                    ->c_str());
 }
 
+TEST_F(intermodal_itest, cached_expansion) {
+  //  Heidelberg Hbf -> Bensheim ( departure: 2015-11-24 13:30:00 )
+  auto const json = R"(
+    {
+      "destination": {
+        "type": "Module",
+        "target": "/intermodal"
+      },
+      "content_type": "IntermodalRoutingRequest",
+      "content": {
+        "start_type": "IntermodalOntripStart",
+        "start": {
+          "position": { "lat": 49.4047178, "lng": 8.6768716},
+          "departure_time": 1448368200
+        },
+        "start_modes": [{
+          "mode_type": "Foot",
+          "mode": { "max_duration": 600 }
+        }],
+        "destination_type": "InputPosition",
+        "destination": { "lat": 49.6801332, "lng": 8.6200666},
+        "destination_modes":  [{
+          "mode_type": "Foot",
+          "mode": { "max_duration": 600 }
+        },{
+          "mode_type": "Bike",
+          "mode": { "max_duration": 600 }
+        }],
+        "search_type": "SingleCriterion"
+      }
+    }
+  )";
+
+  auto const first_msg = call(make_msg(json));
+  auto const first = motis_content(RoutingResponse, first_msg);
+  EXPECT_EQ(0U, mumo_cache_hits(first));
+  auto const osrm_calls = osrm_calls_.load();
+  ASSERT_NE(0U, osrm_calls);
+
+  // All three expansions (start: foot, destination: foot, bike) are cached.
+  auto const second_msg = call(make_msg(json));
+  auto const second = motis_content(RoutingResponse, second_msg);
+  EXPECT_EQ(3U, mumo_cache_hits(second));
+  EXPECT_EQ(osrm_calls, osrm_calls_.load());
+
+  ASSERT_EQ(1, first->connections()->size());
+  ASSERT_EQ(1, second->connections()->size());
+  auto const& first_stops = first->connections()->Get(0)->stops();
+  auto const& second_stops = second->connections()->Get(0)->stops();
+  ASSERT_EQ(first_stops->size(), second_stops->size());
+  for (auto i = 0U; i < first_stops->size(); ++i) {
+    EXPECT_STREQ(first_stops->Get(i)->station()->id()->c_str(),
+                 second_stops->Get(i)->station()->id()->c_str());
+    EXPECT_EQ(first_stops->Get(i)->arrival()->time(),
+              second_stops->Get(i)->arrival()->time());
+    EXPECT_EQ(first_stops->Get(i)->departure()->time(),
+              second_stops->Get(i)->departure()->time());
+  }
+}
+
 TEST_F(intermodal_itest, backward) {
   //  Heidelberg Hbf -> Bensheim ( arrival: 2015-11-24 14:30:00 )
   auto json = R"(
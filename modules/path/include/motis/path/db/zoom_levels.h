@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace motis {
+namespace path {
+
+constexpr auto kMaxZoomLevel = 20;
+
+// Key of the polylines of sequence `index` pre-simplified for `zoom_level`.
+inline std::string zoom_level_key(std::string const& index,
+                                  int const zoom_level) {
+  return index + "@" + std::to_string(zoom_level);
+}
+
+// Douglas-Peucker simplification of a flat (lat, lng, lat, lng, ...)
+// polyline with the tolerance OSRM uses for the given zoom level.
+std::vector<double> simplify(std::vector<double> const& flat_polyline,
+                             int zoom_level);
+
+}  // namespace path
+}  // namespace motis
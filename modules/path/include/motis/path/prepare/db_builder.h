@@ -48,7 +48,9 @@ struct sequence_info {
 };
 
 struct db_builder {
-  explicit db_builder(std::unique_ptr<kv_database> db) : db_(std::move(db)) {
+  explicit db_builder(std::unique_ptr<kv_database> db,
+                      std::vector<int> zoom_levels = {})
+      : zoom_levels_(std::move(zoom_levels)), db_(std::move(db)) {
     boxes_.set_empty_key({"", ""});
   }
 
@@ -63,9 +65,16 @@ private:
   void finish_index();
   void finish_boxes();
 
+  void append_zoom_levels(std::vector<std::string> const& station_ids,
+                          std::vector<uint32_t> const& classes,
+                          std::vector<std::vector<double>> const& lines);
+
 public:
   int index_ = 0;
 
+  // polylines are additionally stored pre-simplified for these zoom levels
+  std::vector<int> zoom_levels_;
+
   std::vector<key_pair> indices_;
 
   hash_map<std::pair<std::string, std::string>,
@@ -0,0 +1,34 @@
+#include "motis/path/db/zoom_levels.h"
+
+#include "geo/polyline.h"
+
+#include "utl/to_vec.h"
+
+#include "util/coordinate.hpp"  // osrm
+
+#include "engine/douglas_peucker.hpp"  // osrm
+
+using namespace osrm::util;
+using namespace osrm::engine;
+
+namespace motis {
+namespace path {
+
+std::vector<double> simplify(std::vector<double> const& flat_polyline,
+                             int const zoom_level) {
+  auto const osrm_coords = utl::to_vec(
+      geo::deserialize(flat_polyline), [](auto const& pos) -> Coordinate {
+        return FloatCoordinate{FloatLongitude{pos.lng_},
+                               FloatLatitude{pos.lat_}};
+      });
+
+  return geo::serialize(utl::to_vec(
+      douglasPeucker(osrm_coords, zoom_level), [](auto const& coord) {
+        auto const float_coord = FloatCoordinate{coord};
+        return geo::latlng{static_cast<double>(float_coord.lat),
+                           static_cast<double>(float_coord.lon)};
+      }));
+}
+
+}  // namespace path
+}  // namespace motis
@@ -6,8 +6,6 @@
 
 #include "conf/simple_config_param.h"
 
-#include "geo/polyline.h"
-
 #include "utl/to_vec.h"
 
 #include "motis/core/common/logging.h"
@@ -19,6 +17,7 @@
 
 #include "motis/path/constants.h"
 #include "motis/path/db/kv_database.h"
+#include "motis/path/db/zoom_levels.h"
 #include "motis/path/lookup_index.h"
 
 using namespace flatbuffers;
@@ -27,27 +26,6 @@ using namespace motis::osrm;
 using namespace motis::access;
 using namespace motis::logging;
 
-// --
-
-#include "util/coordinate.hpp"  // osrm
-#include "util/json_container.hpp"  // osrm
-#include "util/json_util.hpp"  // osrm
-
-#include "engine/douglas_peucker.hpp"  // osrm
-
-using namespace osrm::util;
-using namespace osrm::engine;
-
-FloatCoordinate make_coord(geo::latlng const& pos) {
-  return FloatCoordinate{FloatLongitude{pos.lng_}, FloatLatitude{pos.lat_}};
-}
-
-geo::latlng make_latlng(FloatCoordinate const& coord) {
-  return {static_cast<double>(coord.lat), static_cast<double>(coord.lon)};
-}
-
-// --
-
 namespace motis {
 namespace path {
 
@@ -108,6 +86,13 @@ msg_ptr path::id_train_path(msg_ptr const& msg) const {
 
 msg_ptr path::get_response(std::string const& index, int const zoom_level,
                            bool const debug_info) const {
+  if (zoom_level != -1) {
+    // written by db_builder for the configured zoom levels: ready to send
+    if (auto const buf = db_->try_get(zoom_level_key(index, zoom_level))) {
+      return make_msg(buf->data(), buf->size());
+    }
+  }
+
   auto buf = db_->get(index);
   auto original_msg = std::make_shared<message>(buf.size(), buf.c_str());
   auto original = motis_content(PathSeqResponse, original_msg);
@@ -131,25 +116,13 @@ msg_ptr path::get_response(std::string const& index, int const zoom_level,
   };
 
   auto const simplify = [&mc, &original, &zoom_level] {
-    verify(zoom_level <= 20 && zoom_level > -1, "invalid zoom level");
+    verify(zoom_level <= kMaxZoomLevel && zoom_level > -1,
+           "invalid zoom level");
     return utl::to_vec(
         *original->segments(), [&mc, &zoom_level](auto const& segment) {
-          auto const original_polyline =
-              geo::deserialize(utl::to_vec(*segment->coordinates()));
-
-          auto const osrm_coords = utl::to_vec(
-              original_polyline,
-              [](auto const& c) -> Coordinate { return make_coord(c); });
-
-          auto const simplified_osrm_coords =
-              douglasPeucker(osrm_coords, zoom_level);
-
-          auto const simplified_polyline = utl::to_vec(
-              simplified_osrm_coords,
-              [](auto const& osrm_coord) { return make_latlng(osrm_coord); });
-
           return CreatePolyline(
-              mc, mc.CreateVector(geo::serialize(simplified_polyline)));
+              mc, mc.CreateVector(path::simplify(
+                      utl::to_vec(*segment->coordinates()), zoom_level)));
         });
   };
 
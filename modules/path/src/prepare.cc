@@ -14,6 +14,7 @@
 #include "parser/file.h"
 
 #include "utl/erase_if.h"
+#include "utl/to_vec.h"
 
 #include "motis/core/common/logging.h"
 
@@ -41,7 +42,9 @@ struct prepare_settings : public conf::simple_config {
                             std::string const& out = "pathdb",
                             std::vector<std::string> const& filter = {},
                             std::string const& stats = "off",
-                            std::vector<std::string> const& check = {})
+                            std::vector<std::string> const& check = {},
+                            std::vector<std::string> const& zoom_levels = {
+                                "6", "8", "10", "12", "14"})
       : simple_config("Prepare Options", "") {
     string_param(schedule_, schedule, "schedule", "/path/to/rohdaten");
     string_param(osm_, osm, "osm", "/path/to/germany-latest.osm.pbf");
@@ -53,6 +56,9 @@ struct prepare_settings : public conf::simple_config {
                  "the state of 'out' (only, combined, off)");
 
     multitoken_param(check_, check, "check", "check two results are equal");
+
+    multitoken_param(zoom_levels_, zoom_levels, "zoom_levels",
+                     "store polylines pre-simplified for these zoom levels");
   }
 
   std::string schedule_;
@@ -64,6 +70,8 @@ struct prepare_settings : public conf::simple_config {
 
   std::string stats_;
   std::vector<std::string> check_;
+
+  std::vector<std::string> zoom_levels_;
 };
 
 void filter_sequences(std::vector<std::string> const& filters,
@@ -156,7 +164,10 @@ int main(int argc, char** argv) {
     LOG(motis::logging::info) << "station sequences: " << sequences.size();
 
     auto routing = make_path_routing(stations, opt.osm_, opt.osrm_);
-    db_builder builder(std::make_unique<lmdb_database>(opt.out_));
+    db_builder builder(std::make_unique<lmdb_database>(opt.out_),
+                       utl::to_vec(opt.zoom_levels_, [](auto const& z) {
+                         return std::stoi(z);
+                       }));
 
     // CALLGRIND_START_INSTRUMENTATION;
     resolve_sequences(sequences, routing, builder);
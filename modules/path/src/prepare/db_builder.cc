@@ -6,6 +6,7 @@
 #include "parser/util.h"
 
 #include "motis/path/constants.h"
+#include "motis/path/db/zoom_levels.h"
 
 using namespace flatbuffers;
 using namespace motis::module;
@@ -46,15 +47,18 @@ void db_builder::append(std::vector<std::string> const& station_ids,
   auto const fbs_stations = utl::to_vec(
       station_ids, [&](auto const& id) { return b.CreateString(id); });
 
-  std::vector<Offset<Polyline>> fbs_lines;
-  for (auto const& line : lines) {
+  auto const flat_lines = utl::to_vec(lines, [](auto const& line) {
     std::vector<double> flat_polyline;
     for (auto const& latlng : line) {
       flat_polyline.push_back(latlng.lat_);
       flat_polyline.push_back(latlng.lng_);
     }
-    fbs_lines.push_back(CreatePolyline(b, b.CreateVector(flat_polyline)));
-  }
+    return flat_polyline;
+  });
+
+  auto const fbs_lines = utl::to_vec(flat_lines, [&](auto const& line) {
+    return CreatePolyline(b, b.CreateVector(line));
+  });
 
   b.create_and_finish(
       MsgContent_PathSeqResponse,
@@ -70,10 +74,40 @@ void db_builder::append(std::vector<std::string> const& station_ids,
           .Union());
 
   db_->put(std::to_string(index_), routing_sequence(std::move(b)).to_string());
+  append_zoom_levels(station_ids, classes, flat_lines);
   indices_.emplace_back(station_ids, classes, index_);
   ++index_;
 }
 
+void db_builder::append_zoom_levels(
+    std::vector<std::string> const& station_ids,
+    std::vector<uint32_t> const& classes,
+    std::vector<std::vector<double>> const& lines) {
+  for (auto const zoom_level : zoom_levels_) {
+    verify(zoom_level <= kMaxZoomLevel && zoom_level > -1,
+           "db_builder: invalid zoom level");
+
+    // same layout as the simplified responses of path::get_response
+    message_creator mc;
+    auto const fbs_stations = utl::to_vec(
+        station_ids, [&](auto const& id) { return mc.CreateString(id); });
+    auto const fbs_lines = utl::to_vec(lines, [&](auto const& line) {
+      return CreatePolyline(mc, mc.CreateVector(simplify(line, zoom_level)));
+    });
+
+    mc.create_and_finish(
+        MsgContent_PathSeqResponse,
+        CreatePathSeqResponse(mc, mc.CreateVector(fbs_stations),
+                              mc.CreateVector(classes),
+                              mc.CreateVector(fbs_lines),
+                              mc.CreateVector(
+                                  std::vector<Offset<PathSourceInfo>>{}))
+            .Union());
+    db_->put(zoom_level_key(std::to_string(index_), zoom_level),
+             make_msg(mc)->to_string());
+  }
+}
+
 void db_builder::finish() {
   finish_index();
   finish_boxes();
@@ -33,6 +33,8 @@ struct train_retriever {
                              geo::box const& area);
 
 private:
+  // Days a connection may arrive after its departure day (+1 for delays).
+  int max_day_offset_;
   std::vector<std::unique_ptr<edge_geo_index>> edge_index_;
 };
 
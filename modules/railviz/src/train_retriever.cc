@@ -1,5 +1,8 @@
 #include "motis/railviz/train_retriever.h"
 
+#include <algorithm>
+#include <iterator>
+
 #include "motis/core/schedule/schedule.h"
 
 #include "motis/railviz/edge_geo_index.h"
@@ -9,8 +12,68 @@ namespace railviz {
 
 constexpr auto const RELEVANT_CLASSES = NUM_CLASSES - 1;
 
+namespace {
+
+int max_arrival_day_offset(schedule const& s) {
+  auto max_arrival = 0;
+  for (auto const& station_node : s.station_nodes_) {
+    for (auto const& route_node : station_node->get_route_nodes()) {
+      for (auto const& e : route_node->edges_) {
+        if (!e.empty()) {
+          max_arrival = std::max(
+              max_arrival, static_cast<int>(
+                               e.m_.route_edge_.conns_.back().a_time_));
+        }
+      }
+    }
+  }
+  return max_arrival / MINUTES_A_DAY;
+}
+
+// Adds the connections of the edge that run in [from, to] on a day in
+// [first_day, to.day()]. Light connections are sorted by departure and by
+// arrival time. The candidates of a day are the ones with arrival >= from
+// and departure <= to, i.e. one range found by binary search.
+// Realtime updates keep this order: an event that would overtake its
+// neighbour on the route edge (rt fits_edge) moves its trip to separate
+// route edges, and rt_handler::flush verifies the order of every touched
+// route edge (tested in railviz/test/lcon_order_itest.cc).
+// Returns true if max_count connections have been collected.
+bool collect_trains(edge const* e, time const from, time const to,
+                    int const first_day, unsigned const max_count,
+                    std::vector<ev_key>& connections) {
+  auto const& conns = e->m_.route_edge_.conns_;
+  for (auto day = std::max(0, first_day); day <= to.day(); ++day) {
+    auto const day_offset = day * MINUTES_A_DAY;
+    auto const from_mam = from.ts() - day_offset;
+    auto const to_mam = to.ts() - day_offset;
+    auto const first = std::lower_bound(
+        begin(conns), end(conns), from_mam,
+        [](light_connection const& c, int const t) { return c.a_time_ < t; });
+    auto const last = std::upper_bound(
+        first, end(conns), to_mam,
+        [](int const t, light_connection const& c) { return t < c.d_time_; });
+    for (auto it = first; it != last; ++it) {
+      if (it->valid_ == 0U || !it->traffic_days_->test(day)) {
+        continue;
+      }
+      connections.emplace_back(
+          ev_key{e,
+                 static_cast<std::size_t>(std::distance(begin(conns), it)),
+                 day, event_type::DEP});
+      if (connections.size() >= max_count) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
 train_retriever::train_retriever(
-    schedule const& s, hash_map<std::pair<int, int>, geo::box> const& boxes) {
+    schedule const& s, hash_map<std::pair<int, int>, geo::box> const& boxes)
+    : max_day_offset_(max_arrival_day_offset(s) + 1) {
   edge_index_.resize(RELEVANT_CLASSES);
   for (auto clasz = 0u; clasz < RELEVANT_CLASSES; ++clasz) {
     edge_index_[clasz] = std::make_unique<edge_geo_index>(clasz, s, boxes);
@@ -23,20 +86,17 @@ std::vector<ev_key> train_retriever::trains(time const from, time const to,
                                             unsigned const max_count,
                                             geo::box const& area) {
   std::vector<ev_key> connections;
+  if (max_count == 0U) {
+    return connections;
+  }
+  auto const first_day = from.day() - max_day_offset_;
   for (auto clasz = 0u; clasz < RELEVANT_CLASSES; ++clasz) {
     for (auto const& e : edge_index_[clasz]->edges(area)) {
-      for (auto i = 0u; i < e->m_.route_edge_.conns_.size(); ++i) {
-        auto const& con = e->m_.route_edge_.conns_[i];
-        if (con.a_time_ >= from && con.d_time_ <= to && (con.valid_ != 0u)) {
-          connections.emplace_back(ev_key{e, i, event_type::DEP});
-          if (connections.size() >= max_count) {
-            goto end;
-          }
-        }
+      if (collect_trains(e, from, to, first_day, max_count, connections)) {
+        return connections;
       }
     }
   }
-end:
   return connections;
 }
 
@@ -0,0 +1,70 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+#include "motis/core/schedule/schedule.h"
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/schedule/invalid_realtime.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace motis;
+using namespace motis::test;
+using namespace motis::test::schedule;
+
+namespace {
+
+// train_retriever binary searches the light connections of a route edge
+// by departure and by arrival: both orders have to survive rt updates.
+void expect_lcons_sorted(schedule const& sched) {
+  auto route_edges = 0U;
+  for (auto const& station_node : sched.station_nodes_) {
+    for (auto const& route_node : station_node->get_route_nodes()) {
+      for (auto const& e : route_node->edges_) {
+        if (e.empty()) {
+          continue;
+        }
+        ++route_edges;
+        auto const& conns = e.m_.route_edge_.conns_;
+        EXPECT_TRUE(std::is_sorted(
+            begin(conns), end(conns),
+            [](light_connection const& a, light_connection const& b) {
+              return a.d_time_ < b.d_time_;
+            }));
+        EXPECT_TRUE(std::is_sorted(
+            begin(conns), end(conns),
+            [](light_connection const& a, light_connection const& b) {
+              return a.a_time_ < b.a_time_;
+            }));
+      }
+    }
+  }
+  EXPECT_NE(0U, route_edges);
+}
+
+}  // namespace
+
+struct railviz_lcon_order_delay_test : public motis_instance_test {
+  railviz_lcon_order_delay_test()
+      : motis::test::motis_instance_test(
+            simple_realtime::dataset_opt, {"ris", "rt"},
+            {"--ris.input=test/schedule/simple_realtime/risml/delays.xml",
+             "--ris.init_time=2015-11-24T11:00:00"}) {}
+};
+
+TEST_F(railviz_lcon_order_delay_test, sorted_after_delays) {
+  expect_lcons_sorted(sched());
+}
+
+// Trip 381 is delayed past trip 382 on a shared route edge.
+struct railviz_lcon_order_overtake_test : public motis_instance_test {
+  railviz_lcon_order_overtake_test()
+      : motis::test::motis_instance_test(
+            invalid_realtime::dataset_opt, {"ris", "rt"},
+            {"--ris.input=test/schedule/invalid_realtime/risml/"
+             "trip_conflict.xml",
+             "--ris.init_time=2015-11-24T11:00:00"}) {}
+};
+
+TEST_F(railviz_lcon_order_overtake_test, sorted_after_overtaking) {
+  expect_lcons_sorted(sched());
+}
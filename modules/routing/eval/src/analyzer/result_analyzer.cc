@@ -1,5 +1,10 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "motis/module/message.h"
@@ -12,45 +17,118 @@ using namespace motis::module;
 using namespace motis::routing;
 using namespace motis::eval;
 
+uint64_t routing_stat(RoutingResponse const* r, char const* name) {
+  auto const category = r->statistics()->LookupByKey("routing");
+  if (category == nullptr) {
+    return 0U;
+  }
+  auto const entry = category->entries()->LookupByKey(name);
+  return entry == nullptr ? 0U : entry->value();
+}
+
 struct response {
   explicit response(RoutingResponse const* r)
       : labels_until_first_(
-            r->statistics()->labels_popped_until_first_result()),
-        labels_after_last_(r->statistics()->labels_popped_after_last_result()),
-        labels_created_(r->statistics()->labels_created()),
-        pd_time_(r->statistics()->pareto_dijkstra()),
-        start_labels_(r->statistics()->start_label_count()),
+            routing_stat(r, "labels_popped_until_first_result")),
+        labels_after_last_(routing_stat(r, "labels_popped_after_last_result")),
+        labels_created_(routing_stat(r, "labels_created")),
+        pd_time_(routing_stat(r, "pareto_dijkstra")),
+        start_labels_(routing_stat(r, "start_label_count")),
         con_count_(r->connections()->size()),
-        max_label_quit_(r->statistics()->max_label_quit()),
-        total_time_(r->statistics()->total_calculation_time()),
-        travel_time_lb_time_(r->statistics()->travel_time_lb()),
-        transfers_lb_time_(r->statistics()->transfers_lb()),
-        num_bytes_in_use_(r->statistics()->num_bytes_in_use()) {}
-
-  unsigned labels_until_first_;
-  unsigned labels_after_last_;
-  unsigned labels_created_;
-  unsigned pd_time_;
-  unsigned start_labels_;
+        max_label_quit_(routing_stat(r, "max_label_quit") != 0U),
+        total_time_(routing_stat(r, "total_calculation_time")),
+        travel_time_lb_time_(routing_stat(r, "travel_time_lb")),
+        transfers_lb_time_(routing_stat(r, "transfers_lb")),
+        num_bytes_in_use_(routing_stat(r, "num_bytes_in_use")) {}
+
+  uint64_t labels_until_first_;
+  uint64_t labels_after_last_;
+  uint64_t labels_created_;
+  uint64_t pd_time_;
+  uint64_t start_labels_;
   unsigned con_count_;
   bool max_label_quit_;
-  unsigned total_time_;
-  unsigned travel_time_lb_time_;
-  unsigned transfers_lb_time_;
-  size_t num_bytes_in_use_;
+  uint64_t total_time_;
+  uint64_t travel_time_lb_time_;
+  uint64_t transfers_lb_time_;
+  uint64_t num_bytes_in_use_;
 };
 
+// Reads the batch mode output: one compact JSON response per line or
+// (binary) uint32 little endian size prefixed flatbuffers.
+void read_responses(std::string const& path, bool const binary,
+                    std::function<void(msg_ptr const&)> const& fn) {
+  std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+  if (binary) {
+    std::vector<char> buf;
+    unsigned char size_buf[4];
+    while (in.read(reinterpret_cast<char*>(size_buf), sizeof(size_buf))) {
+      auto const size = static_cast<uint32_t>(size_buf[0]) |
+                        (static_cast<uint32_t>(size_buf[1]) << 8U) |
+                        (static_cast<uint32_t>(size_buf[2]) << 16U) |
+                        (static_cast<uint32_t>(size_buf[3]) << 24U);
+      buf.resize(size);
+      if (!in.read(buf.data(), size)) {
+        break;
+      }
+      fn(make_msg(buf.data(), buf.size()));
+    }
+  } else {
+    std::string line;
+    while (std::getline(in, line)) {
+      if (!line.empty()) {
+        fn(make_msg(line));
+      }
+    }
+  }
+}
+
+// Summary of the batch mode latency CSV (id,target,ms).
+void print_latencies(std::string const& path) {
+  std::ifstream in(path);
+  std::vector<double> latencies;
+  std::string line;
+  std::getline(in, line);  // header
+  while (std::getline(in, line)) {
+    auto const sep = line.rfind(',');
+    if (sep != std::string::npos) {
+      latencies.push_back(std::stod(line.substr(sep + 1)));
+    }
+  }
+  if (latencies.empty()) {
+    std::cout << "no latencies found\n";
+    return;
+  }
+
+  std::sort(begin(latencies), end(latencies));
+  auto const percentile = [&](double const q) {
+    auto const idx = static_cast<std::size_t>(q * latencies.size());
+    return latencies[std::min(idx, latencies.size() - 1)];
+  };
+  auto sum = 0.0;
+  for (auto const ms : latencies) {
+    sum += ms;
+  }
+  std::cout << "    average latency [ms]: " << sum / latencies.size() << "\n"
+            << "99 quantile latency [ms]: " << percentile(0.99) << "\n"
+            << "90 quantile latency [ms]: " << percentile(0.9) << "\n"
+            << "50 quantile latency [ms]: " << percentile(0.5) << "\n"
+            << "        max latency [ms]: " << latencies.back() << "\n\n";
+}
+
 int main(int argc, char* argv[]) {
-  if (argc != 2) {
-    std::cout << "usage: " << argv[0] << " {results.txt file}\n";
+  if (argc < 2 || argc > 4) {
+    std::cout << "usage: " << argv[0]
+              << " {batch output file} [json|binary] [latency csv file]\n";
     return 0;
   }
+  auto const binary = argc >= 3 && std::strcmp(argv[2], "binary") == 0;
+  if (argc == 4) {
+    print_latencies(argv[3]);
+  }
 
   std::vector<response> responses;
 
-  std::ifstream in(argv[1]);
-  std::string line;
-
   uint64_t max_label_quit = 0;
   uint64_t pd_time_sum = 0;
   uint64_t total_time_sum = 0;
@@ -63,11 +141,13 @@ int main(int argc, char* argv[]) {
   uint64_t no_labels_created = 0;
   uint64_t start_labels = 0;
   uint64_t num_bytes_in_use = 0;
+  uint64_t errors = 0;
 
-  while (in.peek() != EOF && !in.eof()) {
-    std::getline(in, line);
-
-    auto res_msg = make_msg(line);
+  read_responses(argv[1], binary, [&](msg_ptr const& res_msg) {
+    if (res_msg->get()->content_type() != MsgContent_RoutingResponse) {
+      ++errors;
+      return;
+    }
     response res(motis_content(RoutingResponse, res_msg));
 
     if (res.max_label_quit_) {
@@ -76,7 +156,7 @@ int main(int argc, char* argv[]) {
 
     if (res.con_count_ == 0) {
       ++no_con_count;
-      continue;
+      return;
     }
 
     responses.push_back(res);
@@ -90,7 +170,7 @@ int main(int argc, char* argv[]) {
     start_labels += res.start_labels_;
     num_bytes_in_use += res.num_bytes_in_use_;
     ++count;
-  }
+  });
 
   if (responses.empty()) {
     std::cout << "no responses found\n";
@@ -100,6 +180,7 @@ int main(int argc, char* argv[]) {
 
   std::cout << "   total count: " << count << "\n"
             << "       no conn: " << no_con_count << "\n"
+            << "        errors: " << errors << "\n"
             << "max label quit: " << max_label_quit << "\n"
             << "\n\n";
 
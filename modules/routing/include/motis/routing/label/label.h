@@ -1,6 +1,7 @@
 #pragma once
 
 #include "motis/core/schedule/edges.h"
+#include "motis/routing/label/node_labels.h"
 #include "motis/routing/lower_bounds.h"
 
 namespace motis {
@@ -15,6 +16,8 @@ template <search_dir Dir, std::size_t MaxBucket, typename GetBucket,
 struct label : public Data {  // NOLINT
   enum : std::size_t { MAX_BUCKET = MaxBucket };
 
+  using node_labels = vector_node_labels::store<label>;
+
   label() = default;  // NOLINT
 
   label(edge const* e, label* pred, time now, lower_bounds& lb)
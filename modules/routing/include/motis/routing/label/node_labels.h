@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "motis/routing/mem_manager.h"
+
+namespace motis {
+namespace routing {
+
+// Node label store: one vector of label pointers per node.
+// add() inserts a label unless it is dominated by a label already stored
+// at the node. Labels dominated by the new label are removed and marked.
+struct vector_node_labels {
+  template <typename Label>
+  struct store {
+    store(mem_manager& mem, std::size_t const node_count)
+        : mem_(mem), labels_(*mem.get_node_labels<Label>(node_count)) {}
+
+    void add_start_label(Label* l) {
+      auto const id = l->get_node()->id_;
+      mem_.touch_node(id);
+      labels_[id].emplace_back(l);
+    }
+
+    bool add(Label* new_label, uint32_t const id) {
+      auto& dest_labels = labels_[id];
+      for (auto it = dest_labels.begin(); it != dest_labels.end();) {
+        Label* o = *it;
+        if (o->dominates(*new_label)) {
+          return false;
+        }
+
+        if (new_label->dominates(*o)) {
+          it = dest_labels.erase(it);
+          o->dominated_ = true;
+        } else {
+          ++it;
+        }
+      }
+
+      // it is very important for the performance to push front here
+      // because earlier labels tend not to dominate later ones (not
+      // comparable)
+      mem_.touch_node(id);
+      dest_labels.insert(std::begin(dest_labels), new_label);
+      return true;
+    }
+
+    mem_manager& mem_;
+    std::vector<std::vector<Label*>>& labels_;
+  };
+};
+
+}  // namespace routing
+}  // namespace motis
@@ -6,6 +6,8 @@
 #include "motis/core/schedule/constant_graph.h"
 #include "motis/core/schedule/schedule.h"
 
+#include "motis/routing/lower_bounds_cache.h"
+
 #include "motis/routing/label/criteria/transfers.h"
 #include "motis/routing/label/criteria/travel_time.h"
 
@@ -25,6 +27,21 @@ struct lower_bounds {
         transfers_(transfers_graph, goal, additional_transfers_edges,
                    map_interchange_graph_node(sched.station_nodes_.size())) {}
 
+  // Reuses distances cached by an earlier query with the same goal.
+  lower_bounds(
+      schedule const& sched,  //
+      constant_graph const& travel_time_graph,
+      constant_graph const& transfers_graph,  //
+      lower_bounds_cache_entry const& cached,
+      hash_map<int, std::vector<simple_edge>> const&
+          additional_travel_time_edges,
+      hash_map<int, std::vector<simple_edge>> const& additional_transfers_edges)
+      : travel_time_(travel_time_graph, cached.travel_time_,
+                     additional_travel_time_edges),
+        transfers_(transfers_graph, cached.transfers_,
+                   additional_transfers_edges,
+                   map_interchange_graph_node(sched.station_nodes_.size())) {}
+
   constant_graph_dijkstra<MAX_TRAVEL_TIME, map_station_graph_node> travel_time_;
   constant_graph_dijkstra<MAX_TRANSFERS, map_interchange_graph_node> transfers_;
 };
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "motis/core/common/lru_cache.h"
+#include "motis/core/schedule/edges.h"
+
+namespace motis {
+namespace routing {
+
+struct lower_bounds_cache_entry {
+  std::shared_ptr<std::vector<uint32_t> const> travel_time_, transfers_;
+};
+
+// Destination specific lower bound distances (travel time and transfers),
+// keyed by goal station, search direction and lower bound graph version.
+// Entries of outdated graph versions are never hit again and age out.
+using lower_bounds_cache =
+    lru_cache<std::tuple<uint32_t /* goal */, search_dir, uint64_t>,
+              lower_bounds_cache_entry>;
+
+}  // namespace routing
+}  // namespace motis
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
 #include <cstdlib>
 #include <memory>
+#include <vector>
 
 #include "motis/routing/allocator.h"
 
@@ -22,11 +24,21 @@ public:
 
   ~mem_manager() = default;
 
+  // Only clears the label lists of nodes touched since the last reset.
   void reset() {
     allocations_ = 0;
     alloc_.clear();
-    for (auto& labels : node_labels_) {
-      labels.clear();
+    for (auto const id : touched_nodes_) {
+      node_labels_[id].clear();
+      node_touched_[id] = false;
+    }
+    touched_nodes_.clear();
+  }
+
+  inline void touch_node(uint32_t const id) {
+    if (!node_touched_[id]) {
+      node_touched_[id] = true;
+      touched_nodes_.emplace_back(id);
     }
   }
 
@@ -45,6 +57,7 @@ public:
   template <typename T>
   std::vector<std::vector<T*>>* get_node_labels(std::size_t size) {
     node_labels_.resize(size);
+    node_touched_.resize(size, false);
     return reinterpret_cast<std::vector<std::vector<T*>>*>(&node_labels_);
   }
 
@@ -52,10 +65,14 @@ public:
 
   size_t get_num_bytes_in_use() const { return alloc_.get_num_bytes_in_use(); }
 
+  size_t touched_nodes() const { return touched_nodes_.size(); }
+
 private:
   size_t allocations_;
   allocator alloc_;
   std::vector<std::vector<void*>> node_labels_;
+  std::vector<bool> node_touched_;
+  std::vector<uint32_t> touched_nodes_;
 };
 
 }  // namespace routing
@@ -1,7 +1,11 @@
 #pragma once
 
-#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 #include "motis/routing/mem_manager.h"
@@ -10,16 +14,35 @@ namespace motis {
 namespace routing {
 
 struct memory {
-  explicit memory(std::size_t bytes) : in_use_(false), mem_(bytes) {}
-  bool in_use_;
+  explicit memory(std::size_t bytes) : mem_(bytes) {}
   mem_manager mem_;
 };
 
+// Free lists of label stores, sharded by thread to avoid a global lock.
+// A thread takes from (and returns to) its own shard first and only falls
+// back to the other shards if its own one is empty.
+struct mem_pool {
+  static constexpr auto SHARD_COUNT = 16U;
+
+  explicit mem_pool(std::size_t const bytes) : bytes_(bytes) {}
+
+  struct shard {
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<memory>> free_;
+  };
+
+  static std::size_t home_shard() {
+    return std::hash<std::thread::id>{}(std::this_thread::get_id()) %
+           SHARD_COUNT;
+  }
+
+  std::size_t bytes_;  // initial size of new label stores
+  std::array<shard, SHARD_COUNT> shards_;
+  std::atomic<std::size_t> size_{0U}, hits_{0U}, misses_{0U};
+};
+
 struct mem_retriever {
-  mem_retriever(std::mutex& mutex,
-                std::vector<std::unique_ptr<memory>>& mem_pool,
-                std::size_t bytes)
-      : mutex_(mutex), memory_(retrieve(mem_pool, bytes)) {}
+  explicit mem_retriever(mem_pool& pool) : pool_(pool), memory_(retrieve()) {}
 
   mem_retriever(mem_retriever const&) = delete;
   mem_retriever& operator=(mem_retriever const&) = delete;
@@ -28,30 +51,38 @@ struct mem_retriever {
   mem_retriever& operator=(mem_retriever&&) = delete;
 
   ~mem_retriever() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    memory_->in_use_ = false;
     memory_->mem_.reset();
+    auto& s = pool_.shards_[mem_pool::home_shard()];
+    std::lock_guard<std::mutex> lock(s.mutex_);
+    s.free_.emplace_back(std::move(memory_));
   }
 
   mem_manager& get() { return memory_->mem_; }
 
+  bool hit() const { return hit_; }
+
 private:
-  memory* retrieve(std::vector<std::unique_ptr<memory>>& mem_pool,
-                   std::size_t bytes) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = std::find_if(begin(mem_pool), end(mem_pool),
-                           [](auto&& m) { return !m->in_use_; });
-    if (it == end(mem_pool)) {
-      mem_pool.emplace_back(std::make_unique<memory>(bytes));
-      mem_pool.back()->in_use_ = true;
-      return mem_pool.back().get();
+  std::unique_ptr<memory> retrieve() {
+    auto const home = mem_pool::home_shard();
+    for (auto i = 0U; i < mem_pool::SHARD_COUNT; ++i) {
+      auto& s = pool_.shards_[(home + i) % mem_pool::SHARD_COUNT];
+      std::lock_guard<std::mutex> lock(s.mutex_);
+      if (!s.free_.empty()) {
+        auto m = std::move(s.free_.back());
+        s.free_.pop_back();
+        ++pool_.hits_;
+        hit_ = true;
+        return m;
+      }
     }
-    it->get()->in_use_ = true;
-    return it->get();
+    ++pool_.misses_;
+    ++pool_.size_;
+    return std::make_unique<memory>(pool_.bytes_);
   }
 
-  std::mutex& mutex_;
-  memory* memory_;
+  mem_pool& pool_;
+  bool hit_{false};
+  std::unique_ptr<memory> memory_;
 };
 
 }  // namespace routing
@@ -31,7 +31,7 @@ struct pareto_dijkstra {
                   hash_map<node const*, std::vector<edge>> additional_edges,
                   LowerBounds& lower_bounds, mem_manager& label_store)
       : goal_(goal),
-        node_labels_(*label_store.get_node_labels<Label>(node_count)),
+        node_labels_(label_store, node_count),
         additional_edges_(std::move(additional_edges)),
         lower_bounds_(lower_bounds),
         label_store_(label_store),
@@ -40,7 +40,7 @@ struct pareto_dijkstra {
   void add_start_labels(std::vector<Label*> const& start_labels) {
     for (auto const& l : start_labels) {
       if (!l->is_filtered()) {
-        node_labels_[l->get_node()->id_].emplace_back(l);
+        node_labels_.add_start_label(l);
         queue_.push(l);
       }
     }
@@ -54,7 +54,7 @@ struct pareto_dijkstra {
       if ((stats_.labels_created_ > (max_labels_ / 2) && results_.empty()) ||
           stats_.labels_created_ > max_labels_) {
         stats_.max_label_quit_ = true;
-        filter_results();
+        filter_results(results_);
         return;
       }
 
@@ -107,13 +107,29 @@ struct pareto_dijkstra {
       }
     }
 
-    filter_results();
+    filter_results(results_);
   }
 
   statistics get_statistics() const { return stats_; };
 
   std::vector<Label*> const& get_results() { return results_; }
 
+  // Removes results dominated by another result (post search dominance).
+  static void filter_results(std::vector<Label*>& results) {
+    bool restart = false;
+    for (auto it = std::begin(results); it != std::end(results);
+         it = restart ? std::begin(results) : std::next(it)) {
+      restart = false;
+      std::size_t size_before = results.size();
+      utl::erase_if(results, [it](Label const* l) {
+        return l == (*it) ? false : (*it)->dominates_post_search(*l);
+      });
+      if (results.size() != size_before) {
+        restart = true;
+      }
+    }
+  }
+
 private:
   void create_new_label(Label* l, edge const& edge) {
     Label blank{};
@@ -175,25 +191,7 @@ private:
   }
 
   bool add_label_to_node(Label* new_label, node const* dest) {
-    auto& dest_labels = node_labels_[dest->id_];
-    for (auto it = dest_labels.begin(); it != dest_labels.end();) {
-      Label* o = *it;
-      if (o->dominates(*new_label)) {
-        return false;
-      }
-
-      if (new_label->dominates(*o)) {
-        it = dest_labels.erase(it);
-        o->dominated_ = true;
-      } else {
-        ++it;
-      }
-    }
-
-    // it is very important for the performance to push front here
-    // because earlier labels tend not to dominate later ones (not comparable)
-    dest_labels.insert(std::begin(dest_labels), new_label);
-    return true;
+    return node_labels_.add(new_label, dest->id_);
   }
 
   bool dominated_by_results(Label* label) {
@@ -205,23 +203,8 @@ private:
     return false;
   }
 
-  void filter_results() {
-    bool restart = false;
-    for (auto it = std::begin(results_); it != std::end(results_);
-         it = restart ? std::begin(results_) : std::next(it)) {
-      restart = false;
-      std::size_t size_before = results_.size();
-      utl::erase_if(results_, [it](Label const* l) {
-        return l == (*it) ? false : (*it)->dominates_post_search(*l);
-      });
-      if (results_.size() != size_before) {
-        restart = true;
-      }
-    }
-  }
-
   station_node const* goal_;
-  std::vector<std::vector<Label*>>& node_labels_;
+  typename Label::node_labels node_labels_;
   dial<Label*, Label::MAX_BUCKET, get_bucket> queue_;
   std::vector<Label*> equals_;
   hash_map<node const*, std::vector<edge>> additional_edges_;
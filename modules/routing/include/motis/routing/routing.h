@@ -1,15 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
-#include <mutex>
-#include <vector>
 
 #include "motis/module/module.h"
+#include "motis/routing/lower_bounds_cache.h"
 
 namespace motis {
 namespace routing {
 
-struct memory;
+struct mem_pool;
 
 struct routing : public motis::module::module {
   routing();
@@ -28,8 +28,17 @@ private:
   motis::module::msg_ptr route(motis::module::msg_ptr const&);
   motis::module::msg_ptr trip_to_connection(motis::module::msg_ptr const&);
 
-  std::mutex mem_pool_mutex_;
-  std::vector<std::unique_ptr<memory>> mem_pool_;
+  std::unique_ptr<mem_pool> mem_pool_;
+
+  // An entry holds one distance per station and per interchange graph node
+  // (stations and routes): megabytes on national timetables.
+  std::size_t lb_cache_size_{16};
+  std::unique_ptr<lower_bounds_cache> lb_cache_;
+
+  // Parallel pretrip search (opt-in), only used under light load.
+  std::size_t parallel_intervals_{1};
+  std::size_t parallel_max_active_{2};
+  std::atomic<std::size_t> active_requests_{0};
 };
 
 }  // namespace routing
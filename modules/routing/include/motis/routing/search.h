@@ -1,11 +1,20 @@
 #pragma once
 
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
+
 #include "utl/to_vec.h"
 
 #include "motis/core/common/hash_map.h"
 #include "motis/core/common/timing.h"
 #include "motis/core/schedule/schedule.h"
+#include "motis/module/context/motis_parallel_for.h"
 #include "motis/routing/lower_bounds.h"
+#include "motis/routing/mem_retriever.h"
 #include "motis/routing/output/labels_to_journey.h"
 #include "motis/routing/pareto_dijkstra.h"
 
@@ -15,6 +24,9 @@ namespace routing {
 struct search_query {
   schedule const* sched_{nullptr};
   mem_manager* mem_{nullptr};
+  lower_bounds_cache* lb_cache_{nullptr};
+  mem_pool* mem_pool_{nullptr};
+  unsigned parallel_intervals_{1U};
   node const* from_{nullptr};
   station_node const* to_{nullptr};
   time interval_begin_{0};
@@ -57,13 +69,30 @@ struct search {
       transfers_lb_graph_edges[to].emplace_back(from, ec.transfer_ ? 1 : 0);
     }
 
-    lower_bounds lbs(
-        *q.sched_,  //
-        Dir == search_dir::FWD ? q.sched_->travel_time_lower_bounds_fwd_
-                               : q.sched_->travel_time_lower_bounds_bwd_,
-        Dir == search_dir::FWD ? q.sched_->transfers_lower_bounds_fwd_
-                               : q.sched_->transfers_lower_bounds_bwd_,
-        q.to_->id_, travel_time_lb_graph_edges, transfers_lb_graph_edges);
+    auto const lb_graphs = q.sched_->lower_bounds_.get();
+    auto const& travel_time_graph = Dir == search_dir::FWD
+                                        ? lb_graphs->travel_time_fwd_
+                                        : lb_graphs->travel_time_bwd_;
+    auto const& transfers_graph = Dir == search_dir::FWD
+                                      ? lb_graphs->transfers_fwd_
+                                      : lb_graphs->transfers_bwd_;
+
+    // Query edges change the lower bounds: only cache plain station goals.
+    auto const use_lb_cache = q.lb_cache_ != nullptr && q.query_edges_.empty();
+    auto const lb_cache_key =
+        lower_bounds_cache::key{q.to_->id_, Dir, lb_graphs->version_};
+    auto const cached = use_lb_cache ? q.lb_cache_->get(lb_cache_key)
+                                     : std::nullopt;
+    auto const lb_cache_hit = cached.has_value();
+
+    lower_bounds lbs =
+        lb_cache_hit
+            ? lower_bounds(*q.sched_, travel_time_graph, transfers_graph,
+                           *cached, travel_time_lb_graph_edges,
+                           transfers_lb_graph_edges)
+            : lower_bounds(*q.sched_, travel_time_graph, transfers_graph,
+                           q.to_->id_, travel_time_lb_graph_edges,
+                           transfers_lb_graph_edges);
 
     MOTIS_START_TIMING(travel_time_lb_timing);
     lbs.travel_time_.run();
@@ -77,6 +106,11 @@ struct search {
     lbs.transfers_.run();
     MOTIS_STOP_TIMING(transfers_lb_timing);
 
+    if (use_lb_cache && !lb_cache_hit) {
+      q.lb_cache_->put(lb_cache_key,
+                       {lbs.travel_time_.share(), lbs.transfers_.share()});
+    }
+
     hash_map<node const*, std::vector<edge>> additional_edges;
     additional_edges.set_empty_key(nullptr);
     for (auto const& e : q.query_edges_) {
@@ -88,6 +122,14 @@ struct search {
                                 ? make_foot_edge(nullptr, mutable_node)
                                 : make_foot_edge(mutable_node, nullptr);
 
+    if (use_parallel_search(q)) {
+      auto res = search_parallel(q, lbs, additional_edges, start_edge);
+      res.stats_.travel_time_lb_ = MOTIS_TIMING_MS(travel_time_lb_timing);
+      res.stats_.transfers_lb_ = MOTIS_TIMING_MS(transfers_lb_timing);
+      res.stats_.lb_cache_hit_ = lb_cache_hit;
+      return res;
+    }
+
     pareto_dijkstra<Dir, Label, lower_bounds> pd(q.sched_->node_count_, q.to_,
                                                  std::move(additional_edges),
                                                  lbs, *q.mem_);
@@ -148,6 +190,7 @@ struct search {
     stats.travel_time_lb_ = MOTIS_TIMING_MS(travel_time_lb_timing);
     stats.transfers_lb_ = MOTIS_TIMING_MS(transfers_lb_timing);
     stats.pareto_dijkstra_ = MOTIS_TIMING_MS(pareto_dijkstra_timing);
+    stats.lb_cache_hit_ = lb_cache_hit;
 
     return search_result(stats,
                          utl::to_vec(pd.get_results(),
@@ -157,6 +200,98 @@ struct search {
                                      }),
                          interval_begin, interval_end);
   }
+
+  // Minimum length of a sub-interval for parallel pretrip searches.
+  static constexpr auto MIN_PARALLEL_INTERVAL = 30;
+
+  static bool use_parallel_search(search_query const& q) {
+    return q.parallel_intervals_ > 1U && q.mem_pool_ != nullptr &&
+           !q.extend_interval_earlier_ && !q.extend_interval_later_ &&
+           q.interval_end_.ts() - q.interval_begin_.ts() >=
+               2 * MIN_PARALLEL_INTERVAL;
+  }
+
+  // Searches sub-intervals of the start interval concurrently, each with its
+  // own label store. The merged results are filtered like the results of a
+  // single search over the whole interval.
+  static search_result search_parallel(
+      search_query const& q, lower_bounds& lbs,
+      hash_map<node const*, std::vector<edge>> const& additional_edges,
+      edge const& start_edge) {
+    auto const length = q.interval_end_.ts() - q.interval_begin_.ts() + 1;
+    auto const count = static_cast<int>(std::min(
+        q.parallel_intervals_,
+        static_cast<unsigned>(length / MIN_PARALLEL_INTERVAL)));
+
+    std::vector<std::unique_ptr<mem_retriever>> mems;
+    std::vector<std::pair<time, time>> intervals;
+    for (auto i = 0; i < count; ++i) {
+      mems.emplace_back(
+          std::make_unique<mem_retriever>(*q.mem_pool_));
+      intervals.emplace_back(
+          q.interval_begin_ + i * length / count,
+          q.interval_begin_ + ((i + 1) * length / count - 1));
+    }
+
+    std::vector<std::vector<Label*>> results(count);
+    std::vector<statistics> stats(count);
+    std::vector<int> indices(count);
+    std::iota(begin(indices), end(indices), 0);
+
+    using module::ctx_data;
+    MOTIS_START_TIMING(pareto_dijkstra_timing);
+    motis_parallel_for(indices, [&](int const i) {
+      auto& mem = mems[i]->get();
+      pareto_dijkstra<Dir, Label, lower_bounds> pd(
+          q.sched_->node_count_, q.to_, additional_edges, lbs, mem);
+      pd.add_start_labels(StartLabelGenerator::generate(
+          *q.sched_, mem, lbs, &start_edge, q.query_edges_,
+          intervals[i].first, intervals[i].second));
+      pd.search();
+      results[i] = pd.get_results();
+      stats[i] = pd.get_statistics();
+    });
+
+    std::vector<Label*> merged;
+    for (auto const& r : results) {
+      for (auto const& l : r) {
+        add_result(merged, l);
+      }
+    }
+    pareto_dijkstra<Dir, Label, lower_bounds>::filter_results(merged);
+    MOTIS_STOP_TIMING(pareto_dijkstra_timing);
+
+    auto s = stats.front();
+    for (auto i = 1; i < count; ++i) {
+      s.labels_created_ += stats[i].labels_created_;
+      s.labels_popped_ += stats[i].labels_popped_;
+      s.start_label_count_ += stats[i].start_label_count_;
+      s.max_label_quit_ |= stats[i].max_label_quit_;
+    }
+    s.pareto_dijkstra_ = MOTIS_TIMING_MS(pareto_dijkstra_timing);
+    s.parallel_intervals_ = count;
+
+    return search_result(s,
+                         utl::to_vec(merged,
+                                     [&q](Label* label) {
+                                       return output::labels_to_journey(
+                                           *q.sched_, label, Dir);
+                                     }),
+                         q.interval_begin_, q.interval_end_);
+  }
+
+  static void add_result(std::vector<Label*>& results, Label* l) {
+    for (auto it = begin(results); it != end(results);) {
+      if ((*it)->dominates(*l)) {
+        return;
+      } else if (l->dominates(**it)) {
+        it = results.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    results.push_back(l);
+  }
 };
 
 }  // namespace routing
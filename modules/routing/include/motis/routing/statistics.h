@@ -26,7 +26,14 @@ struct statistics {
         price_l_b_(0),
         total_calculation_time_(0),
         pareto_dijkstra_(0),
-        num_bytes_in_use_(0) {}
+        num_bytes_in_use_(0),
+        nodes_touched_(0),
+        mem_pool_hit_(false),
+        mem_pool_size_(0),
+        mem_pool_hits_(0),
+        mem_pool_misses_(0),
+        lb_cache_hit_(false),
+        parallel_intervals_(0) {}
 
   explicit statistics(int travel_time_lb) : statistics() {
     travel_time_lb_ = travel_time_lb;
@@ -48,6 +55,14 @@ struct statistics {
   int pareto_dijkstra_;
   int num_bytes_in_use_;
 
+  // label store: nodes with labels (= reset cost) and pool usage
+  std::size_t nodes_touched_;
+  bool mem_pool_hit_;
+  std::size_t mem_pool_size_, mem_pool_hits_, mem_pool_misses_;
+
+  bool lb_cache_hit_;
+  int parallel_intervals_;
+
   // friend Statistics to_fbs(statistics const& s) {
   // return Statistics(
   // s.max_label_quit_, s.labels_created_, s.start_label_count_,
@@ -84,8 +99,15 @@ struct statistics {
     add_entry("labels_popped_until_first_result",
               s.labels_popped_until_first_result_);
     // add_entry("labels_to_journey", s.labels_to_journey_);
+    add_entry("lb_cache_hit", s.lb_cache_hit_ ? 1 : 0);
     add_entry("max_label_quit", s.max_label_quit_ ? 1 : 0);
+    add_entry("mem_pool_hit", s.mem_pool_hit_ ? 1 : 0);
+    add_entry("mem_pool_hits", s.mem_pool_hits_);
+    add_entry("mem_pool_misses", s.mem_pool_misses_);
+    add_entry("mem_pool_size", s.mem_pool_size_);
+    add_entry("nodes_touched", s.nodes_touched_);
     add_entry("num_bytes_in_use", s.num_bytes_in_use_);
+    add_entry("parallel_intervals", s.parallel_intervals_);
     add_entry("pareto_dijkstra", s.pareto_dijkstra_);
     add_entry("priority_queue_max_size", s.priority_queue_max_size_);
     add_entry("start_label_count", s.start_label_count_);
@@ -1,10 +1,13 @@
 #include "motis/routing/routing.h"
 
+#include <algorithm>
+
 #include "boost/date_time/gregorian/gregorian_types.hpp"
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "boost/program_options.hpp"
 
 #include "motis/core/common/logging.h"
+#include "motis/core/common/raii.h"
 #include "motis/core/common/timing.h"
 
 #include "motis/core/schedule/schedule.h"
@@ -19,6 +22,7 @@
 #include "motis/routing/build_query.h"
 #include "motis/routing/error.h"
 #include "motis/routing/label/configs.h"
+#include "motis/routing/lower_bounds_cache.h"
 #include "motis/routing/mem_manager.h"
 #include "motis/routing/mem_retriever.h"
 #include "motis/routing/search.h"
@@ -36,11 +40,24 @@ using namespace motis::module;
 namespace motis {
 namespace routing {
 
-routing::routing() : module("Routing", "routing") {}
+routing::routing()
+    : module("Routing", "routing"),
+      mem_pool_(std::make_unique<mem_pool>(LABEL_STORE_START_SIZE)) {
+  size_t_param(lb_cache_size_, "lb_cache_size",
+               "max. number of cached per destination lower bounds (0=off), "
+               "each entry takes 4 bytes * (2 * #stations + #routes)");
+  size_t_param(parallel_intervals_, "parallel_intervals",
+               "max. number of concurrently searched pretrip sub-intervals "
+               "(0/1=off)");
+  size_t_param(parallel_max_active_, "parallel_max_active",
+               "use parallel pretrip search only if at most this many "
+               "routing requests are active");
+}
 
 routing::~routing() = default;
 
 void routing::init(motis::module::registry& reg) {
+  lb_cache_ = std::make_unique<lower_bounds_cache>(lb_cache_size_);
   reg.register_op("/routing", std::bind(&routing::route, this, p::_1));
   reg.register_op("/trip_to_connection",
                   std::bind(&routing::trip_to_connection, this, p::_1));
@@ -53,8 +70,17 @@ msg_ptr routing::route(msg_ptr const& msg) {
   auto const& sched = get_schedule();
   auto query = build_query(sched, req);
 
-  mem_retriever mem(mem_pool_mutex_, mem_pool_, LABEL_STORE_START_SIZE);
+  ++active_requests_;
+  MOTIS_FINALLY([this]() { --active_requests_; });
+
+  mem_retriever mem(*mem_pool_);
   query.mem_ = &mem.get();
+  query.lb_cache_ = lb_cache_.get();
+  query.mem_pool_ = mem_pool_.get();
+  query.parallel_intervals_ =
+      active_requests_ <= parallel_max_active_
+          ? static_cast<unsigned>(std::max(parallel_intervals_, size_t{1U}))
+          : 1U;
 
   auto res = search_dispatch(query, req->start_type(), req->search_type(),
                              req->search_dir());
@@ -63,6 +89,11 @@ msg_ptr routing::route(msg_ptr const& msg) {
   res.stats_.total_calculation_time_ = MOTIS_TIMING_MS(routing_timing);
   res.stats_.labels_created_ = query.mem_->allocations();
   res.stats_.num_bytes_in_use_ = query.mem_->get_num_bytes_in_use();
+  res.stats_.nodes_touched_ = query.mem_->touched_nodes();
+  res.stats_.mem_pool_hit_ = mem.hit();
+  res.stats_.mem_pool_size_ = mem_pool_->size_;
+  res.stats_.mem_pool_hits_ = mem_pool_->hits_;
+  res.stats_.mem_pool_misses_ = mem_pool_->misses_;
 
   message_creator fbb;
   std::vector<flatbuffers::Offset<Statistics>> stats{
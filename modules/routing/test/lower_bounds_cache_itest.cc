@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "motis/module/message.h"
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis::test;
+using namespace motis::module;
+using motis::test::schedule::simple_realtime::dataset_opt;
+
+namespace motis {
+namespace routing {
+
+// No realtime messages until the test forwards to 11:00 (delays.xml).
+struct routing_lb_cache : public motis_instance_test {
+  routing_lb_cache()
+      : motis::test::motis_instance_test(
+            dataset_opt, {"routing", "ris", "rt"},
+            {"--ris.input=test/schedule/simple_realtime/risml/delays.xml",
+             "--ris.init_time=2015-11-24T10:00:00",
+             "--routing.lb_cache_size=2"}) {}
+
+  static msg_ptr routing_request(std::string const& destination) {
+    auto const interval = Interval(unix_time(1355), unix_time(1355));
+    message_creator fbb;
+    fbb.create_and_finish(
+        MsgContent_RoutingRequest,
+        CreateRoutingRequest(
+            fbb, Start_PretripStart,
+            CreatePretripStart(
+                fbb,
+                CreateInputStation(fbb, fbb.CreateString("8000260"),
+                                   fbb.CreateString("")),
+                &interval)
+                .Union(),
+            CreateInputStation(fbb, fbb.CreateString(destination),
+                               fbb.CreateString("")),
+            SearchType_SingleCriterion, SearchDir_Forward,
+            fbb.CreateVector(std::vector<Offset<Via>>()),
+            fbb.CreateVector(std::vector<Offset<AdditionalEdgeWrapper>>()))
+            .Union(),
+        "/routing");
+    return make_msg(fbb);
+  }
+
+  static msg_ptr forward(std::time_t const time) {
+    message_creator fbb;
+    fbb.create_and_finish(MsgContent_RISForwardTimeRequest,
+                          CreateRISForwardTimeRequest(fbb, time).Union(),
+                          "/ris/forward");
+    return make_msg(fbb);
+  }
+
+  bool lb_cache_hit(std::string const& destination) {
+    auto const res = call(routing_request(destination));
+    auto const stats = motis_content(RoutingResponse, res)->statistics();
+    auto const routing_stats = stats->LookupByKey("routing");
+    if (routing_stats == nullptr) {
+      return false;
+    }
+    auto const hit = routing_stats->entries()->LookupByKey("lb_cache_hit");
+    return hit != nullptr && hit->value() != 0U;
+  }
+};
+
+TEST_F(routing_lb_cache, hit_invalidate_evict) {
+  // Koeln-Ehrenfeld
+  EXPECT_FALSE(lb_cache_hit("8000208"));
+  EXPECT_TRUE(lb_cache_hit("8000208"));
+
+  auto const version = sched().lower_bounds_.get()->version_;
+  call(forward(unix_time(1200)));
+  ASSERT_GT(sched().lower_bounds_.get()->version_, version);
+
+  // New lower bound graph version: entries of the old version are not used.
+  EXPECT_FALSE(lb_cache_hit("8000208"));
+  EXPECT_TRUE(lb_cache_hit("8000208"));
+
+  // Two more destinations (cache size 2) evict Koeln-Ehrenfeld.
+  EXPECT_FALSE(lb_cache_hit("8000105"));  // Frankfurt(Main)Hbf
+  EXPECT_FALSE(lb_cache_hit("8070003"));  // Frankfurt(M) Flughafen
+  EXPECT_TRUE(lb_cache_hit("8070003"));
+  EXPECT_FALSE(lb_cache_hit("8000208"));
+}
+
+}  // namespace routing
+}  // namespace motis
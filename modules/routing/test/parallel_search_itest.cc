@@ -0,0 +1,100 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "utl/to_vec.h"
+
+#include "motis/module/message.h"
+#include "motis/routing/build_query.h"
+#include "motis/routing/mem_retriever.h"
+#include "motis/routing/search_dispatch.h"
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis::test;
+using namespace motis::module;
+using motis::test::schedule::simple_realtime::dataset_opt;
+
+namespace motis {
+namespace routing {
+
+struct routing_parallel_search : public motis_instance_test {
+  routing_parallel_search()
+      : motis::test::motis_instance_test(dataset_opt, {"routing"}) {}
+
+  msg_ptr routing_request(std::string const& destination) const {
+    auto const interval = Interval(unix_time(800), unix_time(2000));
+    message_creator fbb;
+    fbb.create_and_finish(
+        MsgContent_RoutingRequest,
+        CreateRoutingRequest(
+            fbb, Start_PretripStart,
+            CreatePretripStart(
+                fbb,
+                CreateInputStation(fbb, fbb.CreateString("8000260"),
+                                   fbb.CreateString("")),
+                &interval)
+                .Union(),
+            CreateInputStation(fbb, fbb.CreateString(destination),
+                               fbb.CreateString("")),
+            SearchType_Default, SearchDir_Forward,
+            fbb.CreateVector(std::vector<Offset<Via>>()),
+            fbb.CreateVector(std::vector<Offset<AdditionalEdgeWrapper>>()))
+            .Union(),
+        "/routing");
+    return make_msg(fbb);
+  }
+
+  search_result search(msg_ptr const& msg, unsigned const parallel_intervals) {
+    return run([&]() {
+      auto const req = motis_content(RoutingRequest, msg);
+      auto q = build_query(sched(), req);
+      mem_retriever mem(mem_pool_);
+      q.mem_ = &mem.get();
+      q.mem_pool_ = &mem_pool_;
+      q.parallel_intervals_ = parallel_intervals;
+      return search_dispatch(q, req->start_type(), req->search_type(),
+                             req->search_dir());
+    });
+  }
+
+  mem_pool mem_pool_{16 * 1024 * 1024};
+};
+
+using journey_key =
+    std::vector<std::tuple<std::string, std::time_t, std::time_t>>;
+
+std::vector<journey_key> sorted_keys(std::vector<journey> const& journeys) {
+  auto keys = utl::to_vec(journeys, [](journey const& j) {
+    return utl::to_vec(j.stops_, [](journey::stop const& s) {
+      return std::make_tuple(s.eva_no_, s.arrival_.timestamp_,
+                             s.departure_.timestamp_);
+    });
+  });
+  std::sort(begin(keys), end(keys));
+  return keys;
+}
+
+TEST_F(routing_parallel_search, same_journeys_as_sequential) {
+  for (auto const& destination : {"8000105", "8070003", "8000208"}) {
+    auto const msg = routing_request(destination);
+    auto const sequential = search(msg, 1U);
+    auto const parallel = search(msg, 4U);
+
+    EXPECT_EQ(0, sequential.stats_.parallel_intervals_);
+    EXPECT_EQ(4, parallel.stats_.parallel_intervals_);
+    ASSERT_FALSE(sequential.journeys_.empty()) << destination;
+    EXPECT_EQ(sorted_keys(sequential.journeys_),
+              sorted_keys(parallel.journeys_))
+        << destination;
+    EXPECT_EQ(sequential.interval_begin_, parallel.interval_begin_);
+    EXPECT_EQ(sequential.interval_end_, parallel.interval_end_);
+  }
+}
+
+}  // namespace routing
+}  // namespace motis
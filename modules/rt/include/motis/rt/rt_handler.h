@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <set>
 
 #include "motis/core/schedule/schedule.h"
 
@@ -21,11 +24,26 @@ struct rt_handler {
 
 private:
   void propagate();
+  void touch(ev_key const&);
+  void touch(trip const*);
+  void schedule_lower_bounds_update();
+  void build_lower_bounds(uint64_t version);
+  void publish_lower_bounds(std::shared_ptr<lower_bound_graphs const>,
+                            std::size_t station_count, uint64_t version);
 
   schedule& sched_;
   delay_propagator propagator_;
   statistics stats_;
   std::map<schedule_event, delay_info*> cancelled_delays_;
+
+  // Stations whose outgoing connections or routes changed since the last
+  // flush. Only their lower bound graph edges are updated.
+  std::set<uint32_t> touched_stations_;
+
+  // Touched stations of all flushes whose lower bounds are not published
+  // yet. Only write operations modify it (no mutex needed).
+  std::set<uint32_t> lower_bounds_pending_;
+  uint64_t lower_bounds_version_{0U};  // of the last flush
 };
 
 }  // namespace rt
@@ -1,14 +1,19 @@
 #include "motis/rt/rt_handler.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "utl/to_vec.h"
 
 #include "parser/util.h"
 
 #include "motis/core/common/logging.h"
 #include "motis/core/common/raii.h"
+#include "motis/core/access/station_access.h"
 
 #include "motis/module/context/get_schedule.h"
 #include "motis/module/context/motis_publish.h"
+#include "motis/module/dispatcher.h"
 
 #include "motis/rt/event_resolver.h"
 #include "motis/rt/reroute.h"
@@ -72,9 +77,18 @@ msg_ptr rt_handler::update(msg_ptr const& msg) {
         }
 
         case ris::MessageUnion_AdditionMessage: {
-          auto result = additional_service_builder(s).build_additional_train(
-              reinterpret_cast<ris::AdditionMessage const*>(c));
+          auto const msg = reinterpret_cast<ris::AdditionMessage const*>(c);
+          auto result =
+              additional_service_builder(s).build_additional_train(msg);
           stats_.count_additional(result);
+          if (result == additional_service_builder::status::OK) {
+            for (auto const& ev : *msg->events()) {
+              auto const st = find_station(s, ev->base()->station_id()->str());
+              if (st != nullptr) {
+                touched_stations_.insert(st->index_);
+              }
+            }
+          }
           break;
         }
 
@@ -88,6 +102,7 @@ msg_ptr rt_handler::update(msg_ptr const& msg) {
           }
 
           seperate_trip(s, trp);
+          touch(trp);
 
           auto const resolved = resolve_events(
               stats_, s, msg->trip_id(),
@@ -117,6 +132,7 @@ msg_ptr rt_handler::update(msg_ptr const& msg) {
           // stats_.count_reroute(result.first);
 
           if (result.first == reroute_result::OK) {
+            touch(result.second);
             for (auto const& e : *result.second->edges_) {
               propagator_.add_delay(ev_key{e, 0, event_type::DEP});
               propagator_.add_delay(ev_key{e, 0, event_type::ARR});
@@ -155,6 +171,7 @@ void rt_handler::propagate() {
     if (!edge_fit || !trip_fit) {
       auto const trp = sched_.merged_trips_[k.lcon()->trips_]->front();
       seperate_trip(sched_, trp);
+      touch(trp);
 
       if (!trip_fit) {
         trips_to_correct.insert(trp);
@@ -165,6 +182,7 @@ void rt_handler::propagate() {
         k.ev_type_ == event_type::DEP ? k.lcon()->d_time_ : k.lcon()->a_time_;
     const_cast<time&>(event_time) = t;  // NOLINT
 
+    touch(k);
     shifted_nodes.add(di);
   }
 
@@ -172,6 +190,7 @@ void rt_handler::propagate() {
     assert(trp->lcon_idx_ == 0 &&
            trp->edges_->front()->m_.route_edge_.conns_.size() == 1);
     for (auto const& di : trip_corrector(sched_, trp).fix_times()) {
+      touch(di->get_ev_key());
       shifted_nodes.add(di);
     }
   }
@@ -195,52 +214,109 @@ msg_ptr rt_handler::flush(msg_ptr const&) {
 
   propagate();
 
+  // Only the route edges of stations changed by this flush are checked.
+  verify(std::all_of(
+             begin(touched_stations_), end(touched_stations_),
+             [this](uint32_t const station_idx) {
+               auto const& sn = sched_.station_nodes_[station_idx];
+               for (auto const& se : sn->edges_) {
+                 if (se.to_->type() != node_type::ROUTE_NODE) {
+                   continue;
+                 }
+
+                 for (auto const& re : se.to_->edges_) {
+                   if (re.empty()) {
+                     continue;
+                   }
+
+                   auto const& lcons = re.m_.route_edge_.conns_;
+                   auto const is_sorted_dep = std::is_sorted(
+                       begin(lcons), end(lcons),
+                       [](light_connection const& a,
+                          light_connection const& b) {
+                         return a.d_time_ < b.d_time_;
+                       });
+                   auto const is_sorted_arr = std::is_sorted(
+                       begin(lcons), end(lcons),
+                       [](light_connection const& a,
+                          light_connection const& b) {
+                         return a.a_time_ < b.a_time_;
+                       });
+                   if (!is_sorted_dep || !is_sorted_arr) {
+                     return false;
+                   }
+                 }
+               }
+               return true;
+             }),
+         "graph consistency after rt update");
+
+  schedule_lower_bounds_update();
+
+  return nullptr;
+}
+
+void rt_handler::touch(ev_key const& k) {
+  touched_stations_.insert(k.route_edge_->from_->get_station()->id_);
+  touched_stations_.insert(k.route_edge_->to_->get_station()->id_);
+}
+
+void rt_handler::touch(trip const* trp) {
+  for (auto const& e : *trp->edges_) {
+    touched_stations_.insert(e->from_->get_station()->id_);
+    touched_stations_.insert(e->to_->get_station()->id_);
+  }
+}
+
+// The next lower bound graphs are built in a read operation (concurrently
+// with routing queries) and published by a short write operation that only
+// swaps the pointer. Queries running in between still use the previous
+// version. Routes created since then get a lower bound of zero.
+void rt_handler::schedule_lower_bounds_update() {
+  lower_bounds_pending_.insert(begin(touched_stations_),
+                               end(touched_stations_));
+  touched_stations_.clear();
+
+  auto const version = ++lower_bounds_version_;
+  auto const d = module::current_data().dispatcher_;
+  d->enqueue_read(module::ctx_data(module::access_t::READ, d, &sched_),
+                  [this, version]() { build_lower_bounds(version); },
+                  ctx::op_id(CTX_LOCATION));
+}
+
+void rt_handler::build_lower_bounds(uint64_t const version) {
+  if (version != lower_bounds_version_) {
+    return;  // superseded by a later flush (which covers its stations)
+  }
+
   manual_timer lb_update("lower bound graph update");
-  sched_.transfers_lower_bounds_fwd_ = build_interchange_graph(
-      sched_.station_nodes_, sched_.route_count_, search_dir::FWD);
-  sched_.transfers_lower_bounds_bwd_ = build_interchange_graph(
-      sched_.station_nodes_, sched_.route_count_, search_dir::BWD);
-  sched_.travel_time_lower_bounds_fwd_ =
-      build_station_graph(sched_.station_nodes_, search_dir::FWD);
-  sched_.travel_time_lower_bounds_bwd_ =
-      build_station_graph(sched_.station_nodes_, search_dir::BWD);
+  auto const touched = std::vector<uint32_t>(begin(lower_bounds_pending_),
+                                             end(lower_bounds_pending_));
+  auto next = update_lower_bound_graphs(*sched_.lower_bounds_.get(),
+                                        sched_.station_nodes_,
+                                        sched_.route_count_, touched, version);
   lb_update.stop_and_print();
 
-  verify(
-      [this] {
-        for (auto const& sn : sched_.station_nodes_) {
-          for (auto const& se : sn->edges_) {
-            if (se.to_->type() != node_type::ROUTE_NODE) {
-              continue;
-            }
-
-            for (auto const& re : se.to_->edges_) {
-              if (re.empty()) {
-                continue;
-              }
+  auto const d = module::current_data().dispatcher_;
+  d->enqueue_write(
+      module::ctx_data(module::access_t::WRITE, d, &sched_),
+      [this, next = std::move(next), count = touched.size(), version]() {
+        publish_lower_bounds(next, count, version);
+      },
+      ctx::op_id(CTX_LOCATION));
+}
 
-              auto const& lcons = re.m_.route_edge_.conns_;
-              auto const is_sorted_dep = std::is_sorted(
-                  begin(lcons), end(lcons),
-                  [](light_connection const& a, light_connection const& b) {
-                    return a.d_time_ < b.d_time_;
-                  });
-              auto const is_sorted_arr = std::is_sorted(
-                  begin(lcons), end(lcons),
-                  [](light_connection const& a, light_connection const& b) {
-                    return a.a_time_ < b.a_time_;
-                  });
-              if (!is_sorted_dep || !is_sorted_arr) {
-                return false;
-              }
-            }
-          }
-        }
-        return true;
-      }(),
-      "graph consistency after rt update");
+void rt_handler::publish_lower_bounds(
+    std::shared_ptr<lower_bound_graphs const> next,
+    std::size_t const station_count, uint64_t const version) {
+  if (version != lower_bounds_version_) {
+    return;  // built before a later flush: its build covers these stations
+  }
 
-  return nullptr;
+  sched_.lower_bounds_.publish(std::move(next));
+  lower_bounds_pending_.clear();
+  LOG(info) << "lower bound graphs updated for " << station_count
+            << " stations";
 }
 
 }  // namespace rt
@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include "utl/to_vec.h"
+
+#include "motis/core/schedule/constant_graph.h"
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/schedule/invalid_realtime.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace motis;
+using namespace motis::test;
+using namespace motis::test::schedule;
+
+namespace {
+
+std::vector<std::tuple<uint32_t, uint16_t>> sorted_row(
+    constant_graph const& g, std::size_t const i) {
+  auto row = utl::to_vec(g[i], [](simple_edge const& e) {
+    return std::make_tuple(e.to_, e.cost_);
+  });
+  std::sort(begin(row), end(row));
+  return row;
+}
+
+// Station graphs are updated exactly. Interchange graphs keep obsolete
+// edges (still admissible), but contain every edge of a rebuild.
+void expect_same_as_rebuild(schedule const& sched) {
+  auto const incremental = sched.lower_bounds_.get();
+  ASSERT_NE(0U, incremental->version_);
+
+  auto const rebuild = build_lower_bound_graphs(sched.station_nodes_,
+                                                sched.route_count_, 0U);
+
+  auto const expect_equal = [](constant_graph const& expected,
+                               constant_graph const& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (auto i = 0U; i < expected.size(); ++i) {
+      EXPECT_EQ(sorted_row(expected, i), sorted_row(actual, i)) << i;
+    }
+  };
+  expect_equal(rebuild->travel_time_fwd_, incremental->travel_time_fwd_);
+  expect_equal(rebuild->travel_time_bwd_, incremental->travel_time_bwd_);
+
+  auto const expect_subset = [](constant_graph const& expected,
+                                constant_graph const& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (auto i = 0U; i < expected.size(); ++i) {
+      auto const e = sorted_row(expected, i);
+      auto const a = sorted_row(actual, i);
+      EXPECT_TRUE(std::includes(begin(a), end(a), begin(e), end(e))) << i;
+    }
+  };
+  expect_subset(rebuild->transfers_fwd_, incremental->transfers_fwd_);
+  expect_subset(rebuild->transfers_bwd_, incremental->transfers_bwd_);
+}
+
+}  // namespace
+
+struct rt_lower_bounds_delay_test : public motis_instance_test {
+  rt_lower_bounds_delay_test()
+      : motis::test::motis_instance_test(
+            simple_realtime::dataset_opt, {"ris", "rt"},
+            {"--ris.input=test/schedule/simple_realtime/risml/delays.xml",
+             "--ris.init_time=2015-11-24T11:00:00"}) {}
+};
+
+TEST_F(rt_lower_bounds_delay_test, incremental_equals_rebuild) {
+  expect_same_as_rebuild(sched());
+}
+
+struct rt_lower_bounds_reroute_test : public motis_instance_test {
+  rt_lower_bounds_reroute_test()
+      : motis::test::motis_instance_test(
+            no_rule_services(invalid_realtime::dataset_opt), {"ris", "rt"},
+            {"--ris.input=test/schedule/invalid_realtime/risml/reroute.xml",
+             "--ris.init_time=2015-11-24T10:10:00"}) {}
+
+  static loader::loader_options no_rule_services(loader::loader_options opt) {
+    opt.apply_rules_ = false;
+    return opt;
+  }
+};
+
+TEST_F(rt_lower_bounds_reroute_test, incremental_equals_rebuild) {
+  expect_same_as_rebuild(sched());
+}